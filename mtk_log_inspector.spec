@@ -15,6 +15,8 @@ block_cipher = None
 # Collect all data files from docs directory
 docs_datas = [
     ('docs/prompt.md', 'docs'),
+    ('docs/prompt_compact.md', 'docs'),
+    ('docs/prompt_reduce.md', 'docs'),
 ]
 
 a = Analysis(
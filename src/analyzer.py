@@ -2,9 +2,38 @@
 分析和片段合并工具。
 """
 
-from typing import List, Dict, Any, Optional
+from typing import Callable, List, Dict, Any, Optional, Tuple
 from datetime import datetime
 
+from .provenance import EvidenceIndex, LineProvenance
+
+
+def failed_window_result(
+    window_idx: int,
+    error: str,
+    next_actions: Optional[List[str]] = None
+) -> Dict[str, Any]:
+    """Build the placeholder result recorded when a window could not be analyzed.
+    构建窗口分析失败时记录的占位结果。
+    
+    Args:
+        window_idx: Window index (窗口索引)
+        error: Error description (错误描述)
+        next_actions: Suggested actions (建议的后续操作)
+        
+    Returns:
+        UNKNOWN result dict with zero confidence (置信度为0的UNKNOWN结果字典)
+    """
+    return {
+        "window_idx": window_idx,
+        "final_state": "UNKNOWN",
+        "confidence": 0.0,
+        "reason": f"Analysis failed: {error}",
+        "evidence": [],
+        "next_actions": next_actions if next_actions is not None else ["Retry analysis"],
+        "error": error
+    }
+
 
 class AudioSegment:
     """Represents a merged audio state segment.
@@ -43,6 +72,12 @@ class AudioSegment:
         self.confidence_avg = confidence_avg
         self.evidence = evidence
         self.reasons = reasons
+        # Filled in by WindowAnalyzer.locate_segments (由WindowAnalyzer.locate_segments填写)
+        self.start_time: Optional[str] = None
+        self.end_time: Optional[str] = None
+        self.duration_s: Optional[float] = None
+        self.source: Optional[Dict[str, Any]] = None
+        self.evidence_positions: List[Optional[Dict[str, Any]]] = []
 
     def to_dict(self) -> Dict[str, Any]:
         """Convert segment to dictionary.
@@ -55,7 +90,12 @@ class AudioSegment:
             "window_count": self.end_window - self.start_window + 1,
             "confidence_avg": round(self.confidence_avg, 2),
             "evidence": self.evidence[:5],  # Limit to 5 evidence items (限制为5个证据项)
-            "reasons": self.reasons
+            "reasons": self.reasons,
+            "start_time": self.start_time,
+            "end_time": self.end_time,
+            "duration_s": self.duration_s,
+            "source": self.source,
+            "evidence_positions": self.evidence_positions[:5]
         }
 
 
@@ -64,7 +104,11 @@ class WindowAnalyzer:
     分析窗口并合并具有相同状态的连续窗口。
     """
 
-    def merge_windows(self, window_results: List[Dict[str, Any]]) -> List[AudioSegment]:
+    def merge_windows(
+        self,
+        window_results: List[Dict[str, Any]],
+        split_on_gaps: bool = False
+    ) -> List[AudioSegment]:
         """Merge consecutive windows with the same final_state into segments.
         将具有相同最终状态的连续窗口合并为片段。
         
@@ -73,6 +117,9 @@ class WindowAnalyzer:
                           每个窗口的分析结果列表
                 Each result should have: window_idx, final_state, confidence, reason, evidence
                 每个结果应包含: window_idx, final_state, confidence, reason, evidence
+            split_on_gaps: Start a new segment where window indices are not
+                          consecutive, so segments never span unanalyzed windows
+                          窗口索引不连续时开始新片段，使片段不跨越未分析的窗口
                 
         Returns:
             List of merged AudioSegment objects
@@ -101,7 +148,9 @@ class WindowAnalyzer:
                     "evidence": list(evidence),
                     "reasons": [reason]
                 }
-            elif current_segment["state"] == state:
+            elif current_segment["state"] == state and not (
+                split_on_gaps and window_idx != current_segment["end_window"] + 1
+            ):
                 # Extend current segment (扩展当前片段)
                 current_segment["end_window"] = window_idx
                 current_segment["confidences"].append(confidence)
@@ -126,6 +175,16 @@ class WindowAnalyzer:
         
         return segments
 
+    def online_merger(
+        self,
+        on_segment: Optional[Callable[[AudioSegment], None]] = None,
+        split_on_gaps: bool = False
+    ) -> "OnlineMerger":
+        """Incremental counterpart of merge_windows for results arriving out of order.
+        merge_windows的增量版本，用于乱序到达的结果。
+        """
+        return OnlineMerger(self, on_segment, split_on_gaps)
+
     def _create_segment(self, segment_data: Dict[str, Any]) -> AudioSegment:
         """Create AudioSegment from accumulated data.
         从累积的数据创建AudioSegment。
@@ -152,6 +211,81 @@ class WindowAnalyzer:
             reasons=segment_data["reasons"]
         )
 
+    def locate_segments(
+        self,
+        segments: List[AudioSegment],
+        spans: List[Tuple[int, int, int]],
+        provenance: LineProvenance,
+        evidence_index: Optional[EvidenceIndex] = None
+    ):
+        """Give segments their time range, source lines and evidence positions.
+        为片段填写时间范围、源行和证据位置。
+        
+        A segment covers the lines from the first line of its first window to
+        the last line of its last window.
+        片段覆盖从其第一个窗口的第一行到最后一个窗口的最后一行。
+        
+        Args:
+            segments: Segments, updated in place (片段，原地更新)
+            spans: (window_idx, start_line, end_line_exclusive) from LogChunker.window_spans
+                  来自LogChunker.window_spans的 (窗口索引, 起始行, 结束行（不包含）)
+            provenance: Positions of the filtered lines (过滤后各行的位置)
+            evidence_index: Resolves evidence lines to file positions (将证据行解析为文件位置)
+        """
+        bounds = {idx: (start, end) for idx, start, end in spans}
+        for segment in segments:
+            if segment.start_window not in bounds or segment.end_window not in bounds:
+                continue
+            first = bounds[segment.start_window][0]
+            last = bounds[segment.end_window][1] - 1
+            segment.start_time = provenance.timestamp(first)
+            segment.end_time = provenance.timestamp(last)
+            segment.duration_s = provenance.elapsed_s(first, last)
+            segment.source = {
+                "file": provenance.files[provenance.file_ids[first]],
+                "first_line": provenance.line_numbers[first],
+                "last_line": provenance.line_numbers[last],
+                "byte_offset": provenance.offsets[first]
+            }
+            if evidence_index is not None:
+                segment.evidence_positions = [evidence_index.resolve(item) for item in segment.evidence]
+
+    def cross_check(
+        self,
+        window_results: List[Dict[str, Any]],
+        engine_states: Dict[int, str]
+    ) -> Dict[str, Any]:
+        """Compare window results with the rule-based state machine.
+        将窗口结果与基于规则的状态机进行比较。
+        
+        Each result gains an ``engine_state`` field. Windows where either side is
+        UNKNOWN are not compared.
+        每个结果增加 ``engine_state`` 字段。任一方为UNKNOWN的窗口不参与比较。
+        
+        Args:
+            window_results: Window results, annotated in place (窗口结果，原地标注)
+            engine_states: window_idx -> engine state (窗口索引 -> 引擎状态)
+            
+        Returns:
+            Summary with compared/agreeing counts and disagreeing window indices
+            包含比较数、一致数和不一致窗口索引的摘要
+        """
+        compared = 0
+        disagreements = []
+        for result in window_results:
+            engine_state = engine_states.get(result["window_idx"], "UNKNOWN")
+            result["engine_state"] = engine_state
+            if engine_state == "UNKNOWN" or result["final_state"] == "UNKNOWN":
+                continue
+            compared += 1
+            if engine_state != result["final_state"]:
+                disagreements.append(result["window_idx"])
+        return {
+            "compared": compared,
+            "agreements": compared - len(disagreements),
+            "disagreements": disagreements
+        }
+
     def generate_report(
         self,
         segments: List[AudioSegment],
@@ -172,15 +306,27 @@ class WindowAnalyzer:
         """
         return {
             "metadata": metadata,
-            "summary": {
-                "total_windows": len(window_results),
-                "total_segments": len(segments),
-                "states_distribution": self._count_states(segments)
-            },
+            "summary": self.report_summary(segments, window_results),
             "window_results": window_results,
             "merged_segments": [seg.to_dict() for seg in segments]
         }
 
+    def report_summary(
+        self,
+        segments: List[AudioSegment],
+        window_results: List[Dict[str, Any]]
+    ) -> Dict[str, Any]:
+        """Summary section shared by the JSON and JSONL reports.
+        JSON报告和JSONL报告共用的摘要部分。
+        """
+        return {
+            "total_windows": len(window_results),
+            "total_segments": len(segments),
+            "decided_locally": sum(1 for r in window_results if r.get("decided_by") == "heuristic"),
+            "inferred_windows": sum(1 for r in window_results if r.get("inferred")),
+            "states_distribution": self._count_states(segments)
+        }
+
     def _count_states(self, segments: List[AudioSegment]) -> Dict[str, int]:
         """Count segments by state.
         按状态统计片段数量。
@@ -193,7 +339,9 @@ class WindowAnalyzer:
     def generate_markdown_report(
         self,
         segments: List[AudioSegment],
-        metadata: Dict[str, Any]
+        metadata: Dict[str, Any],
+        diagnosis: Optional[Dict[str, Any]] = None,
+        timeline: Optional[Dict[str, Any]] = None
     ) -> str:
         """Generate markdown summary report.
         生成Markdown格式的摘要报告。
@@ -201,6 +349,10 @@ class WindowAnalyzer:
         Args:
             segments: List of merged segments (合并后的片段列表)
             metadata: Analysis metadata (分析元数据)
+            diagnosis: Whole-log diagnosis from summarize.HierarchicalSummarizer
+                      来自summarize.HierarchicalSummarizer的整份日志诊断
+            timeline: Line-level timeline from timeline.line_timeline
+                     来自timeline.line_timeline的行级时间线
             
         Returns:
             Markdown-formatted report string (Markdown格式的报告字符串)
@@ -212,8 +364,103 @@ class WindowAnalyzer:
         lines.append(f"**Log File:** {metadata.get('log_file', 'N/A')}")
         lines.append(f"**Total Windows:** {metadata.get('total_windows', 0)}")
         lines.append(f"**Total Segments:** {len(segments)}")
+        if metadata.get("locally_decided_windows"):
+            lines.append(f"**Decided Locally:** {len(metadata['locally_decided_windows'])} windows "
+                        f"(heuristic, threshold {metadata.get('prefilter_threshold')})")
+        if metadata.get("dedup"):
+            lines.append(f"**Reused (Near-Duplicate):** {metadata['dedup']['calls_avoided']} windows "
+                        f"(similarity >= {metadata['dedup']['threshold']})")
         lines.append("")
         
+        if metadata.get("tier_stats"):
+            lines.append("## Model Tiers")
+            lines.append("")
+            lines.append("| Tier | Model | Calls | Failures | p50 (s) | p95 (s) | Tokens |")
+            lines.append("|------|-------|-------|----------|---------|---------|--------|")
+            for tier, stats in enumerate(metadata["tier_stats"]):
+                lines.append(f"| {tier} | {stats['model']} | {stats['calls']} | {stats['failures']} | "
+                            f"{stats['latency_s']['p50']:.2f} | {stats['latency_s']['p95']:.2f} | "
+                            f"{stats['total_tokens']} |")
+            lines.append("")
+        
+        usage = metadata.get("usage")
+        if usage and usage.get("calls"):
+            latency = usage["latency_s"]
+            lines.append("## Usage and Cost")
+            lines.append("")
+            estimated = f" ({usage['estimated_usage_calls']} estimated)" if usage.get("estimated_usage_calls") else ""
+            lines.append(f"**Calls:** {usage['calls']}{estimated}, {usage['retries']} retries")
+            lines.append(f"**Tokens:** {usage['prompt_tokens']:,} prompt "
+                        f"({usage['cached_tokens']:,} cached) + {usage['completion_tokens']:,} completion "
+                        f"= {usage['total_tokens']:,}")
+            lines.append(f"**Latency:** p50 {latency['p50']:.2f}s, p95 {latency['p95']:.2f}s, "
+                        f"max {latency['max']:.2f}s")
+            lines.append(f"**Estimated Cost:** ¥{usage['cost_cny']:.4f}")
+            lines.append("")
+            lines.append("| Model | Calls | Prompt Tokens | Completion Tokens | Cost (¥) |")
+            lines.append("|-------|-------|---------------|-------------------|----------|")
+            for model, stats in usage["by_model"].items():
+                lines.append(f"| {model} | {stats['calls']} | {stats['prompt_tokens']:,} | "
+                            f"{stats['completion_tokens']:,} | {stats['cost_cny']:.4f} |")
+            lines.append("")
+        
+        if diagnosis:
+            lines.append("## Whole-Log Diagnosis")
+            lines.append("")
+            lines.append(f"**Final State:** {diagnosis['final_state']} "
+                        f"(confidence: {diagnosis['confidence']:.2f})")
+            lines.append("")
+            lines.append(diagnosis["summary"])
+            lines.append("")
+            if diagnosis.get("transitions"):
+                lines.append("**Transitions:**")
+                for t in diagnosis["transitions"]:
+                    cause = f" — {t['cause']}" if t.get("cause") else ""
+                    lines.append(f"- Window {t.get('window', '?')}: {t.get('from', '?')} → {t.get('to', '?')}{cause}")
+                lines.append("")
+            if diagnosis.get("issues"):
+                lines.append("**Issues:**")
+                for issue in diagnosis["issues"]:
+                    lines.append(f"- {issue}")
+                lines.append("")
+        
+        gaps = (metadata.get("budget") or {}).get("unanalyzed_gaps")
+        if gaps:
+            lines.append("## Unanalyzed Gaps")
+            lines.append("")
+            lines.append(f"Budget reached; {sum(g['window_count'] for g in gaps)} windows were not analyzed:")
+            lines.append("")
+            for gap in gaps:
+                lines.append(f"- Windows {gap['start_window']} to {gap['end_window']} "
+                            f"({gap['window_count']} windows)")
+            lines.append("")
+        
+        if timeline and timeline["entries"]:
+            lines.append("## State Timeline")
+            lines.append("")
+            # Source line numbers match the evidence prefixes; without provenance
+            # only indices into the filtered lines are known
+            # 源行号与证据前缀一致；没有来源信息时只知道过滤后行的索引
+            source = timeline["entries"][0].get("source_start_line") is not None
+            if timeline["transitions"]:
+                lines.append("**Transitions:**")
+                for t in timeline["transitions"]:
+                    line = f"line {t['source_line']}" if source else f"filtered line {t['line']}"
+                    at = f"`{t['time']}` ({line})" if t.get("time") else line[0].upper() + line[1:]
+                    lines.append(f"- {at}: {t['from']} → {t['to']}")
+                lines.append("")
+            lines.append(f"| State | {'Lines' if source else 'Filtered Lines'} | From | To | Confidence | Agreement |")
+            lines.append("|-------|-------|------|----|------------|-----------|")
+            for entry in timeline["entries"]:
+                first, last = (
+                    (entry["source_start_line"], entry["source_end_line"]) if source
+                    else (entry["start_line"], entry["end_line"])
+                )
+                lines.append(f"| {entry['state']} | {first}-{last} | "
+                            f"{entry['start_time'] or '-'} | {entry['end_time'] or '-'} | "
+                            f"{entry['confidence']:.2f} | {entry['agreement']:.2f} |")
+            lines.append("")
+        
         lines.append("## Segments Summary")
         lines.append("")
         
@@ -221,14 +468,179 @@ class WindowAnalyzer:
             lines.append(f"### Segment {i}: {segment.state}")
             lines.append(f"- **Windows:** {segment.start_window} to {segment.end_window} "
                         f"({segment.end_window - segment.start_window + 1} windows)")
+            if segment.start_time:
+                duration = f" ({segment.duration_s:g}s)" if segment.duration_s is not None else ""
+                lines.append(f"- **Time:** {segment.start_time} to {segment.end_time}{duration}")
+            if segment.source:
+                lines.append(f"- **Source Lines:** {segment.source['first_line']} to "
+                            f"{segment.source['last_line']} of {segment.source['file']}")
             lines.append(f"- **Average Confidence:** {segment.confidence_avg:.2f}")
             lines.append("")
             
             lines.append("**Key Evidence (up to 5 lines):**")
             lines.append("```")
-            for evidence_line in segment.evidence[:5]:
-                lines.append(evidence_line)
+            positions = segment.evidence_positions
+            for i, evidence_line in enumerate(segment.evidence[:5]):
+                # Prefix the source line number like grep -n (像grep -n一样加上源行号前缀)
+                position = positions[i] if i < len(positions) else None
+                lines.append(f"{position['line_number']}:{evidence_line}" if position else evidence_line)
             lines.append("```")
             lines.append("")
         
         return "\n".join(lines)
+
+
+class OnlineMerger:
+    """Merges window results into segments as they arrive, in any order.
+    按任意顺序接收窗口结果并随到随合并为片段。
+    
+    A result waits in the reorder buffer until every lower window index has
+    arrived or been skipped, then goes through the same rule as merge_windows.
+    A segment is emitted as soon as the next released window ends it. The open
+    segment keeps a running confidence sum and count and only the first
+    EVIDENCE_LIMIT distinct evidence lines and reasons, so its size does not
+    grow with its length; emitted segments are kept only when no
+    ``on_segment`` callback takes them. The buffer holds every result that
+    arrived ahead of a window still in flight; the producer bounds it, e.g.
+    Pipeline's ``reorder_limit``, and ``max_pending`` records its peak.
+    结果在重排缓冲区中等待，直到所有更小的窗口索引都已到达或被跳过，然后按与merge_windows相同的规则处理。
+    下一个释放的窗口结束某片段时，该片段立即输出。未结束的片段保存置信度的累计和与计数，
+    并只保留前EVIDENCE_LIMIT条不同的证据和原因，因此其大小不随长度增长；仅当没有 ``on_segment`` 回调接收时才保留已输出的片段。
+    缓冲区保存所有先于仍在处理中的窗口到达的结果；由生产者限制其大小（例如Pipeline的 ``reorder_limit``），
+    ``max_pending`` 记录其峰值。
+    """
+
+    # Evidence lines and reasons kept per segment; to_dict reports five evidence lines
+    # 每个片段保留的证据行数和原因数；to_dict报告五条证据
+    EVIDENCE_LIMIT = 5
+
+    def __init__(
+        self,
+        analyzer: WindowAnalyzer,
+        on_segment: Optional[Callable[[AudioSegment], None]] = None,
+        split_on_gaps: bool = False,
+        start: int = 0
+    ):
+        """Initialize the merger.
+        初始化合并器。
+        
+        Args:
+            analyzer: Builds the segments (用于构建片段)
+            on_segment: Called with each segment once it is final; segments are
+                       then not kept by the merger
+                       片段确定后以其调用；此时合并器不再保留片段
+            split_on_gaps: Same as merge_windows (与merge_windows相同)
+            start: First window index (第一个窗口索引)
+        """
+        self.analyzer = analyzer
+        self.on_segment = on_segment
+        self.split_on_gaps = split_on_gaps
+        self.next_idx = start
+        self.pending: Dict[int, Optional[Dict[str, Any]]] = {}
+        self.max_pending = 0
+        self.segments: List[AudioSegment] = []
+        self._current: Optional[Dict[str, Any]] = None
+        self._emitted: List[AudioSegment] = []
+
+    def add(self, result: Dict[str, Any]) -> List[AudioSegment]:
+        """Accept one window result.
+        接收一个窗口结果。
+        
+        Returns:
+            Segments this result made final (该结果使之确定的片段)
+            
+        Raises:
+            ValueError: The window was already added or skipped (窗口已添加或已跳过)
+        """
+        window_idx = result["window_idx"]
+        if window_idx < self.next_idx or window_idx in self.pending:
+            raise ValueError(f"Window {window_idx} was already merged")
+        self.pending[window_idx] = result
+        self.max_pending = max(self.max_pending, len(self.pending))
+        return self._release()
+
+    def skip(self, window_idx: int) -> List[AudioSegment]:
+        """Mark a window that will never arrive, e.g. left unanalyzed.
+        标记永远不会到达的窗口，例如未分析的窗口。
+        """
+        if window_idx < self.next_idx or window_idx in self.pending:
+            raise ValueError(f"Window {window_idx} was already merged")
+        self.pending[window_idx] = None
+        return self._release()
+
+    def finish(self) -> List[AudioSegment]:
+        """Release buffered results past missing windows and close the last segment.
+        越过缺失的窗口释放缓冲的结果，并结束最后一个片段。
+        
+        Returns:
+            Without ``on_segment``, all segments, equal to merge_windows over the
+            sorted results (evidence capped); with it, the segments this call emitted
+            没有 ``on_segment`` 时返回全部片段，与对排序后的结果调用merge_windows相同（证据有上限）；
+            有回调时返回本次调用输出的片段
+        """
+        self._emitted = []
+        for window_idx in sorted(self.pending):
+            result = self.pending.pop(window_idx)
+            if result is not None:
+                self._merge(result)
+            self.next_idx = window_idx + 1
+        if self._current is not None:
+            self._emit(self._current)
+            self._current = None
+        return self.segments if self.on_segment is None else self._emitted
+
+    def _release(self) -> List[AudioSegment]:
+        self._emitted = []
+        while self.next_idx in self.pending:
+            result = self.pending.pop(self.next_idx)
+            self.next_idx += 1
+            if result is not None:
+                self._merge(result)
+        return self._emitted
+
+    def _keep(self, kept: List[str], items: List[str]):
+        for item in items:
+            if len(kept) >= self.EVIDENCE_LIMIT:
+                break
+            if item not in kept:
+                kept.append(item)
+
+    def _merge(self, result: Dict[str, Any]):
+        current = self._current
+        window_idx = result["window_idx"]
+        if current is not None and current["state"] == result["final_state"] and not (
+            self.split_on_gaps and window_idx != current["end_window"] + 1
+        ):
+            current["end_window"] = window_idx
+            current["confidence_sum"] += result["confidence"]
+            current["confidence_count"] += 1
+            self._keep(current["evidence"], result.get("evidence", []))
+            self._keep(current["reasons"], [result["reason"]])
+            return
+        if current is not None:
+            self._emit(current)
+        self._current = {
+            "state": result["final_state"],
+            "start_window": window_idx,
+            "end_window": window_idx,
+            "confidence_sum": result["confidence"],
+            "confidence_count": 1,
+            "evidence": [],
+            "reasons": [result["reason"]]
+        }
+        self._keep(self._current["evidence"], result.get("evidence", []))
+
+    def _emit(self, segment_data: Dict[str, Any]):
+        segment = AudioSegment(
+            state=segment_data["state"],
+            start_window=segment_data["start_window"],
+            end_window=segment_data["end_window"],
+            confidence_avg=segment_data["confidence_sum"] / segment_data["confidence_count"],
+            evidence=segment_data["evidence"],
+            reasons=segment_data["reasons"]
+        )
+        self._emitted.append(segment)
+        if self.on_segment:
+            self.on_segment(segment)
+        else:
+            self.segments.append(segment)
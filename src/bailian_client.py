@@ -4,9 +4,161 @@
 
 import os
 import json
-from typing import Dict, Any, Optional
+import random
+import threading
+import time
+import uuid
+from datetime import timedelta
+from typing import Callable, Dict, Any, List, Optional, Tuple
 import requests
 
+from .pricing import estimate_cost
+from .salience import SpendMeter
+from .compact import STATE_CODES, expand_compact_result, expand_key, number_lines
+from .serializer import serialize_window
+from .tracing import NULL_TRACER, Tracer
+from .stream_parser import IncrementalJSONParser
+from .tokens import estimate_tokens, estimate_lines_tokens, MESSAGE_OVERHEAD_TOKENS
+
+
+# Valid audio states returned by the model (模型返回的有效音频状态)
+VALID_STATES = ["PLAYING", "MUTED", "UNKNOWN"]
+
+# Fields every analysis result must contain (每个分析结果必须包含的字段)
+REQUIRED_FIELDS = ["final_state", "confidence", "reason", "evidence", "next_actions"]
+
+
+# Fields WindowAnalyzer.merge_windows needs; early-stop streaming cancels once they arrive
+# WindowAnalyzer.merge_windows所需字段；提前停止模式在收到这些字段后取消生成
+MERGE_FIELDS = ["final_state", "confidence", "reason"]
+
+# Output tokens reserved for each window's entry in a packed response
+# 打包响应中为每个窗口结果预留的输出token数
+PACKED_OUTPUT_TOKENS_PER_WINDOW = 300
+
+# Instructions prepended to a packed multi-window request (打包多窗口请求的前置说明)
+PACKED_INSTRUCTIONS = (
+    "Analyze each of the {count} log windows below independently.\n"
+    "Respond with a JSON object of the form {{\"results\": [...]}} where \"results\" is an "
+    "array with exactly one entry per window, in the same order. Each entry must contain "
+    "\"window\" (the window id from its header) plus every field of the single-window schema."
+)
+
+
+def validate_result(parsed: Dict[str, Any]) -> None:
+    """Validate a parsed analysis result against the response schema.
+    根据响应模式验证解析后的分析结果。
+    
+    Args:
+        parsed: Parsed JSON object from the model (模型返回的解析后JSON对象)
+        
+    Raises:
+        ValueError: If the result doesn't match the expected schema
+                   如果结果不符合预期的模式
+    """
+    if not isinstance(parsed, dict):
+        raise ValueError(f"Analysis result must be a JSON object: {parsed}")
+    
+    # Validate schema (验证模式)
+    for field in REQUIRED_FIELDS:
+        if field not in parsed:
+            raise ValueError(f"Missing required field '{field}' in response: {parsed}")
+    
+    # Validate final_state (验证final_state字段)
+    if parsed["final_state"] not in VALID_STATES:
+        raise ValueError(f"Invalid final_state: {parsed['final_state']}")
+    
+    # Validate confidence (验证confidence字段)
+    if not isinstance(parsed["confidence"], (int, float)) or not 0 <= parsed["confidence"] <= 1:
+        raise ValueError(f"Invalid confidence value: {parsed['confidence']}")
+
+
+def usage_from_body(
+    payload: Optional[Dict[str, Any]],
+    body: Optional[Dict[str, Any]],
+    completion_text: Optional[str] = None
+) -> Dict[str, Any]:
+    """Token usage of a call from the response ``usage`` block, estimated when absent.
+    从响应的 ``usage`` 块获取一次调用的token用量，缺失时进行估算。
+    
+    Args:
+        payload: Request payload, used for the prompt estimate (请求负载，用于估算提示词)
+        body: Response body, may be None for streamed calls (响应体，流式调用时可为None)
+        completion_text: Generated text, used for the completion estimate
+                        生成的文本，用于估算补全部分
+    
+    Returns:
+        Dict with prompt_tokens, completion_tokens, cached_tokens and estimated
+        包含prompt_tokens、completion_tokens、cached_tokens和estimated的字典
+    """
+    usage = (body or {}).get("usage") or {}
+    if usage:
+        details = usage.get("prompt_tokens_details") or {}
+        return {
+            "prompt_tokens": usage.get("prompt_tokens", 0),
+            "completion_tokens": usage.get("completion_tokens", 0),
+            "cached_tokens": details.get("cached_tokens", 0) or 0,
+            "estimated": False
+        }
+    if completion_text is None:
+        choices = (body or {}).get("choices") or [{}]
+        completion_text = (choices[0].get("message") or {}).get("content", "")
+    return {
+        "prompt_tokens": sum(
+            estimate_tokens(m.get("content", "")) + MESSAGE_OVERHEAD_TOKENS
+            for m in (payload or {}).get("messages", [])
+        ),
+        "completion_tokens": estimate_tokens(completion_text or ""),
+        "cached_tokens": 0,
+        "estimated": True
+    }
+
+
+def plan_packs(
+    windows: List[Tuple[int, List[str]]],
+    system_prompt: str,
+    max_windows: int,
+    max_tokens: int
+) -> List[List[Tuple[int, List[str]]]]:
+    """Group consecutive windows into packs that fit the token budget.
+    将连续窗口分组为符合token预算的打包请求。
+    
+    A pack's cost is the system prompt, every window's content and the output
+    reserved per window. A window that exceeds the budget alone forms its own pack.
+    每个打包请求的开销包括系统提示词、各窗口内容和为每个窗口预留的输出。
+    单独超出预算的窗口自成一组。
+    
+    Args:
+        windows: List of (window_idx, window_lines) (窗口列表)
+        system_prompt: System prompt sent with every request (每个请求附带的系统提示词)
+        max_windows: Maximum windows per pack (每组最多窗口数)
+        max_tokens: Token budget per packed request (每个打包请求的token预算)
+        
+    Returns:
+        List of packs, each a list of consecutive windows (分组列表，每组为连续窗口)
+    """
+    base_tokens = (
+        estimate_tokens(system_prompt)
+        + estimate_tokens(PACKED_INSTRUCTIONS)
+        + 2 * MESSAGE_OVERHEAD_TOKENS
+    )
+    packs: List[List[Tuple[int, List[str]]]] = []
+    current: List[Tuple[int, List[str]]] = []
+    current_tokens = base_tokens
+    
+    for window in windows:
+        window_tokens = estimate_lines_tokens(window[1]) + PACKED_OUTPUT_TOKENS_PER_WINDOW + 8
+        if current and (len(current) >= max_windows or current_tokens + window_tokens > max_tokens):
+            packs.append(current)
+            current = []
+            current_tokens = base_tokens
+        current.append(window)
+        current_tokens += window_tokens
+    
+    if current:
+        packs.append(current)
+    return packs
+
 
 class BailianClient:
     """Client for Alibaba Cloud Bailian LLM API.
@@ -18,7 +170,14 @@ class BailianClient:
         api_key: Optional[str] = None,
         base_url: Optional[str] = None,
         model: Optional[str] = None,
-        timeout: int = 60
+        timeout: int = 60,
+        compact: bool = False,
+        recorder: Optional[Callable[[Dict[str, Any], Dict[str, Any], float], None]] = None,
+        max_retries: int = 0,
+        retry_backoff: float = 0.5,
+        serialize: bool = False,
+        tracer: Optional[Tracer] = None,
+        spend: Optional[SpendMeter] = None
     ):
         """Initialize the Bailian client.
         初始化百炼客户端。
@@ -31,6 +190,26 @@ class BailianClient:
             model: Model name (reads from BAILIAN_MODEL env if not provided, defaults to qwen-plus)
                   模型名称（如果未提供，则从BAILIAN_MODEL环境变量读取，默认为qwen-plus）
             timeout: Request timeout in seconds (请求超时时间，单位秒)
+            compact: Send numbered windows and expand compact responses (see compact.py)
+                    发送带行号的窗口并展开紧凑响应（见compact.py）
+            recorder: Called with (payload, response body, latency seconds) after every
+                     completed request, e.g. replay.ExchangeRecorder
+                     每个请求完成后以 (请求负载, 响应体, 延迟秒数) 调用，例如replay.ExchangeRecorder
+            max_retries: Retries for 429/5xx, connection errors, timeouts and broken
+                        bodies (0 disables retrying)
+                        对429/5xx、连接错误、超时和损坏响应体的重试次数（0表示不重试）
+            retry_backoff: Base delay in seconds for exponential backoff; a server
+                          Retry-After header takes precedence
+                          指数退避的基础延迟秒数；服务器的Retry-After头优先
+            serialize: Send windows in the token-efficient form of serializer.py and
+                      map evidence back to the original lines
+                      以serializer.py的高token效率形式发送窗口，并将证据映射回原始行
+            tracer: Records request, time-to-first-byte, download, parse and
+                   validation spans (see tracing.py)
+                   记录请求、首字节时间、下载、解析和验证跨度（见tracing.py）
+            spend: Charged with the cost of every accounted call and checked
+                  before every request (see salience.SpendMeter)
+                  记入每次已计量调用的成本，并在每个请求前检查（见salience.SpendMeter）
         """
         self.api_key = api_key or os.environ.get("BAILIAN_API_KEY")
         if not self.api_key:
@@ -42,6 +221,15 @@ class BailianClient:
         )
         self.model = model or os.environ.get("BAILIAN_MODEL", "qwen-plus")
         self.timeout = timeout
+        self.compact = compact
+        self.recorder = recorder
+        self.max_retries = max_retries
+        self.retry_backoff = retry_backoff
+        self.serialize = serialize
+        self.tracer = tracer or NULL_TRACER
+        self.spend = spend
+        # Latency and retries of the calling thread's last request (调用线程最近一次请求的延迟和重试次数)
+        self._last_call = threading.local()
 
     def analyze_log_window(
         self,
@@ -69,70 +257,156 @@ class BailianClient:
             json.JSONDecodeError: If response is not valid JSON (如果响应不是有效的JSON)
             ValueError: If response doesn't match expected schema (如果响应不符合预期的模式)
         """
-        headers = {
-            "Authorization": f"Bearer {self.api_key}",
-            "Content-Type": "application/json"
-        }
+        payload = self.build_payload(system_prompt, log_content, temperature)
+        body = self._post(payload)
+        return self.account(self.parse_response(body, log_content), payload, body)
 
+    def complete_json(
+        self,
+        system_prompt: str,
+        user_content: str,
+        temperature: float = 0.1,
+        usage: Optional[Dict[str, Any]] = None
+    ) -> Dict[str, Any]:
+        """Send a free-form JSON-mode request and return the parsed object.
+        发送自由格式的JSON模式请求并返回解析后的对象。
+        
+        Unlike analyze_log_window, the result is not validated against the
+        window schema.
+        与analyze_log_window不同，结果不会按窗口模式验证。
+        
+        Args:
+            usage: Filled with the call's usage, cost and latency like a window result
+                  以与窗口结果相同的方式填入本次调用的用量、成本和延迟
+        
+        Raises:
+            requests.RequestException: If API request fails (如果API请求失败)
+            ValueError: If the response holds no JSON object (如果响应不包含JSON对象)
+        """
         payload = {
             "model": self.model,
             "messages": [
                 {"role": "system", "content": system_prompt},
-                {"role": "user", "content": f"Analyze this log window:\n\n{log_content}"}
+                {"role": "user", "content": user_content}
             ],
             "temperature": temperature,
             "response_format": {"type": "json_object"}
         }
-
-        url = f"{self.base_url}/chat/completions"
-        
-        response = requests.post(
-            url,
-            headers=headers,
-            json=payload,
-            timeout=self.timeout
-        )
-        response.raise_for_status()
-        
-        result = response.json()
-        
-        # Extract the actual content from the response
-        # 从响应中提取实际内容
+        result = self._post(payload)
+        if usage is not None:
+            self.account(usage, payload, result)
         if "choices" not in result or len(result["choices"]) == 0:
             raise ValueError("No choices in API response")
-        
         content = result["choices"][0]["message"]["content"]
-        
-        # Parse the JSON content (解析JSON内容)
         try:
             parsed = json.loads(content)
         except json.JSONDecodeError as e:
             raise ValueError(f"LLM response is not valid JSON: {content}") from e
+        if not isinstance(parsed, dict):
+            raise ValueError(f"LLM response must be a JSON object: {parsed}")
+        return parsed
+
+    def analyze_log_window_stream(
+        self,
+        system_prompt: str,
+        log_content: str,
+        temperature: float = 0.1,
+        on_field: Optional[Callable[[str, Any], None]] = None,
+        early_stop: bool = False
+    ) -> Dict[str, Any]:
+        """Analyze a log window with a streamed (SSE) response.
+        使用流式（SSE）响应分析日志窗口。
+        
+        Top-level fields are reported through ``on_field`` as soon as each one is
+        complete, so ``final_state`` and ``confidence`` are known long before the
+        evidence arrays finish. The request is retried and traced like any other;
+        a stream that breaks off is retried from the start and reports its
+        fields again.
+        每个顶层字段完成后立即通过 ``on_field`` 回调报告，
+        因此 ``final_state`` 和 ``confidence`` 远早于证据数组完成即可获知。
+        请求与其他请求一样重试和追踪；中途断开的流从头重试，并再次报告其字段。
+        
+        Args:
+            system_prompt: System prompt (系统提示词)
+            log_content: Log content to analyze (要分析的日志内容)
+            temperature: Sampling temperature (采样温度)
+            on_field: Callback invoked with (field, value) as fields complete
+                     字段完成时以 (字段名, 值) 调用的回调
+            early_stop: Close the stream once MERGE_FIELDS are complete; missing
+                       list fields are filled with empty lists
+                       在MERGE_FIELDS完成后关闭流；缺失的列表字段以空列表填充
+            
+        Returns:
+            Validated analysis result dict (验证后的分析结果字典)
+            
+        Raises:
+            requests.RequestException: If API request fails (如果API请求失败)
+            ValueError: If response doesn't match expected schema (如果响应不符合预期的模式)
+        """
+        payload = self.build_payload(system_prompt, log_content, temperature)
+        payload["stream"] = True
         
-        # Validate schema (验证模式)
-        required_fields = ["final_state", "confidence", "reason", "evidence", "next_actions"]
-        for field in required_fields:
-            if field not in parsed:
-                raise ValueError(f"Missing required field '{field}' in response: {parsed}")
+        def read(response):
+            parser = IncrementalJSONParser()
+            for raw_line in response.iter_lines():
+                line = raw_line.decode("utf-8") if isinstance(raw_line, bytes) else raw_line
+                if not line or not line.startswith("data:"):
+                    continue
+                data = line[len("data:"):].strip()
+                if data == "[DONE]":
+                    break
+                
+                choices = json.loads(data).get("choices") or []
+                if not choices:
+                    continue
+                delta = (choices[0].get("delta") or {}).get("content") or ""
+                for field, value in parser.feed(delta):
+                    if on_field:
+                        field = expand_key(field) if self.compact else field
+                        if self.compact and field == "final_state" and isinstance(value, str):
+                            value = STATE_CODES.get(value.upper(), value)
+                        on_field(field, value)
+                
+                received = {expand_key(f) for f in parser.fields} if self.compact else parser.fields
+                if early_stop and all(field in received for field in MERGE_FIELDS):
+                    # Closing the connection cancels remaining generation
+                    # 关闭连接即取消剩余的生成
+                    return parser, True
+            return parser, False
         
-        # Validate final_state (验证final_state字段)
-        if parsed["final_state"] not in ["PLAYING", "MUTED", "UNKNOWN"]:
-            raise ValueError(f"Invalid final_state: {parsed['final_state']}")
+        parser, stopped = self._post(payload, read=read)
         
-        # Validate confidence (验证confidence字段)
-        if not isinstance(parsed["confidence"], (int, float)) or not 0 <= parsed["confidence"] <= 1:
-            raise ValueError(f"Invalid confidence value: {parsed['confidence']}")
+        if stopped:
+            parsed = dict(parser.fields)
+            parsed = self._expand(parsed, log_content.split("\n"))
+            parsed.setdefault("evidence", [])
+            parsed.setdefault("next_actions", [])
+            parsed["early_stopped"] = True
+        else:
+            if self.recorder:
+                self.recorder(
+                    payload,
+                    {"choices": [{"message": {"role": "assistant", "content": parser.text}}]},
+                    self._last_call.latency
+                )
+            try:
+                parsed = json.loads(parser.text)
+            except json.JSONDecodeError as e:
+                raise ValueError(f"LLM response is not valid JSON: {parser.text}") from e
+            parsed = self._expand(parsed, log_content.split("\n"))
         
-        return parsed
+        with self.tracer.span("validate", cat="request"):
+            validate_result(parsed)
+        return self.account(parsed, payload, None, completion_text=parser.text)
 
-    def get_raw_response(
+    def build_payload(
         self,
         system_prompt: str,
         log_content: str,
         temperature: float = 0.1
     ) -> Dict[str, Any]:
-        """Get raw API response for debugging purposes.
-        获取原始API响应用于调试。
+        """Build the chat completion request body for a log window.
+        构建日志窗口的聊天补全请求体。
         
         Args:
             system_prompt: System prompt (系统提示词)
@@ -140,31 +414,349 @@ class BailianClient:
             temperature: Sampling temperature (采样温度)
             
         Returns:
-            Complete API response as dict (完整的API响应字典)
+            Request payload dict (请求负载字典)
         """
-        headers = {
-            "Authorization": f"Bearer {self.api_key}",
-            "Content-Type": "application/json"
+        log_content = self._window_body(log_content.split("\n"))
+        
+        return {
+            "model": self.model,
+            "messages": [
+                {"role": "system", "content": system_prompt},
+                {"role": "user", "content": f"Analyze this log window:\n\n{log_content}"}
+            ],
+            "temperature": temperature,
+            "response_format": {"type": "json_object"}
         }
 
-        payload = {
+    def parse_response(
+        self,
+        result: Dict[str, Any],
+        log_content: Optional[str] = None
+    ) -> Dict[str, Any]:
+        """Extract and validate the analysis result from a chat completion response.
+        从聊天补全响应中提取并验证分析结果。
+        
+        Args:
+            result: Raw API response body (原始API响应体)
+            log_content: Window content the request was built from; required in
+                        compact mode to resolve evidence line numbers
+                        构建请求所用的窗口内容；紧凑模式下用于解析证据行号
+            
+        Returns:
+            Validated analysis result dict (验证后的分析结果字典)
+            
+        Raises:
+            ValueError: If response is malformed or doesn't match the schema
+                       如果响应格式错误或不符合模式
+        """
+        # Extract the actual content from the response
+        # 从响应中提取实际内容
+        if "choices" not in result or len(result["choices"]) == 0:
+            raise ValueError("No choices in API response")
+        
+        content = result["choices"][0]["message"]["content"]
+        
+        # Parse the JSON content (解析JSON内容)
+        with self.tracer.span("parse_json", cat="request"):
+            try:
+                parsed = json.loads(content)
+            except json.JSONDecodeError as e:
+                raise ValueError(f"LLM response is not valid JSON: {content}") from e
+            
+            parsed = self._expand(parsed, (log_content or "").split("\n"))
+        
+        with self.tracer.span("validate", cat="request"):
+            validate_result(parsed)
+        return parsed
+
+    def build_packed_payload(
+        self,
+        system_prompt: str,
+        windows: List[Tuple[int, List[str]]],
+        temperature: float = 0.1
+    ) -> Dict[str, Any]:
+        """Build one chat completion request covering several windows.
+        构建覆盖多个窗口的单个聊天补全请求。
+        """
+        sections = [PACKED_INSTRUCTIONS.format(count=len(windows))]
+        for window_idx, window_lines in windows:
+            sections.append(f"=== WINDOW {window_idx} ===\n" + self._window_body(window_lines))
+        
+        return {
             "model": self.model,
             "messages": [
                 {"role": "system", "content": system_prompt},
-                {"role": "user", "content": f"Analyze this log window:\n\n{log_content}"}
+                {"role": "user", "content": "\n\n".join(sections)}
             ],
             "temperature": temperature,
             "response_format": {"type": "json_object"}
         }
 
+    def analyze_log_windows_packed(
+        self,
+        system_prompt: str,
+        windows: List[Tuple[int, List[str]]],
+        temperature: float = 0.1
+    ) -> Dict[int, Dict[str, Any]]:
+        """Analyze several windows in a single request.
+        在单个请求中分析多个窗口。
+        
+        Each element of the returned array is validated against the single-window
+        schema. Elements that fail validation are left out so the caller can fall
+        back to single-window requests for them.
+        返回数组的每个元素都按单窗口模式验证。验证失败的元素会被省略，
+        以便调用方对这些窗口回退到单窗口请求。
+        
+        Args:
+            system_prompt: System prompt (系统提示词)
+            windows: Consecutive (window_idx, window_lines) tuples (连续的窗口元组)
+            temperature: Sampling temperature (采样温度)
+            
+        Returns:
+            Dict mapping window_idx to its validated result (窗口索引到已验证结果的映射)
+            
+        Raises:
+            requests.RequestException: If API request fails (如果API请求失败)
+            ValueError: If the response is not a per-window result array
+                       如果响应不是逐窗口结果数组
+        """
+        payload = self.build_packed_payload(system_prompt, windows, temperature)
+        result = self._post(payload)
+        
+        if "choices" not in result or len(result["choices"]) == 0:
+            raise ValueError("No choices in API response")
+        content = result["choices"][0]["message"]["content"]
+        
+        with self.tracer.span("parse_json", cat="request"):
+            try:
+                parsed = json.loads(content)
+            except json.JSONDecodeError as e:
+                raise ValueError(f"LLM response is not valid JSON: {content}") from e
+        
+        items = parsed.get("results") if isinstance(parsed, dict) else parsed
+        if not isinstance(items, list):
+            raise ValueError(f"Packed response has no results array: {parsed}")
+        if len(items) != len(windows):
+            raise ValueError(f"Packed response has {len(items)} results for {len(windows)} windows")
+        
+        call = self.account({}, payload, result)
+        expected = [window_idx for window_idx, _ in windows]
+        lines_by_window = dict(windows)
+        results: Dict[int, Dict[str, Any]] = {}
+        for position, item in enumerate(items):
+            if not isinstance(item, dict):
+                continue
+            # Fall back to array position when the model omits the window id
+            # 模型省略窗口ID时按数组位置对应
+            window_idx = item.pop("window", expected[position])
+            if isinstance(window_idx, str) and window_idx.strip().isdigit():
+                window_idx = int(window_idx)
+            if window_idx not in expected or window_idx in results:
+                continue
+            item = self._expand(item, lines_by_window[window_idx])
+            try:
+                validate_result(item)
+            except ValueError:
+                continue
+            item["window_idx"] = window_idx
+            results[window_idx] = item
+        # The pack's usage is shared evenly by the windows it answered, so the share of
+        # windows that fall back is not lost (打包请求的用量由其已回答的窗口平分，回退窗口的份额不会丢失)
+        for item in results.values():
+            item.update(call)
+            item["usage"] = {
+                key: round(value / len(results), 1) if key != "estimated" else value
+                for key, value in call["usage"].items()
+            }
+            item["cost_cny"] = round(call["cost_cny"] / len(results), 6)
+            item["shared_by"] = len(results)
+        return results
+
+    def _window_body(self, window_lines: List[str]) -> str:
+        """Window text as sent to the model (发送给模型的窗口文本)."""
+        if self.serialize:
+            serialized = serialize_window(window_lines)
+            return serialized.numbered_text() if self.compact else serialized.text
+        return number_lines(window_lines) if self.compact else "\n".join(window_lines)
+
+    def _expand(self, parsed: Dict[str, Any], window_lines: List[str]) -> Dict[str, Any]:
+        """Undo compact and serialized encodings in a parsed result.
+        还原已解析结果中的紧凑编码和序列化编码。
+        """
+        if self.compact:
+            # Line numbers already point at the original lines (行号已指向原始行)
+            return expand_compact_result(parsed, window_lines)
+        if self.serialize and isinstance(parsed.get("evidence"), list):
+            parsed["evidence"] = serialize_window(window_lines).resolve(parsed["evidence"])
+        return parsed
+
+    def _post(
+        self,
+        payload: Dict[str, Any],
+        read: Optional[Callable[[Any], Any]] = None
+    ) -> Any:
+        """POST a chat completion request and return the response body.
+        发送聊天补全请求并返回响应体。
+        
+        Retryable failures are retried up to ``max_retries`` times. The response
+        is closed once read, also when the request fails.
+        可重试的失败最多重试 ``max_retries`` 次。响应读取后即关闭，请求失败时同样关闭。
+        
+        Args:
+            payload: Request body (请求体)
+            read: Sends the request streamed and returns what this callable reads
+                 from the response; a RequestException it raises mid-stream is
+                 retried like the POST itself
+                 以流式发送请求并返回该函数从响应中读取的内容；其在流中途抛出的RequestException与POST本身一样重试
+        
+        Raises:
+            BudgetExhausted: The spend meter's budget is used up (计量器的预算已用完)
+        """
+        if self.spend:
+            self.spend.check()
         url = f"{self.base_url}/chat/completions"
+        attempt = 0
+        stream = read is not None
         
-        response = requests.post(
-            url,
-            headers=headers,
-            json=payload,
-            timeout=self.timeout
-        )
-        response.raise_for_status()
+        with self.tracer.span("request", cat="request", model=self.model, stream=stream) as span_args:
+            while True:
+                started = time.monotonic()
+                span_args["attempts"] = attempt + 1
+                try:
+                    with self.tracer.span("http", cat="request", attempt=attempt + 1) as http_args:
+                        sent = self.tracer.now()
+                        response = requests.post(
+                            url,
+                            headers=self._headers(),
+                            json=payload,
+                            timeout=self.timeout,
+                            stream=stream
+                        )
+                        try:
+                            response.raise_for_status()
+                            if stream:
+                                result = read(response)
+                            else:
+                                with self.tracer.span("decode_body", cat="request"):
+                                    result = response.json()
+                        finally:
+                            # A streamed body is downloaded while read consumes it
+                            # 流式响应体在read消费时下载
+                            self._trace_response(response, sent, http_args)
+                            response.close()
+                except requests.RequestException as e:
+                    if attempt >= self.max_retries or not self._is_retryable(e):
+                        raise
+                    with self.tracer.span("retry_wait", cat="request", error=type(e).__name__):
+                        time.sleep(self._retry_delay(e, attempt))
+                    attempt += 1
+                    continue
+                
+                self._last_call.latency = time.monotonic() - started
+                self._last_call.retries = attempt
+                if self.recorder and not stream:
+                    self.recorder(payload, result, self._last_call.latency)
+                return result
+
+    def account(
+        self,
+        result: Dict[str, Any],
+        payload: Optional[Dict[str, Any]],
+        body: Optional[Dict[str, Any]],
+        completion_text: Optional[str] = None
+    ) -> Dict[str, Any]:
+        """Attach usage, latency, retries and model of this thread's last call to a result.
+        将本线程最近一次调用的用量、延迟、重试次数和模型附加到结果上。
+        
+        ``call_id`` tells calls apart when several results share one (packed requests);
+        it is random so results carried over from a resumed run never collide.
+        多个结果共享同一次调用时（打包请求），用 ``call_id`` 区分调用；它是随机的，因此恢复运行沿用的结果不会冲突。
+        """
+        latency = getattr(self._last_call, "latency", None)
+        usage = usage_from_body(payload, body, completion_text)
+        result.update({
+            "model": self.model,
+            "usage": usage,
+            "cost_cny": round(estimate_cost(self.model, usage["prompt_tokens"], usage["completion_tokens"]), 6),
+            "latency_s": round(latency, 4) if latency is not None else None,
+            "retries": getattr(self._last_call, "retries", 0),
+            "call_id": uuid.uuid4().hex[:12]
+        })
+        if self.spend:
+            self.spend.charge(result["cost_cny"])
+        return result
+
+    def _trace_response(self, response, sent: float, span_args: Dict[str, Any]):
+        """Split a completed POST into time-to-first-byte and download spans.
+        将完成的POST拆分为首字节时间和下载跨度。
+        
+        ``response.elapsed`` runs until the headers are parsed, so it covers
+        connection setup, upload and server time; the rest is the body download.
+        ``response.elapsed`` 持续到响应头解析完成，因此包含建立连接、上传和服务器耗时；其余为响应体下载。
+        """
+        if not self.tracer.enabled:
+            return
+        span_args["status"] = getattr(response, "status_code", None)
+        elapsed = getattr(response, "elapsed", None)
+        if not isinstance(elapsed, timedelta):
+            return
+        first_byte = sent + elapsed.total_seconds()
+        self.tracer.add_span("ttfb", sent, first_byte, "request")
+        self.tracer.add_span("download", first_byte, max(self.tracer.now(), first_byte), "request")
+
+    @staticmethod
+    def _is_retryable(error: requests.RequestException) -> bool:
+        """Whether a failed request may succeed on retry.
+        判断失败的请求重试后是否可能成功。
+        
+        HTTP 429 and 5xx are retryable; other HTTP errors are not. Errors without a
+        response (connection reset, timeout, truncated or malformed body) are.
+        HTTP 429和5xx可重试，其他HTTP错误不可重试。无响应的错误（连接重置、超时、
+        截断或格式错误的响应体）可重试。
+        """
+        response = getattr(error, "response", None)
+        if isinstance(error, requests.HTTPError) and response is not None:
+            return response.status_code == 429 or response.status_code >= 500
+        return True
+
+    def _retry_delay(self, error: requests.RequestException, attempt: int) -> float:
+        """Seconds to wait before the next attempt (下一次尝试前等待的秒数)."""
+        response = getattr(error, "response", None)
+        retry_after = response.headers.get("Retry-After") if response is not None else None
+        if retry_after:
+            try:
+                return max(float(retry_after), 0.0)
+            except ValueError:
+                pass
+        delay = min(self.retry_backoff * (2 ** attempt), 30.0)
+        # Full jitter spreads retries from many in-flight requests
+        # 完全抖动使大量并发请求的重试分散开
+        return random.uniform(0, delay)
+
+    def _headers(self) -> Dict[str, str]:
+        """Build HTTP headers for API requests.
+        构建API请求的HTTP头。
+        """
+        return {
+            "Authorization": f"Bearer {self.api_key}",
+            "Content-Type": "application/json"
+        }
+
+    def get_raw_response(
+        self,
+        system_prompt: str,
+        log_content: str,
+        temperature: float = 0.1
+    ) -> Dict[str, Any]:
+        """Get raw API response for debugging purposes.
+        获取原始API响应用于调试。
         
-        return response.json()
+        Args:
+            system_prompt: System prompt (系统提示词)
+            log_content: Log content to analyze (要分析的日志内容)
+            temperature: Sampling temperature (采样温度)
+            
+        Returns:
+            Complete API response as dict (完整的API响应字典)
+        """
+        return self._post(self.build_payload(system_prompt, log_content, temperature))
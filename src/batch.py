@@ -0,0 +1,306 @@
+"""Offline Batch API execution for bulk log analysis.
+使用Batch API离线批量分析日志。
+
+All window requests are written to one JSONL file, uploaded and submitted as a
+single batch job, polled until done, and mapped back to window results.
+所有窗口请求写入一个JSONL文件，作为单个批处理任务上传提交，轮询直至完成，再映射回窗口结果。
+"""
+
+import hashlib
+import json
+import time
+from pathlib import Path
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+import requests
+
+from .analyzer import failed_window_result
+from .bailian_client import BailianClient, usage_from_body
+from .pricing import estimate_cost
+
+
+# Batch statuses after which polling stops (停止轮询的批处理终止状态)
+TERMINAL_STATUSES = {"completed", "failed", "expired", "cancelled"}
+
+# Saved statuses of a batch that cannot produce results; the next run resubmits
+# 无法产生结果的批处理的已保存状态；下次运行时重新提交
+RESUBMIT_STATUSES = {"failed", "expired", "cancelled", "no_output"}
+
+# File names written to the output directory (写入输出目录的文件名)
+BATCH_INPUT_FILE = "batch_input.jsonl"
+BATCH_OUTPUT_FILE = "batch_output.jsonl"
+BATCH_STATE_FILE = "batch_state.json"
+
+
+def custom_id_for(window_idx: int) -> str:
+    """Return the batch custom_id for a window (返回窗口对应的批处理custom_id)."""
+    return f"window-{window_idx}"
+
+
+class BatchRunner:
+    """Runs window analysis through the OpenAI-compatible Batch endpoint.
+    通过OpenAI兼容的Batch接口执行窗口分析。
+
+    Progress is recorded in ``batch_state.json`` so an interrupted run can resume
+    polling the same batch instead of resubmitting it.
+    进度记录在 ``batch_state.json`` 中，中断后可继续轮询同一批处理而无需重新提交。
+    """
+
+    def __init__(
+        self,
+        client: BailianClient,
+        work_dir: Path,
+        poll_interval: float = 30.0,
+        max_wait: Optional[float] = None,
+        sleep: Callable[[float], None] = time.sleep
+    ):
+        """Initialize the batch runner.
+        初始化批处理执行器。
+
+        Args:
+            client: Configured Bailian client (已配置的百炼客户端)
+            work_dir: Directory for batch files and state (批处理文件和状态的目录)
+            poll_interval: Seconds between status polls (状态轮询间隔秒数)
+            max_wait: Give up polling after this many seconds, None waits forever
+                     轮询超过此秒数则放弃，None表示一直等待
+            sleep: Sleep function, replaceable in tests (休眠函数，测试中可替换)
+        """
+        self.client = client
+        self.work_dir = Path(work_dir)
+        self.poll_interval = poll_interval
+        self.max_wait = max_wait
+        self.sleep = sleep
+
+    @property
+    def state_path(self) -> Path:
+        return self.work_dir / BATCH_STATE_FILE
+
+    def write_batch_file(
+        self,
+        system_prompt: str,
+        windows: List[Tuple[int, List[str]]]
+    ) -> Tuple[Path, str]:
+        """Write all window requests as a JSONL batch input file.
+        将所有窗口请求写入JSONL批处理输入文件。
+
+        Returns:
+            Tuple of (file path, sha256 fingerprint of the file content)
+            元组 (文件路径, 文件内容的sha256指纹)
+        """
+        self.work_dir.mkdir(parents=True, exist_ok=True)
+        lines = []
+        for window_idx, window_lines in windows:
+            lines.append(json.dumps({
+                "custom_id": custom_id_for(window_idx),
+                "method": "POST",
+                "url": "/v1/chat/completions",
+                "body": self.client.build_payload(system_prompt, "\n".join(window_lines))
+            }, ensure_ascii=False))
+        content = ("\n".join(lines) + "\n").encode("utf-8")
+
+        path = self.work_dir / BATCH_INPUT_FILE
+        path.write_bytes(content)
+        return path, hashlib.sha256(content).hexdigest()
+
+    def load_state(self) -> Optional[Dict[str, Any]]:
+        """Load saved batch state, or None if absent/unreadable.
+        加载已保存的批处理状态，不存在或无法读取时返回None。
+        """
+        if not self.state_path.exists():
+            return None
+        try:
+            with open(self.state_path, 'r', encoding='utf-8') as f:
+                return json.load(f)
+        except (json.JSONDecodeError, OSError):
+            return None
+
+    def save_state(self, state: Dict[str, Any]):
+        """Atomically persist batch state (原子地保存批处理状态)."""
+        tmp_path = self.state_path.with_suffix(".tmp")
+        with open(tmp_path, 'w', encoding='utf-8') as f:
+            json.dump(state, f, indent=2)
+        tmp_path.replace(self.state_path)
+
+    def upload_file(self, path: Path) -> str:
+        """Upload a batch input file and return its file id.
+        上传批处理输入文件并返回文件ID。
+        """
+        with open(path, 'rb') as f:
+            response = requests.post(
+                f"{self.client.base_url}/files",
+                headers={"Authorization": f"Bearer {self.client.api_key}"},
+                files={"file": (path.name, f, "application/jsonl")},
+                data={"purpose": "batch"},
+                timeout=self.client.timeout
+            )
+        response.raise_for_status()
+        return response.json()["id"]
+
+    def create_batch(self, input_file_id: str) -> str:
+        """Create a batch job and return its batch id.
+        创建批处理任务并返回批处理ID。
+        """
+        response = requests.post(
+            f"{self.client.base_url}/batches",
+            headers=self.client._headers(),
+            json={
+                "input_file_id": input_file_id,
+                "endpoint": "/v1/chat/completions",
+                "completion_window": "24h"
+            },
+            timeout=self.client.timeout
+        )
+        response.raise_for_status()
+        return response.json()["id"]
+
+    def get_batch(self, batch_id: str) -> Dict[str, Any]:
+        """Fetch the current batch status record.
+        获取当前批处理状态记录。
+
+        Failures are retried with the client's retry count and backoff, so one
+        transient error does not end a poll that can last hours.
+        失败按客户端的重试次数和退避重试，因此一次瞬时错误不会终止可能持续数小时的轮询。
+        """
+        attempt = 0
+        while True:
+            try:
+                response = requests.get(
+                    f"{self.client.base_url}/batches/{batch_id}",
+                    headers=self.client._headers(),
+                    timeout=self.client.timeout
+                )
+                response.raise_for_status()
+                return response.json()
+            except requests.RequestException as e:
+                if attempt >= self.client.max_retries or not self.client._is_retryable(e):
+                    raise
+                self.sleep(self.client._retry_delay(e, attempt))
+                attempt += 1
+
+    def download_file(self, file_id: str) -> bytes:
+        """Download a file's content (下载文件内容)."""
+        response = requests.get(
+            f"{self.client.base_url}/files/{file_id}/content",
+            headers=self.client._headers(),
+            timeout=self.client.timeout
+        )
+        response.raise_for_status()
+        return response.content
+
+    def poll(self, batch_id: str, on_status: Optional[Callable[[Dict[str, Any]], None]] = None) -> Dict[str, Any]:
+        """Poll a batch until it reaches a terminal status.
+        轮询批处理直至达到终止状态。
+
+        Raises:
+            TimeoutError: If max_wait elapses first (如果先超过max_wait)
+        """
+        started = time.monotonic()
+        while True:
+            batch = self.get_batch(batch_id)
+            if on_status:
+                on_status(batch)
+            if batch.get("status") in TERMINAL_STATUSES:
+                return batch
+            if self.max_wait is not None and time.monotonic() - started >= self.max_wait:
+                raise TimeoutError(f"Batch {batch_id} still {batch.get('status')} after {self.max_wait}s")
+            self.sleep(self.poll_interval)
+
+    def collect_results(
+        self,
+        output_content: bytes,
+        windows: List[Tuple[int, List[str]]]
+    ) -> List[Dict[str, Any]]:
+        """Map batch output lines back to ordered window results.
+        将批处理输出行映射回有序的窗口结果。
+
+        Windows missing from the output or with failed responses get UNKNOWN results.
+        输出中缺失或响应失败的窗口记为UNKNOWN结果。
+        """
+        by_custom_id: Dict[str, Dict[str, Any]] = {}
+        for raw_line in output_content.decode("utf-8").splitlines():
+            if raw_line.strip():
+                item = json.loads(raw_line)
+                by_custom_id[item.get("custom_id")] = item
+
+        window_results = []
+        for window_idx, window_lines in windows:
+            item = by_custom_id.get(custom_id_for(window_idx))
+            if item is None:
+                window_results.append(failed_window_result(window_idx, "No result in batch output"))
+                continue
+            response = item.get("response") or {}
+            if item.get("error") or response.get("status_code") != 200:
+                error = item.get("error") or f"HTTP {response.get('status_code')}"
+                window_results.append(failed_window_result(window_idx, str(error)))
+                continue
+            try:
+                result = self.client.parse_response(response.get("body") or {}, "\n".join(window_lines))
+            except (ValueError, KeyError, TypeError) as e:
+                window_results.append(failed_window_result(window_idx, str(e)))
+                continue
+            result["window_idx"] = window_idx
+            result["model"] = (response.get("body") or {}).get("model") or self.client.model
+            result["usage"] = usage_from_body(None, response.get("body"))
+            result["cost_cny"] = round(estimate_cost(
+                result["model"], result["usage"]["prompt_tokens"], result["usage"]["completion_tokens"]
+            ), 6)
+            window_results.append(result)
+        return window_results
+
+    def run(
+        self,
+        system_prompt: str,
+        windows: List[Tuple[int, List[str]]],
+        on_status: Optional[Callable[[Dict[str, Any]], None]] = None
+    ) -> List[Dict[str, Any]]:
+        """Submit (or resume) a batch for all windows and return window results.
+        为所有窗口提交（或恢复）批处理并返回窗口结果。
+
+        A saved state whose fingerprint matches the current batch input is resumed,
+        unless that batch already ended without results; otherwise a new batch is
+        submitted. A completed batch without an output file (every request failed)
+        gives every window a failed result.
+        若已保存状态的指纹与当前批处理输入一致且该批处理未以无结果状态结束则恢复，否则提交新的批处理。
+        已完成但没有输出文件的批处理（所有请求均失败）为每个窗口返回失败结果。
+
+        Raises:
+            RuntimeError: If the batch ends in a non-completed status
+                         如果批处理以非completed状态结束
+        """
+        path, fingerprint = self.write_batch_file(system_prompt, windows)
+        output_path = self.work_dir / BATCH_OUTPUT_FILE
+
+        state = self.load_state()
+        if (state is None or state.get("fingerprint") != fingerprint
+                or state.get("status") in RESUBMIT_STATUSES):
+            input_file_id = self.upload_file(path)
+            batch_id = self.create_batch(input_file_id)
+            state = {
+                "fingerprint": fingerprint,
+                "input_file_id": input_file_id,
+                "batch_id": batch_id,
+                "status": "submitted",
+                "window_count": len(windows)
+            }
+            self.save_state(state)
+
+        if state.get("status") == "downloaded" and output_path.exists():
+            return self.collect_results(output_path.read_bytes(), windows)
+
+        batch = self.poll(state["batch_id"], on_status)
+        state["status"] = batch.get("status")
+        self.save_state(state)
+        if batch.get("status") != "completed":
+            raise RuntimeError(f"Batch {state['batch_id']} ended with status {batch.get('status')}")
+
+        if not batch.get("output_file_id"):
+            state["status"] = "no_output"
+            self.save_state(state)
+            error = f"Batch {state['batch_id']} completed without an output file (every request failed)"
+            return [failed_window_result(window_idx, error) for window_idx, _ in windows]
+
+        output_content = self.download_file(batch["output_file_id"])
+        output_path.write_bytes(output_content)
+        state["status"] = "downloaded"
+        self.save_state(state)
+        return self.collect_results(output_content, windows)
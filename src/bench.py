@@ -0,0 +1,143 @@
+"""Offline end-to-end benchmark against recorded LLM exchanges.
+基于录制的大模型交互进行离线端到端基准测试。
+
+Usage (用法):
+    python -m src.bench --log samples/demo.log --recordings out/recordings.jsonl \\
+        --latency lognormal:0.8,0.4 --concurrency 8
+"""
+
+import argparse
+import json
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from typing import Any, Dict, List, Tuple
+
+from .bailian_client import BailianClient
+from .chunker import LogChunker
+from .cli import load_system_prompt
+from .log_parser import LogParser
+from .masker import DataMasker
+from .metrics import summarize_latencies
+from .replay import LatencyModel, ReplayResponder, load_recordings
+from .stub_server import StubServer
+
+
+def run_windows(
+    client: BailianClient,
+    system_prompt: str,
+    windows: List[Tuple[int, List[str]]],
+    concurrency: int = 1
+) -> Dict[str, Any]:
+    """Analyze windows with a thread pool and measure throughput.
+    使用线程池分析窗口并测量吞吐量。
+
+    CPU time is measured per worker thread, so time spent by an in-process stub
+    server is not counted against the client.
+    CPU时间按工作线程统计，因此进程内替身服务器消耗的时间不计入客户端。
+
+    Args:
+        client: Client pointed at the server under test (指向被测服务器的客户端)
+        system_prompt: System prompt (系统提示词)
+        windows: List of (window_idx, window_lines) (窗口列表)
+        concurrency: Number of in-flight requests (并发请求数)
+
+    Returns:
+        Dict with counts, wall time, windows/s, CPU per window, latency percentiles
+        and per-error-type counts
+        包含计数、总耗时、每秒窗口数、每窗口CPU时间、延迟百分位和各错误类型计数的字典
+    """
+    def analyze(window: Tuple[int, List[str]]) -> Tuple[bool, float, float, str]:
+        cpu_start = time.thread_time()
+        started = time.monotonic()
+        error = ""
+        try:
+            client.analyze_log_window(system_prompt, "\n".join(window[1]))
+        except Exception as e:
+            error = type(e).__name__
+        return not error, time.monotonic() - started, time.thread_time() - cpu_start, error
+
+    wall_start = time.monotonic()
+    with ThreadPoolExecutor(max_workers=max(concurrency, 1)) as pool:
+        outcomes = list(pool.map(analyze, windows))
+    wall_time = time.monotonic() - wall_start
+
+    errors: Dict[str, int] = {}
+    for ok, _, _, error in outcomes:
+        if not ok:
+            errors[error] = errors.get(error, 0) + 1
+    succeeded = sum(1 for ok, _, _, _ in outcomes if ok)
+    cpu_time = sum(cpu for _, _, cpu, _ in outcomes)
+
+    return {
+        "windows": len(windows),
+        "succeeded": succeeded,
+        "lost_windows": len(windows) - succeeded,
+        "errors": errors,
+        "concurrency": concurrency,
+        "wall_time_s": round(wall_time, 4),
+        "windows_per_s": round(len(windows) / wall_time, 2) if wall_time > 0 else 0.0,
+        "client_cpu_ms_per_window": round(1000 * cpu_time / len(windows), 3) if windows else 0.0,
+        "latency_s": summarize_latencies([latency for ok, latency, _, _ in outcomes if ok])
+    }
+
+
+def main():
+    """Main entry point for the benchmark.
+    基准测试的主入口点。
+    """
+    parser = argparse.ArgumentParser(
+        prog="python -m src.bench",
+        description="Replay recorded LLM exchanges through the full pipeline with no network"
+                    "\n无网络环境下通过完整流程回放录制的大模型交互"
+    )
+    parser.add_argument("--log", required=True, help="Path to input log file (输入日志文件路径)")
+    parser.add_argument("--recordings", required=True,
+                        help="JSONL recording from analyze --record (analyze --record生成的录制文件)")
+    parser.add_argument("--latency", default="recorded",
+                        help="Latency distribution: none, recorded, fixed:S, uniform:A,B, lognormal:MEDIAN,SIGMA "
+                             "(default: recorded) (延迟分布，默认：recorded)")
+    parser.add_argument("--seed", type=int, default=0, help="Random seed (default: 0) (随机种子)")
+    parser.add_argument("--concurrency", type=int, default=1,
+                        help="In-flight requests (default: 1) (并发请求数，默认：1)")
+    parser.add_argument("--chunk-size", type=int, default=200, help="Lines per window (每个窗口的行数)")
+    parser.add_argument("--overlap", type=int, default=50, help="Overlapping lines (重叠行数)")
+    parser.add_argument("--mask", action="store_true", help="Enable data masking (启用数据脱敏)")
+    parser.add_argument("--compact", action="store_true", help="Use compact response schema (使用紧凑响应模式)")
+    parser.add_argument("--json-out", default=None, help="Write results as JSON to this path (将结果以JSON写入此路径)")
+    args = parser.parse_args()
+
+    prep_cpu = time.process_time()
+    prep_start = time.monotonic()
+    lines = LogParser().parse_and_filter(args.log)
+    if args.mask:
+        lines = DataMasker().mask_lines(lines)
+    windows = LogChunker(args.chunk_size, args.overlap).chunk_lines(lines)
+    system_prompt = load_system_prompt(compact=args.compact)
+    prep = {
+        "lines": len(lines),
+        "wall_time_s": round(time.monotonic() - prep_start, 4),
+        "cpu_time_s": round(time.process_time() - prep_cpu, 4)
+    }
+
+    responder = ReplayResponder(
+        load_recordings(Path(args.recordings)),
+        latency=LatencyModel(args.latency, seed=args.seed)
+    )
+    with StubServer(responder=responder) as stub:
+        client = BailianClient(api_key="replay", base_url=stub.base_url, compact=args.compact)
+        results = run_windows(client, system_prompt, windows, args.concurrency)
+
+    results["prepare"] = prep
+    results["replay"] = {"hits": responder.hits, "misses": responder.misses, "latency": args.latency}
+
+    print(json.dumps(results, indent=2))
+    if args.json_out:
+        with open(args.json_out, 'w', encoding='utf-8') as f:
+            json.dump(results, f, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
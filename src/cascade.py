@@ -0,0 +1,215 @@
+"""Cascading model tiers: a cheap model first, a stronger one on doubt.
+级联模型层级：先用廉价模型，存疑时再用更强的模型。
+"""
+
+import threading
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+from .analyzer import failed_window_result
+from .bailian_client import BailianClient
+from .metrics import summarize_latencies
+from .tokens import estimate_tokens
+
+
+def parse_tiers(spec: str) -> List[Tuple[str, Optional[str]]]:
+    """Parse a tier spec such as ``qwen-turbo,qwen-plus``.
+    解析层级规格，例如 ``qwen-turbo,qwen-plus``。
+
+    A tier may name its own endpoint as ``model@base_url``, e.g. a local server.
+    层级可以用 ``model@base_url`` 指定自己的端点，例如本地服务器。
+
+    Returns:
+        List of (model, base_url or None), cheapest first
+        (模型, base_url或None) 列表，最廉价的在前
+    """
+    tiers = []
+    for item in spec.split(","):
+        item = item.strip()
+        if not item:
+            continue
+        model, _, base_url = item.partition("@")
+        tiers.append((model, base_url or None))
+    if not tiers:
+        raise ValueError(f"No model tiers in: {spec!r}")
+    return tiers
+
+
+class TierStats:
+    """Client recorder that accumulates call latency and token spend for one tier.
+    累计单个层级调用延迟和token消耗的客户端录制器。
+
+    Uses the response ``usage`` block when present and the local estimate
+    otherwise; calls are forwarded to ``forward`` (e.g. an ExchangeRecorder).
+    有 ``usage`` 块时使用它，否则使用本地估算；调用会转发给 ``forward``（例如ExchangeRecorder）。
+    """
+
+    def __init__(self, model: str, forward: Optional[Callable] = None):
+        self.model = model
+        self.forward = forward
+        self.calls = 0
+        self.failures = 0
+        self.latencies: List[float] = []
+        self.prompt_tokens = 0
+        self.completion_tokens = 0
+        self.estimated_calls = 0
+        self._lock = threading.Lock()
+
+    def __call__(self, payload: Dict[str, Any], response_body: Dict[str, Any], latency: float = 0.0):
+        usage = response_body.get("usage") or {}
+        if usage:
+            prompt = usage.get("prompt_tokens", 0)
+            completion = usage.get("completion_tokens", 0)
+        else:
+            prompt = sum(estimate_tokens(m.get("content", "")) for m in payload.get("messages", []))
+            choices = response_body.get("choices") or [{}]
+            completion = estimate_tokens(choices[0].get("message", {}).get("content", ""))
+        with self._lock:
+            self.calls += 1
+            self.latencies.append(latency)
+            self.prompt_tokens += prompt
+            self.completion_tokens += completion
+            if not usage:
+                self.estimated_calls += 1
+        if self.forward:
+            self.forward(payload, response_body, latency)
+
+    def to_dict(self) -> Dict[str, Any]:
+        return {
+            "model": self.model,
+            "calls": self.calls,
+            "failures": self.failures,
+            "latency_s": summarize_latencies(self.latencies),
+            "prompt_tokens": self.prompt_tokens,
+            "completion_tokens": self.completion_tokens,
+            "total_tokens": self.prompt_tokens + self.completion_tokens,
+            "estimated_usage_calls": self.estimated_calls
+        }
+
+
+# Fields describing the call behind a result (描述结果背后调用的字段)
+CALL_FIELDS = ("model", "usage", "cost_cny", "latency_s", "retries", "call_id")
+
+
+class CascadeRunner:
+    """Analyzes windows with the first tier and escalates doubtful ones.
+    使用第一层级分析窗口，并将存疑窗口升级到下一层级。
+
+    A window is escalated when its confidence is below the threshold, its state
+    is UNKNOWN, or it disagrees with an adjacent window. Each tier only re-checks
+    the windows escalated to it; the last tier's verdict stands. A result that
+    replaces a lower tier's keeps that tier's call in ``lower_tier_calls``, so
+    summarize_usage still counts it.
+    当窗口置信度低于阈值、状态为UNKNOWN或与相邻窗口不一致时升级。每个层级只复查升级给它的窗口；最后一层的结论为准。
+    取代较低层级结果的结果会在 ``lower_tier_calls`` 中保留该层级的调用，因此summarize_usage仍会计入。
+    """
+
+    def __init__(self, clients: List[BailianClient], stats: List[TierStats], threshold: float = 0.8):
+        """Initialize the runner.
+        初始化运行器。
+
+        Args:
+            clients: One client per tier, cheapest first; each should use the
+                    matching TierStats as its recorder
+                    每个层级一个客户端，最廉价的在前；每个客户端应以对应的TierStats作为录制器
+            stats: Per-tier statistics (各层级统计)
+            threshold: Minimum confidence that stops escalation (停止升级的最低置信度)
+        """
+        self.clients = clients
+        self.stats = stats
+        self.threshold = threshold
+
+    def needs_escalation(
+        self,
+        results: Dict[int, Dict[str, Any]],
+        window_idx: int,
+        neighbors: Tuple[Optional[int], Optional[int]]
+    ) -> bool:
+        """Decide whether a window's current result should go up a tier.
+        判断窗口当前结果是否应升级到下一层级。
+
+        Args:
+            results: Current results by window index (按窗口索引的当前结果)
+            window_idx: Window to decide (待判断的窗口)
+            neighbors: The analyzed windows before and after it, None at either
+                      end; after prefilter, dedup or budget selection these need
+                      not be adjacent indices
+                      其前后的已分析窗口，两端为None；经过预过滤、去重或预算选择后，它们不一定是相邻索引
+        """
+        result = results[window_idx]
+        if result["final_state"] == "UNKNOWN" or result["confidence"] < self.threshold:
+            return True
+        for neighbor in neighbors:
+            other = results.get(neighbor)
+            if other is not None and other["final_state"] != result["final_state"]:
+                return True
+        return False
+
+    def run(
+        self,
+        system_prompt: str,
+        windows: List[Tuple[int, List[str]]],
+        on_result: Optional[Callable[[int, Dict[str, Any]], None]] = None,
+        on_final: Optional[Callable[[Dict[str, Any]], None]] = None
+    ) -> List[Dict[str, Any]]:
+        """Run all tiers and return ordered window results.
+        运行所有层级并返回有序的窗口结果。
+
+        Args:
+            system_prompt: System prompt (系统提示词)
+            windows: List of (window_idx, window_lines) (窗口列表)
+            on_result: Called with (tier, result) after every window analysis
+                      每次窗口分析后以 (层级, 结果) 调用
+            on_final: Called with a window's result once no higher tier will
+                     re-check it, e.g. to journal it
+                     窗口结果不再由更高层级复查时以其调用，例如写入日志
+
+        Returns:
+            Ordered window results, each with ``tier`` and ``model`` fields
+            有序的窗口结果，每个结果包含 ``tier`` 和 ``model`` 字段
+        """
+        contents = {idx: "\n".join(lines) for idx, lines in windows}
+        results: Dict[int, Dict[str, Any]] = {}
+        pending = [idx for idx, _ in windows]
+        order = sorted(contents)
+        neighbors = {
+            idx: (order[i - 1] if i > 0 else None, order[i + 1] if i + 1 < len(order) else None)
+            for i, idx in enumerate(order)
+        }
+
+        for tier, client in enumerate(self.clients):
+            for window_idx in pending:
+                try:
+                    result = client.analyze_log_window(system_prompt, contents[window_idx])
+                    result["window_idx"] = window_idx
+                except Exception as e:
+                    self.stats[tier].failures += 1
+                    previous = results.get(window_idx)
+                    if previous is not None and not previous["reason"].startswith("Analysis failed"):
+                        # Keep the lower tier's verdict (保留较低层级的结论)
+                        previous.setdefault("escalation_error", str(e))
+                        continue
+                    result = failed_window_result(window_idx, str(e), ["Retry analysis", "Check API connectivity"])
+                result["tier"] = tier
+                result["model"] = client.model
+                previous = results.get(window_idx)
+                if previous is not None:
+                    call = {field: previous[field] for field in CALL_FIELDS if field in previous}
+                    result["lower_tier_calls"] = previous.pop("lower_tier_calls", []) + [
+                        {"tier": previous["tier"], **call}
+                    ]
+                results[window_idx] = result
+                if on_result:
+                    on_result(tier, result)
+
+            escalated = []
+            if tier + 1 < len(self.clients):
+                escalated = [idx for idx in pending if self.needs_escalation(results, idx, neighbors[idx])]
+            if on_final:
+                for window_idx in pending:
+                    if window_idx not in escalated:
+                        on_final(results[window_idx])
+            pending = escalated
+            if not pending:
+                break
+
+        return [results[idx] for idx, _ in windows]
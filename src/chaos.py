@@ -0,0 +1,288 @@
+"""Fault-injecting chat completion server and load driver.
+故障注入聊天补全服务器及负载驱动。
+
+Usage (用法):
+    python -m src.chaos --scenario all --concurrency 64 --windows 512
+    python -m src.chaos --scenario rate_limit_bursts --concurrency 128 --retries 3
+"""
+
+import argparse
+import json
+import random
+import sys
+import threading
+import time
+from typing import Any, Dict, List, Optional
+
+from .bailian_client import BailianClient
+from .bench import run_windows
+from .stub_server import StubServer
+
+
+# Fault kinds understood by ChaosServer (ChaosServer支持的故障类型)
+FAULT_KINDS = ["latency_spike", "rate_limit", "server_error", "truncated", "malformed", "slow_drip"]
+
+
+class RawResponse:
+    """HTTP response written byte by byte, allowing broken framing.
+    逐字节写出的HTTP响应，允许错误的帧格式。
+    """
+
+    def __init__(
+        self,
+        status: int,
+        body: bytes,
+        headers: Optional[Dict[str, str]] = None,
+        declared_length: Optional[int] = None,
+        chunk_size: int = 0,
+        chunk_delay: float = 0.0
+    ):
+        """Initialize a raw response.
+        初始化原始响应。
+
+        Args:
+            status: HTTP status code (HTTP状态码)
+            body: Bytes actually sent (实际发送的字节)
+            headers: Extra headers (额外的头)
+            declared_length: Content-Length to announce; larger than the body
+                            truncates the response (声明的Content-Length；大于实际长度即为截断)
+            chunk_size: Send the body in pieces of this size (按此大小分段发送响应体)
+            chunk_delay: Seconds to wait between pieces (分段之间的等待秒数)
+        """
+        self.status = status
+        self.body = body
+        self.headers = headers or {}
+        self.declared_length = declared_length if declared_length is not None else len(body)
+        self.chunk_size = chunk_size
+        self.chunk_delay = chunk_delay
+
+    def write_to(self, handler):
+        handler.send_response(self.status)
+        handler.send_header("Content-Type", "application/json")
+        handler.send_header("Content-Length", str(self.declared_length))
+        handler.send_header("Connection", "close")
+        for key, value in self.headers.items():
+            handler.send_header(key, value)
+        handler.end_headers()
+        handler.close_connection = True
+
+        try:
+            if self.chunk_size <= 0:
+                handler.wfile.write(self.body)
+                return
+            for i in range(0, len(self.body), self.chunk_size):
+                handler.wfile.write(self.body[i:i + self.chunk_size])
+                handler.wfile.flush()
+                if self.chunk_delay:
+                    time.sleep(self.chunk_delay)
+        except (BrokenPipeError, ConnectionResetError):
+            # Client gave up (客户端已放弃)
+            pass
+
+
+class FaultRule:
+    """When and how to inject one kind of fault.
+    定义何时以及如何注入一种故障。
+
+    A rule fires for request number ``n`` when ``n % period < length`` (a burst
+    schedule) or with probability ``rate``.
+    当 ``n % period < length``（突发计划）或以概率 ``rate`` 时，规则对第 ``n`` 个请求生效。
+    """
+
+    def __init__(
+        self,
+        kind: str,
+        rate: float = 0.0,
+        period: int = 0,
+        length: int = 0,
+        **params
+    ):
+        if kind not in FAULT_KINDS:
+            raise ValueError(f"Unknown fault kind: {kind}")
+        self.kind = kind
+        self.rate = rate
+        self.period = period
+        self.length = length
+        self.params = params
+
+    def fires(self, n: int, rng: random.Random) -> bool:
+        if self.period and n % self.period < self.length:
+            return True
+        return self.rate > 0 and rng.random() < self.rate
+
+
+# Named scenarios (命名场景)
+SCENARIOS: Dict[str, List[FaultRule]] = {
+    "baseline": [],
+    "latency_spikes": [FaultRule("latency_spike", rate=0.1, seconds=2.0)],
+    "rate_limit_bursts": [FaultRule("rate_limit", period=100, length=25, retry_after=1)],
+    "server_errors": [FaultRule("server_error", rate=0.1)],
+    "truncated_bodies": [FaultRule("truncated", rate=0.1)],
+    "malformed_json": [FaultRule("malformed", rate=0.1)],
+    "slow_drip": [FaultRule("slow_drip", rate=0.2, seconds=3.0)],
+    "mixed": [
+        FaultRule("rate_limit", period=200, length=20, retry_after=1),
+        FaultRule("server_error", rate=0.03),
+        FaultRule("truncated", rate=0.02),
+        FaultRule("malformed", rate=0.02),
+        FaultRule("latency_spike", rate=0.05, seconds=2.0),
+        FaultRule("slow_drip", rate=0.05, seconds=2.0),
+    ],
+}
+
+
+class ChaosServer(StubServer):
+    """StubServer that injects faults into chat completion responses.
+    向聊天补全响应注入故障的StubServer。
+    """
+
+    def __init__(
+        self,
+        rules: List[FaultRule],
+        base_latency: float = 0.0,
+        seed: int = 0,
+        **kwargs
+    ):
+        """Initialize the chaos server.
+        初始化故障注入服务器。
+
+        Args:
+            rules: Fault rules, checked in order; the first one that fires applies
+                  故障规则，按顺序检查，第一个生效的规则被应用
+            base_latency: Seconds added to every response (每个响应附加的延迟秒数)
+            seed: Random seed for rate-based rules (按概率规则的随机种子)
+        """
+        super().__init__(**kwargs)
+        self.rules = rules
+        self.base_latency = base_latency
+        self.injected: Dict[str, int] = {}
+        self._rng = random.Random(seed)
+        self._counter = 0
+        self._chaos_lock = threading.Lock()
+
+    def handle(self, method: str, path: str, headers, body: bytes):
+        if not (method == "POST" and path.rstrip("/").endswith("/chat/completions")):
+            return super().handle(method, path, headers, body)
+
+        with self._chaos_lock:
+            n = self._counter
+            self._counter += 1
+            rule = next((r for r in self.rules if r.fires(n, self._rng)), None)
+            if rule:
+                self.injected[rule.kind] = self.injected.get(rule.kind, 0) + 1
+
+        if self.base_latency:
+            time.sleep(self.base_latency)
+        if rule is None:
+            return super().handle(method, path, headers, body)
+
+        if rule.kind == "rate_limit":
+            return 200, RawResponse(
+                429,
+                b'{"error": {"message": "Rate limit exceeded"}}',
+                headers={"Retry-After": str(rule.params.get("retry_after", 1))}
+            )
+        if rule.kind == "server_error":
+            return 200, RawResponse(rule.params.get("status", 503), b'{"error": {"message": "Upstream error"}}')
+
+        status, completion = super().handle(method, path, headers, body)
+        payload = json.dumps(completion).encode("utf-8")
+
+        if rule.kind == "latency_spike":
+            time.sleep(rule.params.get("seconds", 2.0))
+            return status, completion
+        if rule.kind == "truncated":
+            return 200, RawResponse(status, payload[:len(payload) // 2], declared_length=len(payload))
+        if rule.kind == "malformed":
+            return 200, RawResponse(status, payload[:-1] + b",}")
+        # slow_drip: spread the body over the configured duration (将响应体分散在配置的时长内发送)
+        pieces = 20
+        return 200, RawResponse(
+            status,
+            payload,
+            chunk_size=max(len(payload) // pieces, 1),
+            chunk_delay=rule.params.get("seconds", 3.0) / pieces
+        )
+
+
+def synthetic_windows(count: int, lines_per_window: int = 50) -> List:
+    """Build synthetic windows for load tests (为负载测试构建合成窗口)."""
+    line = "01-06 10:15:23.550  1234  1236 V AudioFlinger: obtainBuffer() success, buffer size: 4096"
+    return [(i, [line] * lines_per_window) for i in range(count)]
+
+
+def run_scenario(
+    name: str,
+    windows: List,
+    concurrency: int,
+    max_retries: int = 0,
+    timeout: int = 30,
+    base_latency: float = 0.05,
+    seed: int = 0
+) -> Dict[str, Any]:
+    """Run the load driver against one scenario and return its report.
+    针对一个场景运行负载驱动并返回报告。
+    """
+    with ChaosServer(SCENARIOS[name], base_latency=base_latency, seed=seed) as server:
+        client = BailianClient(
+            api_key="chaos",
+            base_url=server.base_url,
+            timeout=timeout,
+            max_retries=max_retries,
+            retry_backoff=0.2
+        )
+        report = run_windows(client, "System prompt", windows, concurrency)
+        report["requests_served"] = server._counter
+        report["faults_injected"] = dict(server.injected)
+    report["scenario"] = name
+    report["max_retries"] = max_retries
+    return report
+
+
+def main():
+    """Main entry point for the chaos load driver.
+    故障注入负载驱动的主入口点。
+    """
+    parser = argparse.ArgumentParser(
+        prog="python -m src.chaos",
+        description="Load-test BailianClient against a fault-injecting local server"
+                    "\n使用故障注入本地服务器对BailianClient进行负载测试"
+    )
+    parser.add_argument("--scenario", default="all",
+                        help=f"Scenario name or 'all' ({', '.join(SCENARIOS)}) (场景名称或all)")
+    parser.add_argument("--concurrency", type=int, default=64, help="In-flight requests (default: 64) (并发请求数)")
+    parser.add_argument("--windows", type=int, default=512, help="Windows per scenario (default: 512) (每个场景的窗口数)")
+    parser.add_argument("--retries", type=int, default=0, help="Client max_retries (default: 0) (客户端重试次数)")
+    parser.add_argument("--timeout", type=int, default=30, help="Client timeout seconds (default: 30) (客户端超时秒数)")
+    parser.add_argument("--base-latency", type=float, default=0.05,
+                        help="Server latency added to every response (default: 0.05) (每个响应的附加延迟)")
+    parser.add_argument("--seed", type=int, default=0, help="Random seed (随机种子)")
+    parser.add_argument("--json-out", default=None, help="Write reports as JSON to this path (将报告以JSON写入此路径)")
+    args = parser.parse_args()
+
+    names = list(SCENARIOS) if args.scenario == "all" else [args.scenario]
+    for name in names:
+        if name not in SCENARIOS:
+            print(f"Error: Unknown scenario: {name}", file=sys.stderr)
+            return 1
+
+    windows = synthetic_windows(args.windows)
+    reports = []
+    print(f"{'scenario':<20}{'win/s':>8}{'p50':>8}{'p95':>8}{'p99':>8}{'lost':>6}  errors")
+    for name in names:
+        report = run_scenario(
+            name, windows, args.concurrency, args.retries, args.timeout, args.base_latency, args.seed
+        )
+        reports.append(report)
+        latency = report["latency_s"]
+        print(f"{name:<20}{report['windows_per_s']:>8.1f}{latency['p50']:>8.2f}{latency['p95']:>8.2f}"
+              f"{latency['p99']:>8.2f}{report['lost_windows']:>6}  {report['errors']}")
+
+    if args.json_out:
+        with open(args.json_out, 'w', encoding='utf-8') as f:
+            json.dump(reports, f, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
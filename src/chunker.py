@@ -2,7 +2,7 @@
 日志分块工具 - 将日志分割成重叠的滑动窗口。
 """
 
-from typing import List, Tuple
+from typing import Iterable, Iterator, List, Tuple
 
 
 class LogChunker:
@@ -60,3 +60,52 @@ class LogChunker:
                 break
         
         return windows
+
+    def iter_windows(self, lines: Iterable[str]) -> Iterator[Tuple[int, List[str]]]:
+        """Yield the windows chunk_lines would produce while lines are still arriving.
+        在日志行仍在到达时产出chunk_lines将生成的窗口。
+        
+        Only the current window is held, so any number of lines can be chunked
+        in constant memory.
+        只保存当前窗口，因此可以在常数内存中对任意数量的行分块。
+        
+        Args:
+            lines: Log lines, e.g. a generator over a file (日志行，例如文件上的生成器)
+        """
+        step = self.chunk_size - self.overlap
+        window: List[str] = []
+        fresh = 0  # Lines not yet sent in any window (尚未出现在任何窗口中的行数)
+        window_idx = 0
+        for line in lines:
+            window.append(line)
+            fresh += 1
+            if len(window) == self.chunk_size:
+                yield window_idx, window
+                window_idx += 1
+                window = window[step:]
+                fresh = 0
+        # The tail is a window only if it holds lines no window had yet
+        # 只有包含尚未出现在任何窗口中的行时，尾部才构成窗口
+        if fresh:
+            yield window_idx, window
+
+    def window_spans(self, total_lines: int) -> List[Tuple[int, int, int]]:
+        """Line ranges of the windows chunk_lines would produce.
+        chunk_lines将生成的各窗口的行范围。
+        
+        Args:
+            total_lines: Number of lines that were chunked (被分块的行数)
+            
+        Returns:
+            List of tuples (window_index, start_line, end_line_exclusive)
+            元组列表 (窗口索引, 起始行, 结束行（不包含）)
+        """
+        spans = []
+        start = 0
+        while start < total_lines:
+            end = min(start + self.chunk_size, total_lines)
+            spans.append((len(spans), start, end))
+            if end == total_lines:
+                break
+            start += self.chunk_size - self.overlap
+        return spans
@@ -10,16 +10,38 @@ from datetime import datetime
 from pathlib import Path
 from typing import Optional
 
-from .bailian_client import BailianClient
+from .bailian_client import BailianClient, plan_packs
 from .log_parser import LogParser
 from .chunker import LogChunker
 from .masker import DataMasker
-from .analyzer import WindowAnalyzer
+from .metrics import summarize_usage
+from .analyzer import WindowAnalyzer, failed_window_result
+from .batch import BatchRunner
+from .cascade import CascadeRunner, TierStats, parse_tiers
+from .debug_archive import DebugArchive
+from .dedup import DEFAULT_THRESHOLD as DEFAULT_DEDUP_THRESHOLD, apply_reuse, plan_reuse
+from .dry_run import format_projection, plan_requests, project
+from .heuristics import DEFAULT_THRESHOLD, HeuristicClassifier
+from .journal import JOURNAL_NAME, JournalMismatch, ResultJournal, file_fingerprint, quick_fingerprint
+from .pipeline import Pipeline
+from .provenance import EvidenceIndex
+from .replay import ExchangeRecorder
+from .report_stream import COMPRESSIONS, ReportWriter, check_compression, report_path
+from .salience import SpendMeter, estimate_window_cost, find_gaps, plan_budget, refused_by_budget
+from .state_machine import AudioStateMachine
+from .summarize import HierarchicalSummarizer, load_reduce_prompt
+from .timeline import line_timeline
+from .tracing import NULL_TRACER, Tracer
+from .transition_search import TransitionSearch
 
 
-def load_system_prompt() -> str:
+def load_system_prompt(compact: bool = False) -> str:
     """Load system prompt from docs/prompt.md.
     从docs/prompt.md加载系统提示词。
+    
+    Args:
+        compact: Append the compact output mode from docs/prompt_compact.md
+                附加docs/prompt_compact.md中的紧凑输出模式说明
     """
     # Find prompt.md relative to this file
     # 查找相对于此文件的prompt.md
@@ -30,51 +52,363 @@ def load_system_prompt() -> str:
         raise FileNotFoundError(f"System prompt not found at {prompt_path}")
     
     with open(prompt_path, 'r', encoding='utf-8') as f:
-        return f.read()
+        prompt = f.read()
+    
+    if compact:
+        compact_path = current_dir / "docs" / "prompt_compact.md"
+        if not compact_path.exists():
+            raise FileNotFoundError(f"Compact prompt not found at {compact_path}")
+        with open(compact_path, 'r', encoding='utf-8') as f:
+            prompt += f.read()
+    
+    return prompt
 
 
-def save_debug_files(
-    output_dir: Path,
-    window_idx: int,
-    request_data: dict,
-    response_data: dict
-):
-    """Save request and response JSON for debugging.
-    保存请求和响应JSON用于调试。
+def archive_exchange(archive, client, windows, payload, result, line_count=None):
+    """Queue one request and its parsed result on the debug archive.
+    将一次请求及其解析结果加入调试归档队列。
+    """
+    archive.record(
+        windows, f"{client.base_url}/chat/completions", client._headers(), payload, result, line_count
+    )
+
+
+def close_archive(archive):
+    """Flush the debug archive, warning instead of failing the analysis if it broke.
+    写出调试归档；归档出错时仅警告而不使分析失败。
+    """
+    try:
+        archive.close()
+    except Exception as e:
+        print(f"Warning: debug archive is incomplete ({archive.dropped} exchanges dropped): {e}",
+              file=sys.stderr)
+
+
+def print_streamed_field(field, value):
+    """Show the state of a window as soon as it arrives in the stream.
+    流式响应中一旦收到状态立即显示。
+    """
+    if field == "final_state":
+        print(f"[{value}", end="", flush=True)
+    elif field == "confidence" and isinstance(value, (int, float)):
+        print(f" {value:.2f}]", end=" ", flush=True)
+
+
+def run_local_prefilter(windows, threshold):
+    """Decide obvious windows locally and return the rest for the LLM.
+    本地判定明显窗口，其余窗口交给大模型。
+    
+    Returns:
+        Tuple of (local results by window_idx, windows to escalate)
+        (按窗口索引的本地结果, 需交给大模型的窗口) 元组
+    """
+    classifier = HeuristicClassifier(threshold)
+    local_results = {}
+    for window_idx, window_lines in windows:
+        result = classifier.decide(window_lines)
+        if result is not None:
+            result["window_idx"] = window_idx
+            local_results[window_idx] = result
+    remaining = [w for w in windows if w[0] not in local_results]
+    print(f"Pre-classifier decided {len(local_results)} windows locally, "
+          f"{len(remaining)} escalated to the LLM (threshold={threshold})")
+    return local_results, remaining
+
+
+def run_online_analysis(client, system_prompt, windows, args, total=None, journal=None, archive=None):
+    """Analyze windows one request at a time.
+    逐个请求分析窗口。
+    
+    Args:
+        total: Window count shown in progress output, defaults to len(windows)
+              进度输出中显示的窗口总数，默认为len(windows)
+        journal: ResultJournal each result is appended to as it completes
+                每个结果完成后即追加写入的ResultJournal
+        archive: DebugArchive receiving each exchange with ``--debug`` (使用 ``--debug`` 时接收每次交互的DebugArchive)
+    
+    Returns:
+        Ordered list of window results (有序的窗口结果列表)
+    """
+    total = total or len(windows)
+    window_results = []
+    tracer = client.tracer
+    # Every window is ready when the stage starts (阶段开始时所有窗口均已就绪)
+    ready = tracer.now()
+    for window_idx, window_lines in windows:
+        print(f"Analyzing window {window_idx + 1}/{total}...", end=" ", flush=True)
+        
+        log_content = "\n".join(window_lines)
+        tracer.add_span("queue_wait", ready, tracer.now(), "window", {"window": window_idx})
+        with tracer.span("window", cat="window", window=window_idx) as span_args:
+            try:
+                # Analyze with LLM (使用大语言模型分析)
+                if getattr(args, "stream", False):
+                    result = client.analyze_log_window_stream(
+                        system_prompt,
+                        log_content,
+                        on_field=print_streamed_field,
+                        early_stop=getattr(args, "early_stop", False)
+                    )
+                else:
+                    result = client.analyze_log_window(system_prompt, log_content)
+                
+                # Add window index to result (将窗口索引添加到结果中)
+                result["window_idx"] = window_idx
+                window_results.append(result)
+                span_args["state"] = result["final_state"]
+                
+                print(f"✓ State: {result['final_state']} (confidence: {result['confidence']:.2f})")
+                
+                # Archive the exchange if requested (如果需要，归档本次交互)
+                if archive:
+                    archive_exchange(
+                        archive, client, [window_idx],
+                        client.build_payload(system_prompt, log_content), result, len(window_lines)
+                    )
+            
+            except Exception as e:
+                print(f"✗ Error: {e}")
+                span_args["error"] = str(e)
+                # Add failed result (添加失败的结果)
+                window_results.append(failed_window_result(
+                    window_idx, str(e), ["Retry analysis", "Check API connectivity"]
+                ))
+        if journal:
+            journal.append(window_results[-1])
+    
+    return window_results
+
+
+def run_packed_analysis(client, system_prompt, windows, args, journal=None, archive=None):
+    """Analyze consecutive windows several at a time in packed requests.
+    以打包请求一次分析多个连续窗口。
+    
+    Windows whose packed result is missing or invalid are retried as
+    single-window requests.
+    打包结果缺失或无效的窗口会以单窗口请求重试。
+    
+    Returns:
+        Ordered list of window results (有序的窗口结果列表)
+    """
+    packs = plan_packs(windows, system_prompt, args.pack, getattr(args, "pack_max_tokens", 6000))
+    print(f"Packed {len(windows)} windows into {len(packs)} requests")
+    
+    window_results = []
+    fallbacks = []
+    for pack_no, pack in enumerate(packs, 1):
+        if len(pack) == 1:
+            window_results.extend(
+                run_online_analysis(client, system_prompt, pack, args, len(windows), journal, archive)
+            )
+            continue
+        
+        first, last = pack[0][0], pack[-1][0]
+        print(f"Analyzing windows {first + 1}-{last + 1}/{len(windows)} (pack {pack_no}/{len(packs)})...",
+              end=" ", flush=True)
+        try:
+            results = client.analyze_log_windows_packed(system_prompt, pack)
+            print(f"✓ {len(results)}/{len(pack)} windows valid")
+        except Exception as e:
+            print(f"✗ Packed response rejected: {e}")
+            results = {}
+        fallbacks.extend(window_idx for window_idx, _ in pack if window_idx not in results)
+        if archive and results:
+            # One record for the whole pack, indexed under each answered window
+            # 整个打包请求存为一条记录，并在每个已回答的窗口下建立索引
+            archive_exchange(
+                archive, client, sorted(results), client.build_packed_payload(system_prompt, pack), results
+            )
+        
+        for window_idx, window_lines in pack:
+            if window_idx in results:
+                window_results.append(results[window_idx])
+                if journal:
+                    journal.append(results[window_idx])
+            else:
+                window_results.extend(
+                    run_online_analysis(
+                        client, system_prompt, [(window_idx, window_lines)], args, len(windows), journal, archive
+                    )
+                )
+    
+    if fallbacks:
+        print(f"{len(fallbacks)} windows fell back to single-window requests")
+    return window_results
+
+
+def run_batch_analysis(client, system_prompt, windows, out_dir, args, journal=None, archive=None):
+    """Analyze all windows through the Batch API, resuming a saved batch if present.
+    通过Batch API分析所有窗口，如存在已保存的批处理则继续。
     
     Args:
-        output_dir: Output directory (should be out/debug/)
-                   输出目录（应为out/debug/）
-        window_idx: Window index (窗口索引)
-        request_data: Request data to save (will redact auth)
-                     要保存的请求数据（会隐藏授权信息）
-        response_data: Response data to save (要保存的响应数据)
+        journal: ResultJournal the results are appended to as soon as the batch
+                 output is read (批处理输出读取后立即追加结果的ResultJournal)
+        archive: DebugArchive receiving each window's batch request body and result
+                 with ``--debug`` (使用 ``--debug`` 时接收每个窗口的批处理请求体和结果的DebugArchive)
+    
+    Returns:
+        Ordered list of window results (有序的窗口结果列表)
     """
-    debug_dir = output_dir / "debug"
-    debug_dir.mkdir(parents=True, exist_ok=True)
+    runner = BatchRunner(
+        client,
+        out_dir,
+        poll_interval=getattr(args, "batch_poll_interval", 30.0)
+    )
     
-    # Redact authorization header from request
-    # 从请求中隐藏授权头
-    if "headers" in request_data:
-        headers = request_data["headers"].copy()
-        if "Authorization" in headers:
-            headers["Authorization"] = "[REDACTED]"
-        request_data = {**request_data, "headers": headers}
+    state = runner.load_state()
+    if state and state.get("batch_id"):
+        print(f"Found saved batch {state['batch_id']} ({state.get('status')})")
+    print(f"Running {len(windows)} windows as a batch job...")
     
-    # Save request (保存请求)
-    request_file = debug_dir / f"window_{window_idx}_request.json"
-    with open(request_file, 'w', encoding='utf-8') as f:
-        json.dump(request_data, f, indent=2)
+    def on_status(batch):
+        counts = batch.get("request_counts") or {}
+        print(f"Batch {batch.get('id')}: {batch.get('status')} "
+              f"({counts.get('completed', 0)}/{counts.get('total', len(windows))})")
     
-    # Save response (保存响应)
-    response_file = debug_dir / f"window_{window_idx}_response.json"
-    with open(response_file, 'w', encoding='utf-8') as f:
-        json.dump(response_data, f, indent=2)
+    window_results = runner.run(system_prompt, windows, on_status=on_status)
+    if journal:
+        for result in window_results:
+            journal.append(result)
+    if archive:
+        lines = dict(windows)
+        for result in window_results:
+            if not result.get("error"):
+                window_lines = lines[result["window_idx"]]
+                archive_exchange(
+                    archive, client, [result["window_idx"]],
+                    client.build_payload(system_prompt, "\n".join(window_lines)), result, len(window_lines)
+                )
+    failed = sum(1 for r in window_results if r["reason"].startswith("Analysis failed"))
+    print(f"Batch finished: {len(window_results) - failed} windows analyzed, {failed} failed")
+    return window_results
+
+
+def run_transition_search(client, system_prompt, windows, args, total=None, journal=None, archive=None):
+    """Analyze a sparse sample of windows and bisect between disagreeing samples.
+    分析稀疏采样的窗口，并在结论不一致的采样点之间二分。
+    
+    Args:
+        journal: ResultJournal each analyzed window is appended to as it completes;
+                 inferred windows are not journaled
+                 每个已分析窗口完成后即追加到的ResultJournal；推断的窗口不写入日志
+        archive: DebugArchive receiving each analyzed window's exchange with ``--debug``
+                 (使用 ``--debug`` 时接收每个已分析窗口交互的DebugArchive)
+    
+    Returns:
+        Tuple of (ordered window results, search statistics)
+        (有序的窗口结果, 搜索统计) 元组
+    """
+    total = total or len(windows)
+    
+    def analyze(window_idx, window_lines):
+        log_content = "\n".join(window_lines)
+        try:
+            result = client.analyze_log_window(system_prompt, log_content)
+            result["window_idx"] = window_idx
+            if archive:
+                archive_exchange(
+                    archive, client, [window_idx],
+                    client.build_payload(system_prompt, log_content), result, len(window_lines)
+                )
+        except Exception as e:
+            result = failed_window_result(window_idx, str(e), ["Retry analysis", "Check API connectivity"])
+        if journal:
+            journal.append(result)
+        print(f"Window {window_idx + 1}/{total}: {result['final_state']} (confidence: {result['confidence']:.2f})")
+        return result
+    
+    search = TransitionSearch(analyze, stride=getattr(args, "search_stride", None) or None)
+    window_results = search.run(windows)
+    print(f"Transition search: {search.calls} calls in {search.rounds} rounds for {len(windows)} windows")
+    return window_results, {"calls": search.calls, "rounds": search.rounds, "windows": len(windows)}
+
+
+def run_cascade_analysis(client, system_prompt, windows, args, total=None, journal=None, archive=None):
+    """Analyze windows with cascading model tiers.
+    使用级联模型层级分析窗口。
+    
+    Tier clients share the main client's key, schema and retry settings.
+    各层级客户端共享主客户端的密钥、响应模式和重试设置。
+    
+    Args:
+        journal: ResultJournal each window is appended to once its verdict is final
+                 (窗口结论确定后即追加到的ResultJournal)
+        archive: DebugArchive receiving every tier's exchange with ``--debug``
+                 (使用 ``--debug`` 时接收每个层级交互的DebugArchive)
+    
+    Returns:
+        Tuple of (ordered window results, per-tier statistics)
+        (有序的窗口结果, 各层级统计) 元组
+    """
+    total = total or len(windows)
+    clients = []
+    stats = []
+    for model, base_url in parse_tiers(args.cascade):
+        tier_stats = TierStats(model, forward=client.recorder)
+        clients.append(BailianClient(
+            api_key=client.api_key,
+            base_url=base_url or client.base_url,
+            model=model,
+            timeout=client.timeout,
+            compact=client.compact,
+            recorder=tier_stats,
+            max_retries=client.max_retries,
+            retry_backoff=client.retry_backoff,
+            serialize=client.serialize,
+            tracer=client.tracer,
+            spend=client.spend
+        ))
+        stats.append(tier_stats)
+    
+    lines = dict(windows)
+    
+    def on_result(tier, result):
+        print(f"[tier {tier} {clients[tier].model}] window {result['window_idx'] + 1}/{total}: "
+              f"{result['final_state']} (confidence: {result['confidence']:.2f})")
+        if archive and not result.get("error"):
+            window_lines = lines[result["window_idx"]]
+            archive_exchange(
+                archive, clients[tier], [result["window_idx"]],
+                clients[tier].build_payload(system_prompt, "\n".join(window_lines)), result, len(window_lines)
+            )
+    
+    runner = CascadeRunner(clients, stats, getattr(args, "cascade_threshold", 0.8))
+    window_results = runner.run(
+        system_prompt, windows, on_result=on_result, on_final=journal.append if journal else None
+    )
+    escalated = sum(1 for r in window_results if r["tier"] > 0)
+    print(f"Cascade finished: {escalated}/{len(windows)} windows escalated beyond tier 0")
+    return window_results, [s.to_dict() for s in stats]
 
 
 def analyze_command(args):
     """Execute the analyze command.
     执行分析命令。
+    
+    With ``--trace``, the run's spans are written as Chrome trace JSON even
+    when the analysis fails.
+    使用 ``--trace`` 时，即使分析失败，本次运行的跨度也会以Chrome trace JSON写出。
+    """
+    trace_path = getattr(args, "trace", None)
+    tracer = Tracer() if trace_path else NULL_TRACER
+    try:
+        with tracer.span("analyze"):
+            return run_analyze(args, tracer)
+    finally:
+        if trace_path:
+            tracer.write(trace_path)
+            stages = ", ".join(f"{name} {seconds:.2f}s" for name, seconds in tracer.stage_totals().items())
+            print(f"Trace saved to: {trace_path} ({stages})")
+
+
+# Options that each pick how windows are sent; at most one may be given
+# 各自决定窗口发送方式的选项；最多只能指定一个
+EXECUTION_MODES = ("batch", "search", "cascade")
+
+
+def run_analyze(args, tracer):
+    """Run the analysis with stages recorded on ``tracer``.
+    运行分析，并在 ``tracer`` 上记录各阶段。
     """
     # Validate input file (验证输入文件)
     log_path = Path(args.log)
@@ -82,13 +416,44 @@ def analyze_command(args):
         print(f"Error: Log file not found: {args.log}", file=sys.stderr)
         return 1
     
+    modes = [f"--{name}" for name in EXECUTION_MODES if getattr(args, name, None)]
+    if getattr(args, "pack", 1) > 1:
+        modes.append("--pack")
+    if len(modes) > 1:
+        print(f"Error: {' and '.join(modes)} cannot be combined; choose one execution mode", file=sys.stderr)
+        return 1
+    # Only single-window online requests can be streamed (只有单窗口在线请求可以流式传输)
+    if getattr(args, "stream", False) and modes:
+        print(f"Error: --stream cannot be combined with {modes[0]}; it applies to online and --pipeline runs",
+              file=sys.stderr)
+        return 1
+    
     # Create output directory (创建输出目录)
     out_dir = Path(args.out)
     out_dir.mkdir(parents=True, exist_ok=True)
     
-    # Initialize components (初始化组件)
+    # Check the report compression before any work is done (在开始工作前检查报告压缩方式)
+    if getattr(args, "report_compression", None):
+        try:
+            check_compression(args.report_compression)
+        except ValueError as e:
+            print(f"Error: {e}", file=sys.stderr)
+            return 1
+    
+    # Initialize components; a dry run never sends, so needs no API key
+    # 初始化组件；试运行从不发送请求，因此不需要API密钥
+    dry_run = getattr(args, "dry_run", False)
     try:
-        client = BailianClient(model=args.model)
+        record_path = getattr(args, "record", None)
+        client = BailianClient(
+            api_key="dry-run" if dry_run else None,
+            model=args.model,
+            compact=getattr(args, "compact", False),
+            recorder=ExchangeRecorder(Path(record_path)) if record_path and not dry_run else None,
+            max_retries=getattr(args, "retries", 0),
+            serialize=getattr(args, "serialize", False),
+            tracer=tracer
+        )
     except ValueError as e:
         print(f"Error: {e}", file=sys.stderr)
         print("Please set BAILIAN_API_KEY environment variable", file=sys.stderr)
@@ -101,89 +466,210 @@ def analyze_command(args):
     
     # Load system prompt (加载系统提示词)
     try:
-        system_prompt = load_system_prompt()
+        system_prompt = load_system_prompt(compact=getattr(args, "compact", False))
     except FileNotFoundError as e:
         print(f"Error: {e}", file=sys.stderr)
         return 1
     
+    if getattr(args, "pipeline", False):
+        return run_pipelined_analysis(
+            args, client, system_prompt, parser, chunker, analyzer, masker, log_path, out_dir, tracer
+        )
+    
     print(f"Parsing log file: {args.log}")
     
     # Parse and filter log file (解析和过滤日志文件)
-    lines = parser.parse_and_filter(str(log_path))
+    # Provenance keeps each line's file position and timestamp (来源记录保存每行的文件位置和时间戳)
+    with tracer.span("parse_file") as span_args:
+        lines, provenance = parser.parse_file_with_provenance(str(log_path))
+        span_args["lines"] = len(lines)
+    with tracer.span("filter_audio_lines") as span_args:
+        lines, provenance = parser.filter_with_provenance(lines, provenance)
+        span_args["lines"] = len(lines)
     print(f"Found {len(lines)} audio-related lines")
     
     # Apply masking if requested (如果需要，应用数据脱敏)
     if masker:
         print("Applying data masking...")
-        lines = masker.mask_lines(lines)
+        with tracer.span("mask_lines"):
+            lines = masker.mask_lines(lines)
     
     # Chunk the lines (对日志行进行分块)
-    windows = chunker.chunk_lines(lines)
+    with tracer.span("chunk_lines") as span_args:
+        windows = chunker.chunk_lines(lines)
+        span_args["windows"] = len(windows)
     print(f"Split into {len(windows)} windows (chunk_size={args.chunk_size}, overlap={args.overlap})")
     
-    # Analyze each window (分析每个窗口)
-    window_results = []
-    for window_idx, window_lines in windows:
-        print(f"Analyzing window {window_idx + 1}/{len(windows)}...", end=" ", flush=True)
-        
-        log_content = "\n".join(window_lines)
-        
-        try:
-            # Analyze with LLM (使用大语言模型分析)
-            result = client.analyze_log_window(system_prompt, log_content)
-            
-            # Add window index to result (将窗口索引添加到结果中)
-            result["window_idx"] = window_idx
-            window_results.append(result)
-            
-            print(f"✓ State: {result['final_state']} (confidence: {result['confidence']:.2f})")
-            
-            # Save debug files if requested (如果需要，保存调试文件)
-            if args.debug:
-                # Prepare request data for debug output
-                # 准备调试输出的请求数据
-                request_data = {
-                    "url": f"{client.base_url}/chat/completions",
-                    "headers": {
-                        "Authorization": f"Bearer {client.api_key}",
-                        "Content-Type": "application/json"
-                    },
-                    "payload": {
-                        "model": client.model,
-                        "messages": [
-                            {"role": "system", "content": system_prompt},
-                            {"role": "user", "content": f"Analyze this log window:\n\n{log_content}"}
-                        ],
-                        "temperature": 0.1,
-                        "response_format": {"type": "json_object"}
-                    }
-                }
-                
-                # For response, we save the parsed result
-                # 对于响应，我们保存解析后的结果
-                response_data = {
-                    "parsed_result": result,
-                    "window_lines_count": len(window_lines)
-                }
-                
-                save_debug_files(out_dir, window_idx, request_data, response_data)
-        
-        except Exception as e:
-            print(f"✗ Error: {e}")
-            # Add failed result (添加失败的结果)
-            window_results.append({
-                "window_idx": window_idx,
-                "final_state": "UNKNOWN",
-                "confidence": 0.0,
-                "reason": f"Analysis failed: {str(e)}",
-                "evidence": [],
-                "next_actions": ["Retry analysis", "Check API connectivity"]
-            })
+    # Decide obvious windows without the LLM (无需大模型判定明显窗口)
+    local_results = {}
+    llm_windows = windows
+    if getattr(args, "prefilter", False):
+        with tracer.span("prefilter"):
+            local_results, llm_windows = run_local_prefilter(
+                windows, getattr(args, "prefilter_threshold", DEFAULT_THRESHOLD)
+            )
     
-    # Merge segments (合并片段)
-    print("\nMerging consecutive windows with same state...")
-    segments = analyzer.merge_windows(window_results)
-    print(f"Created {len(segments)} merged segments")
+    # Reuse results for near-duplicate windows (为近重复窗口复用结果)
+    duplicates = {}
+    if getattr(args, "dedup", False):
+        with tracer.span("dedup"):
+            llm_windows, duplicates = plan_reuse(
+                llm_windows, getattr(args, "dedup_threshold", DEFAULT_DEDUP_THRESHOLD)
+            )
+        print(f"Near-duplicate detection: {len(duplicates)} windows will reuse earlier results, "
+              f"{len(llm_windows)} to analyze")
+    
+    # Keep the most salient windows within the budget (在预算内保留最显著的窗口)
+    max_calls = getattr(args, "max_calls", None)
+    max_cost = getattr(args, "max_cost", None)
+    budget = None
+    if max_calls is not None or max_cost is not None:
+        with tracer.span("budget"):
+            llm_windows, budget = plan_budget(
+                llm_windows, max_calls, max_cost,
+                cost_fn=lambda window_lines: estimate_window_cost(client.model, system_prompt, window_lines)
+            )
+        print(f"Budget: analyzing the {len(llm_windows)} most salient windows "
+              f"(estimated cost ¥{budget['estimated_cost']:.4f})")
+        if max_cost is not None:
+            # The estimate picks the windows; actual spend is enforced per request
+            # 估算用于选择窗口；实际花费在每个请求时执行上限
+            client.spend = SpendMeter(max_cost)
+    
+    # Project calls, tokens, cost and time instead of analyzing (预估调用数、token、成本和耗时而不进行分析)
+    if dry_run:
+        model = parse_tiers(args.cascade)[0][0] if getattr(args, "cascade", None) else client.model
+        requests = plan_requests(
+            client, system_prompt, llm_windows,
+            getattr(args, "pack", 1), getattr(args, "pack_max_tokens", 6000)
+        )
+        projection = project(
+            requests, model,
+            compact=getattr(args, "compact", False),
+            rpm=getattr(args, "rpm", None)
+        )
+        projection.update({
+            "total_lines": len(lines),
+            "total_windows": len(windows),
+            "locally_decided_windows": len(local_results),
+            "reused_windows": len(duplicates)
+        })
+        print(format_projection(projection))
+        if getattr(args, "search", False):
+            print("Note: --search analyzes only sampled windows, so this is an upper bound")
+        if getattr(args, "cascade", None):
+            print("Note: escalations to higher tiers are not included")
+        with open(out_dir / "dry_run.json", 'w', encoding='utf-8') as f:
+            json.dump(projection, f, indent=2)
+        return 0
+    
+    # Journal results as windows complete; --resume carries finished ones over
+    # 窗口完成后即写入日志；--resume 沿用已完成的窗口
+    journal = ResultJournal(out_dir / JOURNAL_NAME)
+    try:
+        resumed = journal.start({
+            "fingerprint": file_fingerprint(str(log_path)),
+            "fingerprint_scheme": "sha256",
+            "chunk_size": args.chunk_size,
+            "overlap": args.overlap,
+            "masking_enabled": args.mask,
+            "log_file": str(log_path.absolute()),
+            "model": client.model,
+            "compact": client.compact,
+            "serialize": client.serialize
+        }, resume=getattr(args, "resume", False))
+    except JournalMismatch as e:
+        print(f"Error: {e}", file=sys.stderr)
+        print("Run without --resume to start over", file=sys.stderr)
+        return 1
+    carried = []
+    if resumed and getattr(args, "search", False):
+        print("Note: --search samples windows adaptively, so journaled results are not reused")
+    elif resumed:
+        carried = [resumed[window_idx] for window_idx, _ in llm_windows if window_idx in resumed]
+        llm_windows = [(idx, window_lines) for idx, window_lines in llm_windows if idx not in resumed]
+        print(f"Resuming: {len(carried)} windows already analyzed, {len(llm_windows)} to go")
+    
+    # Capture exchanges for debugging on a background writer (在后台写入线程中捕获调试交互)
+    archive = DebugArchive(out_dir / "debug") if args.debug else None
+    
+    # Analyze windows (分析窗口)
+    tier_stats = None
+    search_stats = None
+    with tracer.span("analyze_windows", windows=len(llm_windows)):
+        if not llm_windows:
+            window_results = []
+        elif getattr(args, "batch", False):
+            try:
+                window_results = run_batch_analysis(
+                    client, system_prompt, llm_windows, out_dir, args, journal, archive
+                )
+            except Exception as e:
+                journal.close()
+                if archive:
+                    close_archive(archive)
+                print(f"Error: Batch analysis failed: {e}", file=sys.stderr)
+                print("Re-run the same command to resume polling (or resubmit a failed batch)", file=sys.stderr)
+                return 1
+        elif getattr(args, "search", False):
+            window_results, search_stats = run_transition_search(
+                client, system_prompt, llm_windows, args, len(windows), journal, archive
+            )
+        elif getattr(args, "cascade", None):
+            window_results, tier_stats = run_cascade_analysis(
+                client, system_prompt, llm_windows, args, len(windows), journal, archive
+            )
+        elif getattr(args, "pack", 1) > 1:
+            window_results = run_packed_analysis(client, system_prompt, llm_windows, args, journal, archive)
+        else:
+            window_results = run_online_analysis(
+                client, system_prompt, llm_windows, args, len(windows), journal, archive
+            )
+    journal.close()
+    if archive:
+        close_archive(archive)
+    if client.spend:
+        # Windows refused by the spend cap are unanalyzed gaps, not failures
+        # 被花费上限拒绝的窗口是未分析区间，而非失败
+        refused = [r for r in window_results if refused_by_budget(r)]
+        window_results = [r for r in window_results if not refused_by_budget(r)]
+        budget.update(client.spend.to_dict())
+        if refused:
+            print(f"Budget: actual spend reached ¥{client.spend.spent:.4f}; "
+                  f"{len(refused)} windows were not sent")
+    if carried:
+        window_results = sorted(carried + window_results, key=lambda r: r["window_idx"])
+    
+    if duplicates:
+        window_results = apply_reuse(window_results, duplicates)
+    
+    if budget is not None:
+        window_results.sort(key=lambda r: r["window_idx"])
+        budget["unanalyzed_gaps"] = find_gaps(
+            [idx for idx, _ in windows],
+            [r["window_idx"] for r in window_results] + list(local_results)
+        )
+    
+    if local_results:
+        for result in window_results:
+            result.setdefault("decided_by", "llm")
+        window_results = sorted(
+            window_results + list(local_results.values()), key=lambda r: r["window_idx"]
+        )
+    
+    # Cross-check against the rule-based state machine (与基于规则的状态机交叉校验)
+    cross_check = None
+    if getattr(args, "engine", False):
+        with tracer.span("state_machine"):
+            engine = AudioStateMachine()
+            timeline = engine.run(lines)
+            cross_check = analyzer.cross_check(
+                window_results, engine.window_states(chunker.window_spans(len(lines)))
+            )
+        with open(out_dir / "timeline.json", 'w', encoding='utf-8') as f:
+            json.dump({"timeline": timeline, "final": engine.snapshot()}, f, indent=2)
+        print(f"State machine: {len(timeline)} transitions, "
+              f"{cross_check['agreements']}/{cross_check['compared']} windows agree")
     
     # Generate reports (生成报告)
     metadata = {
@@ -191,28 +677,288 @@ def analyze_command(args):
         "timestamp": datetime.now().isoformat(),
         "chunk_size": args.chunk_size,
         "overlap": args.overlap,
-        "model": client.model,
+        "model": getattr(args, "cascade", None) or client.model,
         "masking_enabled": args.mask,
+        "execution_mode": modes[0][len("--"):] if modes else "online",
+        "pack_size": getattr(args, "pack", 1),
+        "streaming": getattr(args, "stream", False),
+        "compact_schema": getattr(args, "compact", False),
+        "serialized_windows": getattr(args, "serialize", False),
+        "early_stop": getattr(args, "early_stop", False),
+        "prefilter_threshold": (
+            getattr(args, "prefilter_threshold", DEFAULT_THRESHOLD) if getattr(args, "prefilter", False) else None
+        ),
+        "locally_decided_windows": sorted(local_results),
+        "state_machine": getattr(args, "engine", False),
+        "dedup": {
+            "threshold": getattr(args, "dedup_threshold", DEFAULT_DEDUP_THRESHOLD),
+            "reused_windows": sorted(duplicates),
+            "calls_avoided": len(duplicates)
+        } if getattr(args, "dedup", False) else None,
+        "transition_search": search_stats,
+        "budget": budget,
+        "cascade_threshold": getattr(args, "cascade_threshold", 0.8) if tier_stats else None,
+        "tier_stats": tier_stats,
+        "resumed_windows": len(carried),
         "total_windows": len(windows),
         "total_lines": len(lines)
     }
+    return finish_analysis(
+        args, client, analyzer, window_results, metadata, out_dir, tracer, archive,
+        cross_check=cross_check, split_on_gaps=budget is not None, lines=lines, provenance=provenance
+    )
+
+
+# Options that need every window before analysis starts (需要在分析开始前得到全部窗口的选项)
+PIPELINE_CONFLICTS = ("batch", "search", "cascade", "prefilter", "dedup", "max_calls", "max_cost", "engine", "dry_run")
+
+
+def run_pipelined_analysis(args, client, system_prompt, parser, chunker, analyzer, masker, log_path, out_dir, tracer):
+    """Read, mask and analyze concurrently through bounded queues.
+    通过有界队列并发地读取、脱敏和分析。
+    
+    Returns:
+        Exit code (退出码)
+    """
+    conflicts = [f"--{name.replace('_', '-')}" for name in PIPELINE_CONFLICTS if getattr(args, name, None)]
+    if getattr(args, "pack", 1) > 1:
+        conflicts.append("--pack")
+    if conflicts:
+        print(f"Error: --pipeline cannot be combined with {', '.join(conflicts)}", file=sys.stderr)
+        return 1
+    
+    # The quick fingerprint avoids reading the whole file before the first request
+    # 快速指纹避免在第一个请求前读完整个文件
+    journal = ResultJournal(out_dir / JOURNAL_NAME)
+    try:
+        resumed = journal.start({
+            "fingerprint": quick_fingerprint(str(log_path)),
+            "fingerprint_scheme": "quick",
+            "chunk_size": args.chunk_size,
+            "overlap": args.overlap,
+            "masking_enabled": args.mask,
+            "log_file": str(log_path.absolute()),
+            "model": client.model,
+            "compact": client.compact,
+            "serialize": client.serialize
+        }, resume=getattr(args, "resume", False))
+    except JournalMismatch as e:
+        print(f"Error: {e}", file=sys.stderr)
+        print("Run without --resume to start over", file=sys.stderr)
+        return 1
+    archive = DebugArchive(out_dir / "debug") if args.debug else None
+    
+    def analyze(window_idx, window_lines):
+        if window_idx in resumed:
+            return resumed[window_idx]
+        log_content = "\n".join(window_lines)
+        with tracer.span("window", cat="window", window=window_idx) as span_args:
+            try:
+                if getattr(args, "stream", False):
+                    result = client.analyze_log_window_stream(
+                        system_prompt, log_content, early_stop=getattr(args, "early_stop", False)
+                    )
+                else:
+                    result = client.analyze_log_window(system_prompt, log_content)
+                result["window_idx"] = window_idx
+                span_args["state"] = result["final_state"]
+                if archive:
+                    archive_exchange(
+                        archive, client, [window_idx],
+                        client.build_payload(system_prompt, log_content), result, len(window_lines)
+                    )
+            except Exception as e:
+                span_args["error"] = str(e)
+                result = failed_window_result(window_idx, str(e), ["Retry analysis", "Check API connectivity"])
+        return result
+    
+    # Segments are merged and reported as soon as their boundaries are confirmed
+    # 片段边界一经确认即合并并输出
+    segments = []
     
-    # JSON report (JSON报告)
-    report = analyzer.generate_report(segments, window_results, metadata)
-    json_path = out_dir / "report.json"
-    with open(json_path, 'w', encoding='utf-8') as f:
-        json.dump(report, f, indent=2)
-    print(f"JSON report saved to: {json_path}")
+    def on_segment(segment):
+        segments.append(segment)
+        print(f"Segment: {segment.state} windows {segment.start_window}-{segment.end_window}")
+    
+    merger = analyzer.online_merger(on_segment=on_segment)
+    
+    window_results = []
+    
+    def on_result(result):
+        window_results.append(result)
+        merger.add(result)
+        if result["window_idx"] in resumed:
+            return
+        journal.append(result)
+        if result.get("error"):
+            print(f"Window {result['window_idx'] + 1}: ✗ Error: {result['error']}")
+        else:
+            print(f"Window {result['window_idx'] + 1}: ✓ State: {result['final_state']} "
+                  f"(confidence: {result['confidence']:.2f})")
+    
+    pipeline = Pipeline(
+        analyze, chunker, parser, masker,
+        workers=getattr(args, "workers", 4),
+        mask_workers=getattr(args, "mask_workers", 2),
+        queue_size=getattr(args, "queue_size", 64),
+        reorder_limit=getattr(args, "reorder_limit", None),
+        tracer=tracer
+    )
+    print(f"Analyzing {args.log} in a pipeline ({pipeline.workers} requests in flight)")
+    try:
+        with tracer.span("pipeline"):
+            pipeline.run(str(log_path), on_result=on_result)
+    finally:
+        journal.close()
+        if archive:
+            close_archive(archive)
+    window_results.sort(key=lambda r: r["window_idx"])
+    merger.finish()
+    stats = {**pipeline.stats(), "max_reorder_buffer": merger.max_pending}
+    print(f"Pipeline: {stats['lines']} audio-related lines, {stats['windows']} windows, "
+          f"first request after {stats['first_request_s'] or 0:.2f}s, peak queue depths {stats['max_queue_depth']}")
+    
+    metadata = {
+        "log_file": str(log_path.absolute()),
+        "timestamp": datetime.now().isoformat(),
+        "chunk_size": args.chunk_size,
+        "overlap": args.overlap,
+        "model": client.model,
+        "masking_enabled": args.mask,
+        "execution_mode": "pipeline",
+        "streaming": getattr(args, "stream", False),
+        "compact_schema": getattr(args, "compact", False),
+        "serialized_windows": getattr(args, "serialize", False),
+        "early_stop": getattr(args, "early_stop", False),
+        "pipeline": stats,
+        "resumed_windows": sum(1 for r in window_results if r["window_idx"] in resumed),
+        "total_windows": stats["windows"],
+        "total_lines": stats["lines"]
+    }
+    return finish_analysis(
+        args, client, analyzer, window_results, metadata, out_dir, tracer, archive, segments=segments
+    )
+
+
+def finish_analysis(
+    args, client, analyzer, window_results, metadata, out_dir, tracer, archive,
+    cross_check=None, split_on_gaps=False, segments=None, lines=None, provenance=None
+):
+    """Summarize, merge and write the reports of an analysis.
+    对分析结果进行归约、合并并写出报告。
+    
+    Args:
+        metadata: Run metadata; summary and usage fields are added here
+                 运行元数据；归约和用量字段在此添加
+        cross_check: Rule-based engine cross-check summary (基于规则引擎的交叉校验摘要)
+        split_on_gaps: Never merge across unanalyzed windows (不跨越未分析的窗口合并)
+        segments: Segments already merged online, skipping merge_windows (已在线合并的片段，跳过merge_windows)
+        lines: Filtered log lines as sent, for resolving evidence (发送的过滤后日志行，用于解析证据)
+        provenance: File positions and timestamps of the lines (各行的文件位置和时间戳)
+    
+    Returns:
+        Exit code (退出码)
+    """
+    # Reduce window results into a whole-log diagnosis (将窗口结果归约为整份日志诊断)
+    summary_tree = None
+    if getattr(args, "summarize", False):
+        try:
+            summarizer = HierarchicalSummarizer(
+                client,
+                load_reduce_prompt(),
+                fan_in=getattr(args, "summary_fan_in", 16),
+                concurrency=getattr(args, "summary_concurrency", 8)
+            )
+        except (FileNotFoundError, ValueError) as e:
+            print(f"Error: {e}", file=sys.stderr)
+            return 1
+        print("\nSummarizing the whole log...")
+        with tracer.span("summarize"):
+            summary_tree = summarizer.run(
+                window_results,
+                on_level=lambda level, groups: print(f"  Level {level}: {groups} reduction requests")
+            )
+        with open(out_dir / "summary_tree.json", 'w', encoding='utf-8') as f:
+            json.dump(summary_tree, f, indent=2, ensure_ascii=False)
+        if summary_tree["diagnosis"]:
+            print(f"Diagnosis: {summary_tree['diagnosis']['final_state']} - {summary_tree['diagnosis']['summary']}")
+    
+    # Merge segments (合并片段)
+    if segments is None:
+        print("\nMerging consecutive windows with same state...")
+        with tracer.span("merge_windows"):
+            segments = analyzer.merge_windows(window_results, split_on_gaps=split_on_gaps)
+    print(f"Created {len(segments)} merged segments")
+    
+    # Map segments back to time ranges and file positions (将片段映射回时间范围和文件位置)
+    spans = LogChunker(args.chunk_size, args.overlap).window_spans(metadata["total_lines"])
+    if provenance is not None:
+        with tracer.span("locate_segments"):
+            analyzer.locate_segments(
+                segments, spans, provenance, EvidenceIndex(lines, provenance) if lines is not None else None
+            )
+    
+    # Reconcile overlapping windows into a line-level timeline (将重叠窗口调和为行级时间线)
+    with tracer.span("line_timeline"):
+        timeline = line_timeline(
+            window_results, spans,
+            timestamp_of=provenance.timestamp if provenance is not None else None,
+            source_line_of=provenance.line_numbers.__getitem__ if provenance is not None else None
+        )
+    print(f"Line timeline: {len(timeline['entries'])} runs, {len(timeline['transitions'])} transitions")
+    
+    metadata.update({
+        "summary_levels": len(summary_tree["levels"]) if summary_tree else None,
+        "summary_calls": summary_tree["calls"] if summary_tree else None,
+        # Reduction calls are paid for too (归约调用同样计费)
+        "usage": summarize_usage(window_results + (summary_tree["usage"] if summary_tree else []))
+    })
+    
+    usage = metadata["usage"]
+    if usage["calls"]:
+        print(f"Usage: {usage['calls']} calls, {usage['total_tokens']:,} tokens, "
+              f"p95 {usage['latency_s']['p95']:.2f}s, ~¥{usage['cost_cny']:.4f}")
+    
+    if getattr(args, "report_format", "json") == "jsonl":
+        # JSONL report, written record by record once analysis is done (分析完成后逐条记录写出的JSONL报告)
+        summary = analyzer.report_summary(segments, window_results)
+        if cross_check is not None:
+            summary["engine_cross_check"] = cross_check
+        compression = getattr(args, "report_compression", None)
+        json_path = report_path(out_dir, compression)
+        with tracer.span("write_report_jsonl"), ReportWriter(json_path, compression) as writer:
+            for result in window_results:
+                writer.window(result)
+            writer.finish(
+                [seg.to_dict() for seg in segments], summary, metadata,
+                summary_tree["diagnosis"] if summary_tree else None,
+                timeline=timeline
+            )
+        print(f"JSONL report saved to: {json_path}")
+    else:
+        # JSON report (JSON报告)
+        report = analyzer.generate_report(segments, window_results, metadata)
+        if cross_check is not None:
+            report["summary"]["engine_cross_check"] = cross_check
+        if summary_tree is not None:
+            report["diagnosis"] = summary_tree["diagnosis"]
+        report["line_timeline"] = timeline
+        json_path = out_dir / "report.json"
+        with tracer.span("write_report_json"), open(json_path, 'w', encoding='utf-8') as f:
+            json.dump(report, f, indent=2)
+        print(f"JSON report saved to: {json_path}")
     
     # Markdown report (Markdown报告)
-    markdown_content = analyzer.generate_markdown_report(segments, metadata)
     md_path = out_dir / "report.md"
-    with open(md_path, 'w', encoding='utf-8') as f:
-        f.write(markdown_content)
+    with tracer.span("write_report_md"), open(md_path, 'w', encoding='utf-8') as f:
+        f.write(analyzer.generate_markdown_report(
+            segments, metadata, summary_tree["diagnosis"] if summary_tree else None, timeline
+        ))
     print(f"Markdown report saved to: {md_path}")
     
-    if args.debug:
-        print(f"Debug files saved to: {out_dir / 'debug'}")
+    if archive:
+        print(f"Debug archive saved to: {archive.directory} ({archive.records} records; "
+              f"python -m src.debug_archive {archive.directory} --window N)")
     
     print("\n✓ Analysis complete!")
     return 0
@@ -263,13 +1009,242 @@ def main():
     analyze_parser.add_argument(
         "--debug",
         action="store_true",
-        help="Enable debug mode (saves request/response JSON) (启用调试模式，保存请求/响应JSON)"
+        help="Enable debug mode (archives requests and results in OUT/debug) "
+             "(启用调试模式，将请求和结果归档到 OUT/debug)"
     )
     analyze_parser.add_argument(
         "--mask",
         action="store_true",
         help="Enable data masking for sensitive information (启用敏感信息脱敏)"
     )
+    analyze_parser.add_argument(
+        "--report-format",
+        choices=["json", "jsonl"],
+        default="json",
+        help="report.json as one document, or a report.jsonl read lazily (default: json) "
+             "(report.json为单个文档，或可惰性读取的report.jsonl，默认：json)"
+    )
+    analyze_parser.add_argument(
+        "--report-compression",
+        choices=COMPRESSIONS,
+        default=None,
+        help="Compress the JSONL report; zstd needs the zstandard package "
+             "(压缩JSONL报告；zstd需要zstandard包)"
+    )
+    analyze_parser.add_argument(
+        "--pipeline",
+        action="store_true",
+        help="Read, mask and analyze concurrently through bounded queues; requests start while the file is read "
+             "(通过有界队列并发读取、脱敏和分析；读取文件的同时即开始请求)"
+    )
+    analyze_parser.add_argument(
+        "--workers",
+        type=int,
+        default=4,
+        help="Requests in flight with --pipeline (default: 4) (--pipeline 下的并发请求数，默认：4)"
+    )
+    analyze_parser.add_argument(
+        "--mask-workers",
+        type=int,
+        default=2,
+        help="Masking threads with --pipeline and --mask (default: 2) (--pipeline 与 --mask 下的脱敏线程数，默认：2)"
+    )
+    analyze_parser.add_argument(
+        "--queue-size",
+        type=int,
+        default=64,
+        help="Windows each --pipeline queue holds before the stage before it waits (default: 64) "
+             "(--pipeline 每个队列容纳的窗口数，超过后上游阶段等待，默认：64)"
+    )
+    analyze_parser.add_argument(
+        "--reorder-limit",
+        type=int,
+        default=None,
+        help="Windows --pipeline may read ahead of the oldest unfinished one (default: queue size plus workers) "
+             "(--pipeline 可领先最早未完成窗口读取的窗口数，默认：队列容量加并发请求数)"
+    )
+    analyze_parser.add_argument(
+        "--resume",
+        action="store_true",
+        help="Continue an interrupted run from OUT/journal.jsonl, skipping windows already analyzed "
+             "(从 OUT/journal.jsonl 继续中断的运行，跳过已分析的窗口)"
+    )
+    analyze_parser.add_argument(
+        "--retries",
+        type=int,
+        default=0,
+        help="Retry 429/5xx, timeouts and broken responses up to N times with backoff (default: 0) "
+             "(对429/5xx、超时和损坏响应最多重试N次并退避，默认：0)"
+    )
+    analyze_parser.add_argument(
+        "--record",
+        default=None,
+        metavar="PATH",
+        help="Append every request/response pair to a JSONL recording for offline replay "
+             "(将每个请求/响应对追加到JSONL录制文件，用于离线回放)"
+    )
+    analyze_parser.add_argument(
+        "--prefilter",
+        action="store_true",
+        help="Decide obvious windows with a local heuristic and only send the rest to the LLM "
+             "(使用本地启发式判定明显窗口，仅将其余窗口发送给大模型)"
+    )
+    analyze_parser.add_argument(
+        "--prefilter-threshold",
+        type=float,
+        default=DEFAULT_THRESHOLD,
+        help=f"Minimum heuristic confidence for a local decision (default: {DEFAULT_THRESHOLD}) "
+             f"(本地判定的最低启发式置信度，默认：{DEFAULT_THRESHOLD})"
+    )
+    analyze_parser.add_argument(
+        "--dedup",
+        action="store_true",
+        help="Reuse results for near-duplicate windows instead of analyzing them "
+             "(为近重复窗口复用已有结果而不再分析)"
+    )
+    analyze_parser.add_argument(
+        "--dedup-threshold",
+        type=float,
+        default=DEFAULT_DEDUP_THRESHOLD,
+        help=f"Minimum similarity of normalized windows for reuse (default: {DEFAULT_DEDUP_THRESHOLD}) "
+             f"(复用所需的归一化窗口最低相似度，默认：{DEFAULT_DEDUP_THRESHOLD})"
+    )
+    analyze_parser.add_argument(
+        "--summarize",
+        action="store_true",
+        help="Reduce window results level by level into a whole-log diagnosis "
+             "(将窗口结果逐层归约为整份日志诊断)"
+    )
+    analyze_parser.add_argument(
+        "--summary-fan-in",
+        type=int,
+        default=16,
+        help="Items combined per reduction request (default: 16) (每个归约请求合并的条目数，默认：16)"
+    )
+    analyze_parser.add_argument(
+        "--summary-concurrency",
+        type=int,
+        default=8,
+        help="Reduction requests in flight per level (default: 8) (每层同时进行的归约请求数，默认：8)"
+    )
+    analyze_parser.add_argument(
+        "--max-calls",
+        type=int,
+        default=None,
+        help="Analyze at most N windows, most salient first; the rest are reported as unanalyzed gaps "
+             "(最多分析N个窗口，显著性高的优先；其余作为未分析区间报告)"
+    )
+    analyze_parser.add_argument(
+        "--max-cost",
+        type=float,
+        default=None,
+        metavar="CNY",
+        help="Stop once the estimated cost would exceed this amount in CNY "
+             "(估算成本将超过此人民币金额时停止)"
+    )
+    analyze_parser.add_argument(
+        "--search",
+        action="store_true",
+        help="Only locate state transitions: analyze a sparse sample, then bisect between disagreeing samples "
+             "(仅定位状态转换：先分析稀疏采样，再在结论不一致的采样点之间二分)"
+    )
+    analyze_parser.add_argument(
+        "--search-stride",
+        type=int,
+        default=0,
+        help="Windows between initial samples (default: 0, about sqrt of the window count) "
+             "(初始采样间隔的窗口数，默认：0，约为窗口数的平方根)"
+    )
+    analyze_parser.add_argument(
+        "--cascade",
+        default=None,
+        metavar="MODELS",
+        help="Comma-separated model tiers, cheapest first, e.g. qwen-turbo,qwen-plus; "
+             "a tier may be model@base_url (逗号分隔的模型层级，最廉价的在前；层级可写作model@base_url)"
+    )
+    analyze_parser.add_argument(
+        "--cascade-threshold",
+        type=float,
+        default=0.8,
+        help="Escalate windows below this confidence or disagreeing with a neighbor (default: 0.8) "
+             "(置信度低于此值或与相邻窗口不一致时升级，默认：0.8)"
+    )
+    analyze_parser.add_argument(
+        "--engine",
+        action="store_true",
+        help="Run the rule-based state machine, save timeline.json and cross-check window results "
+             "(运行基于规则的状态机，保存timeline.json并交叉校验窗口结果)"
+    )
+    analyze_parser.add_argument(
+        "--batch",
+        action="store_true",
+        help="Submit all windows as one offline Batch API job; re-run to resume polling "
+             "(通过离线Batch API提交所有窗口；重新运行可继续轮询)"
+    )
+    analyze_parser.add_argument(
+        "--batch-poll-interval",
+        type=float,
+        default=30.0,
+        help="Seconds between batch status polls (default: 30) (批处理状态轮询间隔秒数，默认：30)"
+    )
+    analyze_parser.add_argument(
+        "--stream",
+        action="store_true",
+        help="Stream responses and show each window's state as soon as it arrives "
+             "(流式接收响应，状态一到达立即显示)"
+    )
+    analyze_parser.add_argument(
+        "--early-stop",
+        action="store_true",
+        help="With --stream, cancel generation once final_state, confidence and reason are complete "
+             "(配合--stream，在final_state、confidence和reason完成后取消生成)"
+    )
+    analyze_parser.add_argument(
+        "--compact",
+        action="store_true",
+        help="Use the compact response schema (short keys, evidence as line numbers) "
+             "(使用紧凑响应模式：短键名，证据为行号)"
+    )
+    analyze_parser.add_argument(
+        "--trace",
+        metavar="FILE",
+        default=None,
+        help="Write per-stage and per-request spans as Chrome trace JSON, viewable in "
+             "chrome://tracing or ui.perfetto.dev (将各阶段和各请求的跨度写为Chrome trace JSON)"
+    )
+    analyze_parser.add_argument(
+        "--dry-run",
+        action="store_true",
+        help="Parse, filter, mask and chunk offline, then print projected requests, tokens, cost "
+             "and time without sending anything (离线解析、过滤、脱敏和分块，然后打印预估的请求数、token、成本和耗时，不发送任何请求)"
+    )
+    analyze_parser.add_argument(
+        "--rpm",
+        type=int,
+        default=None,
+        help="Requests per minute allowed by your account, for --dry-run (default: per-model table) "
+             "(账户允许的每分钟请求数，用于--dry-run，默认：按模型查表)"
+    )
+    analyze_parser.add_argument(
+        "--serialize",
+        action="store_true",
+        help="Send windows in a token-efficient form (relative times, tag and hex aliases) "
+             "(以高token效率形式发送窗口：相对时间、标签和十六进制别名)"
+    )
+    analyze_parser.add_argument(
+        "--pack",
+        type=int,
+        default=1,
+        help="Analyze up to N consecutive windows per request (default: 1, no packing) "
+             "(每个请求最多分析N个连续窗口，默认：1，不打包)"
+    )
+    analyze_parser.add_argument(
+        "--pack-max-tokens",
+        type=int,
+        default=6000,
+        help="Estimated token budget per packed request (default: 6000) "
+             "(每个打包请求的估算token预算，默认：6000)"
+    )
     
     args = parser.parse_args()
     
@@ -0,0 +1,87 @@
+"""Compact response schema with evidence returned as window line numbers.
+紧凑响应模式：证据以窗口行号形式返回。
+
+In compact mode the window is sent with numbered lines and the model answers
+with short keys and line numbers instead of copying log text back:
+紧凑模式下窗口按行编号发送，模型使用短键名和行号作答，而不是复制日志原文：
+
+    {"s": "P", "c": 0.9, "r": "Track active", "e": [3, 7], "n": ["Check routing"]}
+
+The client expands this locally to the normal schema with exact source lines.
+客户端在本地将其展开为常规模式，并还原为精确的源日志行。
+"""
+
+from typing import Any, Dict, List
+
+
+# Short key -> full field name (短键名 -> 完整字段名)
+COMPACT_KEYS = {
+    "s": "final_state",
+    "c": "confidence",
+    "r": "reason",
+    "e": "evidence",
+    "n": "next_actions"
+}
+
+# Short state code -> full state (短状态码 -> 完整状态)
+STATE_CODES = {
+    "P": "PLAYING",
+    "M": "MUTED",
+    "U": "UNKNOWN"
+}
+
+
+def number_lines(lines: List[str]) -> str:
+    """Render window lines with 1-based line numbers.
+    以从1开始的行号渲染窗口日志行。
+    """
+    return "\n".join(f"{i}| {line}" for i, line in enumerate(lines, 1))
+
+
+def expand_key(key: str) -> str:
+    """Map a compact key to its full field name (将短键名映射为完整字段名)."""
+    return COMPACT_KEYS.get(key, key)
+
+
+def expand_compact_result(parsed: Dict[str, Any], window_lines: List[str]) -> Dict[str, Any]:
+    """Expand a compact result to the full schema, resolving evidence line numbers.
+    将紧凑结果展开为完整模式，并解析证据行号。
+
+    Full-length keys and state names are accepted too, and evidence items that
+    are not valid line numbers are kept as text.
+    同样接受完整键名和状态名；不是有效行号的证据项按原文保留。
+
+    Args:
+        parsed: Compact result from the model (模型返回的紧凑结果)
+        window_lines: Lines of the window the result refers to (结果对应窗口的日志行)
+
+    Returns:
+        Result dict in the full schema, with ``evidence_line_numbers`` listing the
+        resolved 1-based window line numbers
+        完整模式的结果字典，``evidence_line_numbers`` 列出已解析的从1开始的窗口行号
+    """
+    if not isinstance(parsed, dict):
+        return parsed
+
+    result = {expand_key(key): value for key, value in parsed.items()}
+
+    state = result.get("final_state")
+    if isinstance(state, str):
+        result["final_state"] = STATE_CODES.get(state.upper(), state.upper())
+
+    evidence: List[str] = []
+    line_numbers: List[int] = []
+    for item in result.get("evidence") or []:
+        number = item
+        if isinstance(item, str) and item.strip().isdigit():
+            number = int(item)
+        if isinstance(number, int) and not isinstance(number, bool) and 1 <= number <= len(window_lines):
+            evidence.append(window_lines[number - 1])
+            line_numbers.append(number)
+        elif isinstance(item, str):
+            evidence.append(item)
+    if "evidence" in result:
+        result["evidence"] = evidence
+        result["evidence_line_numbers"] = line_numbers
+
+    return result
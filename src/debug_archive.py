@@ -0,0 +1,246 @@
+"""Compressed, append-only archive of the exchanges captured with ``--debug``.
+``--debug`` 捕获的交互的压缩追加式归档。
+
+All exchanges of a run go to ``debug/exchanges.jsonl.gz``. Every record is its
+own gzip member, so the file is one valid gzip stream (``zcat`` prints it as
+JSON Lines) and any record can be read on its own from its byte range. System
+prompts are stored once, keyed by hash, and referenced from each request.
+``debug/index.jsonl`` maps window indices to byte ranges; a packed request is
+stored once and indexed under every window it covers. Records are compressed
+and written on a background thread so the analysis loop never waits on disk.
+一次运行的所有交互写入 ``debug/exchanges.jsonl.gz``。每条记录是独立的gzip成员，因此文件是合法的gzip流
+（``zcat`` 会以JSON Lines输出），任何记录都可以按其字节范围单独读取。系统提示词按哈希只存一次，请求中引用它。
+``debug/index.jsonl`` 将窗口索引映射到字节范围；打包请求只存一次，并在其覆盖的每个窗口下建立索引。
+记录在后台线程中压缩和写入，分析循环从不等待磁盘。
+
+Usage (用法):
+    python -m src.debug_archive output/debug --list
+    python -m src.debug_archive output/debug --window 12
+"""
+
+import argparse
+import gzip
+import hashlib
+import json
+import queue
+import sys
+import threading
+from pathlib import Path
+from typing import Any, Dict, List, Optional
+
+ARCHIVE_NAME = "exchanges.jsonl.gz"
+INDEX_NAME = "index.jsonl"
+PROMPT_REF = "@prompt:"
+
+# Records waiting for the writer; callers block when it falls this far behind
+# 等待写入的记录数；写入线程落后这么多时调用方会阻塞
+QUEUE_SIZE = 256
+
+_CLOSE = object()
+
+
+def prompt_hash(text: str) -> str:
+    """Short content hash naming a stored system prompt (命名已存储系统提示词的短内容哈希)."""
+    return hashlib.sha256(text.encode("utf-8")).hexdigest()[:16]
+
+
+def _encode(record: Dict[str, Any]) -> bytes:
+    return (json.dumps(record, ensure_ascii=False) + "\n").encode("utf-8")
+
+
+def redact_headers(headers: Dict[str, str]) -> Dict[str, str]:
+    """Copy of request headers with the API key removed (去除API密钥的请求头副本)."""
+    return {k: "[REDACTED]" if k.lower() == "authorization" else v for k, v in headers.items()}
+
+
+class DebugArchive:
+    """Background writer of a run's debug exchanges.
+    一次运行的调试交互的后台写入器。
+    """
+
+    def __init__(self, directory: Path, compresslevel: int = 6):
+        """Start a new archive, replacing one left by an earlier run.
+        开始新的归档，替换之前运行留下的归档。
+
+        Args:
+            directory: Debug directory, e.g. out/debug (调试目录，例如out/debug)
+            compresslevel: gzip level per record (每条记录的gzip压缩级别)
+        """
+        self.directory = Path(directory)
+        self.directory.mkdir(parents=True, exist_ok=True)
+        self.compresslevel = compresslevel
+        self._archive = open(self.directory / ARCHIVE_NAME, 'wb')
+        self._index = open(self.directory / INDEX_NAME, 'w', encoding='utf-8')
+        self._prompts = set()
+        self._queue: "queue.Queue" = queue.Queue(maxsize=QUEUE_SIZE)
+        self.error: Optional[BaseException] = None
+        self.records = 0
+        self.dropped = 0
+        self._thread = threading.Thread(target=self._run, name="debug-archive", daemon=True)
+        self._thread.start()
+
+    def record(
+        self,
+        windows: List[int],
+        url: str,
+        headers: Dict[str, str],
+        payload: Dict[str, Any],
+        result: Any,
+        line_count: Optional[int] = None
+    ):
+        """Queue one exchange for writing; dropped once the writer has failed.
+        将一次交互加入写入队列；写入线程失败后丢弃。
+
+        Args:
+            windows: Window indices answered by the request (请求所回答的窗口索引)
+            url: Request URL (请求URL)
+            headers: Request headers; the API key is redacted (请求头；API密钥会被隐藏)
+            payload: Request payload (请求负载)
+            result: Parsed result(s) of the request (请求的解析结果)
+            line_count: Lines in the window (窗口行数)
+        """
+        # A dead writer no longer writes; close() raises its error
+        # 已失败的写入线程不再写入；close()会抛出其错误
+        if self.error is not None:
+            self.dropped += 1
+            return
+        # Encode here, so results mutated later by the caller are not shared with the writer
+        # 在此处编码，使调用方之后修改的结果不会与写入线程共享
+        messages = []
+        prompts = []
+        for message in payload.get("messages", []):
+            if message.get("role") == "system":
+                digest = prompt_hash(message.get("content", ""))
+                prompts.append((digest, message.get("content", "")))
+                message = {**message, "content": PROMPT_REF + digest}
+            messages.append(message)
+        request = {"url": url, "headers": redact_headers(headers), "payload": {**payload, "messages": messages}}
+        self._queue.put((list(windows), prompts, _encode({
+            "type": "exchange",
+            "windows": windows,
+            "request": request,
+            "parsed_result": result,
+            "window_lines_count": line_count
+        })))
+
+    def close(self):
+        """Flush queued records and stop the writer; raises if a write failed.
+        写出队列中的记录并停止写入线程；写入失败时抛出异常。
+        """
+        if self._thread.is_alive():
+            self._queue.put(_CLOSE)
+            self._thread.join()
+        if self.error:
+            raise self.error
+
+    def _run(self):
+        try:
+            while True:
+                item = self._queue.get()
+                if item is _CLOSE:
+                    break
+                windows, prompts, exchange = item
+                for digest, text in prompts:
+                    if digest not in self._prompts:
+                        self._prompts.add(digest)
+                        self._append(_encode({"type": "prompt", "hash": digest, "text": text}), [], digest)
+                self._append(exchange, windows)
+        except BaseException as e:
+            self.error = e
+            # Keep draining so record() never blocks on a full queue (继续消费队列，使record()不会在队列满时阻塞)
+            while self._queue.get() is not _CLOSE:
+                self.dropped += 1
+        finally:
+            self._archive.close()
+            self._index.close()
+
+    def _append(self, line: bytes, windows: List[int], prompt: Optional[str] = None):
+        data = gzip.compress(line, self.compresslevel, mtime=0)
+        offset = self._archive.tell()
+        self._archive.write(data)
+        self._archive.flush()
+        entry = {"offset": offset, "length": len(data)}
+        if prompt:
+            self._index.write(json.dumps({"prompt": prompt, **entry}) + "\n")
+        for window_idx in windows:
+            self._index.write(json.dumps({"window": window_idx, **entry}) + "\n")
+        self._index.flush()
+        self.records += 1
+
+
+class ArchiveReader:
+    """Random access to the records of a debug archive.
+    对调试归档记录的随机访问。
+    """
+
+    def __init__(self, directory: Path):
+        self.directory = Path(directory)
+        self.windows: Dict[int, List[tuple]] = {}
+        self.prompts: Dict[str, tuple] = {}
+        with open(self.directory / INDEX_NAME, 'r', encoding='utf-8') as f:
+            for line in f:
+                try:
+                    entry = json.loads(line)
+                except json.JSONDecodeError:
+                    continue
+                span = (entry["offset"], entry["length"])
+                if "prompt" in entry:
+                    self.prompts[entry["prompt"]] = span
+                else:
+                    self.windows.setdefault(entry["window"], []).append(span)
+
+    def _read(self, span: tuple) -> Dict[str, Any]:
+        offset, length = span
+        with open(self.directory / ARCHIVE_NAME, 'rb') as f:
+            f.seek(offset)
+            return json.loads(gzip.decompress(f.read(length)))
+
+    def prompt(self, digest: str) -> str:
+        """Text of a stored system prompt (已存储系统提示词的文本)."""
+        return self._read(self.prompts[digest])["text"]
+
+    def exchanges(self, window_idx: int) -> List[Dict[str, Any]]:
+        """Exchanges of a window with system prompts restored, oldest first.
+        某窗口的交互（已还原系统提示词），按时间先后排列。
+        """
+        exchanges = []
+        for span in self.windows.get(window_idx, []):
+            exchange = self._read(span)
+            for message in exchange["request"]["payload"].get("messages", []):
+                content = message.get("content")
+                if isinstance(content, str) and content.startswith(PROMPT_REF):
+                    message["content"] = self.prompt(content[len(PROMPT_REF):])
+            exchanges.append(exchange)
+        return exchanges
+
+
+def main(argv: Optional[List[str]] = None):
+    """List the archived windows or print one window's exchange.
+    列出已归档的窗口或打印某个窗口的交互。
+    """
+    parser = argparse.ArgumentParser(
+        prog="python -m src.debug_archive",
+        description="Read a --debug archive\n读取 --debug 归档"
+    )
+    parser.add_argument("directory", help="Debug directory, e.g. output/debug (调试目录)")
+    group = parser.add_mutually_exclusive_group(required=True)
+    group.add_argument("--list", action="store_true", help="List archived windows (列出已归档的窗口)")
+    group.add_argument("--window", type=int, help="Print the exchange of window N (打印窗口N的交互)")
+    args = parser.parse_args(argv)
+
+    reader = ArchiveReader(Path(args.directory))
+    if args.list:
+        print(f"{len(reader.windows)} windows, {len(reader.prompts)} distinct system prompts")
+        print(" ".join(str(w) for w in sorted(reader.windows)))
+        return 0
+    exchanges = reader.exchanges(args.window)
+    if not exchanges:
+        print(f"Error: window {args.window} is not in the archive", file=sys.stderr)
+        return 1
+    # A window retried after a rejected pack has several exchanges (打包被拒后重试的窗口有多次交互)
+    print(json.dumps(exchanges if len(exchanges) > 1 else exchanges[0], indent=2, ensure_ascii=False))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,196 @@
+"""Near-duplicate window detection for result reuse.
+用于结果复用的近重复窗口检测。
+
+Windows are normalized (timestamps, pid/tid, hex and numbers removed, except
+the values of state-bearing keys such as ``mute=1`` or ``volume=0``), reduced
+to sets of ordered line n-gram shingles and indexed with MinHash LSH. A
+candidate is confirmed with the exact Jaccard similarity of the shingle sets.
+窗口先经过归一化（去除时间戳、pid/tid、十六进制和数字，但保留 ``mute=1`` 或 ``volume=0`` 等状态键的值），
+转换为有序的行n-gram分片集合，并用MinHash LSH建立索引。候选项以分片集合的精确Jaccard相似度确认。
+"""
+
+import hashlib
+import random
+import re
+from typing import Dict, FrozenSet, List, Optional, Tuple
+
+
+# Default Jaccard similarity required to reuse a result (复用结果所需的默认Jaccard相似度)
+DEFAULT_THRESHOLD = 0.9
+
+# Consecutive normalized lines per shingle (每个分片包含的连续归一化行数)
+SHINGLE_SIZE = 2
+
+_PREFIX = re.compile(r'^\d{2}-\d{2}\s+\d{2}:\d{2}:\d{2}\.\d{3}\s+\d+\s+\d+\s+')
+# Key=value tokens whose value decides the audio state, then hex values, then numbers
+# 值决定音频状态的键值对，然后是十六进制值，最后是数字
+_TOKEN = re.compile(
+    r'\b(?P<key>mute|muted|volume|vol|level|state|gain|active|standby)\s*[=:]\s*(?P<value>[\w.]+)'
+    r'|(?P<hex>0x[0-9a-fA-F]+)'
+    r'|(?P<number>\d+(?:\.\d+)?)',
+    re.IGNORECASE
+)
+
+# Mersenne prime for the universal hash family (通用哈希族所用的梅森素数)
+_PRIME = (1 << 61) - 1
+
+
+def _normalize_token(m: "re.Match") -> str:
+    if m.group("key"):
+        return f"{m.group('key').lower()}={m.group('value').lower()}"
+    return "<HEX>" if m.group("hex") else "<N>"
+
+
+def normalize_line(line: str) -> str:
+    """Strip the logcat prefix and replace hex values and numbers with placeholders.
+    去除logcat前缀，并用占位符替换十六进制值和数字。
+
+    Values of state-bearing keys (mute, volume, level, state, ...) are kept,
+    since ``mute=1`` and ``mute=0`` mean opposite states.
+    状态键（mute、volume、level、state等）的值会保留，因为 ``mute=1`` 与 ``mute=0`` 表示相反的状态。
+    """
+    return _TOKEN.sub(_normalize_token, _PREFIX.sub("", line))
+
+
+def shingles(window_lines: List[str], size: int = SHINGLE_SIZE) -> FrozenSet[str]:
+    """Set of ordered line n-grams of a window (窗口有序行n-gram的集合).
+
+    Each n-gram keeps the order of its lines, so the same events in another
+    order give other shingles. Repeats are not counted: a window of steady
+    buffer lines plus one mute event must not look like the steady window.
+    每个n-gram保留其中各行的顺序，因此相同事件以不同顺序出现会得到不同的分片。不计重复次数：
+    稳定的缓冲区行加上一个静音事件的窗口不应与只有稳定缓冲区行的窗口相似。
+    """
+    lines = [normalize_line(line) for line in window_lines]
+    if len(lines) <= size:
+        return frozenset(["\n".join(lines)]) if lines else frozenset()
+    return frozenset("\n".join(lines[i:i + size]) for i in range(len(lines) - size + 1))
+
+
+def jaccard(a: FrozenSet[str], b: FrozenSet[str]) -> float:
+    """Jaccard similarity of two sets (两个集合的Jaccard相似度)."""
+    if not a and not b:
+        return 1.0
+    return len(a & b) / len(a | b)
+
+
+class DuplicateIndex:
+    """MinHash LSH index over analyzed windows.
+    已分析窗口的MinHash LSH索引。
+    """
+
+    def __init__(
+        self,
+        threshold: float = DEFAULT_THRESHOLD,
+        num_perm: int = 64,
+        bands: int = 16,
+        seed: int = 1
+    ):
+        """Initialize the index.
+        初始化索引。
+
+        Args:
+            threshold: Minimum Jaccard similarity for a match (匹配所需的最低Jaccard相似度)
+            num_perm: MinHash signature length (MinHash签名长度)
+            bands: LSH bands; num_perm must be divisible by it (LSH分带数；num_perm须能被其整除)
+            seed: Seed for the hash permutations (哈希置换的种子)
+        """
+        if num_perm % bands:
+            raise ValueError("num_perm must be divisible by bands")
+        self.threshold = threshold
+        self.bands = bands
+        self.rows = num_perm // bands
+        rng = random.Random(seed)
+        self._perms = [(rng.randrange(1, _PRIME), rng.randrange(0, _PRIME)) for _ in range(num_perm)]
+        self._buckets: List[Dict[Tuple[int, ...], List[int]]] = [{} for _ in range(bands)]
+        self._sets: Dict[int, FrozenSet[str]] = {}
+
+    def signature(self, items: FrozenSet[str]) -> List[int]:
+        """MinHash signature of a shingle set (分片集合的MinHash签名)."""
+        if not items:
+            return [0] * len(self._perms)
+        hashes = [int.from_bytes(hashlib.blake2b(s.encode("utf-8"), digest_size=8).digest(), "big")
+                  for s in items]
+        return [min((a * h + b) % _PRIME for h in hashes) for a, b in self._perms]
+
+    def _band_keys(self, signature: List[int]) -> List[Tuple[int, ...]]:
+        return [tuple(signature[i * self.rows:(i + 1) * self.rows]) for i in range(self.bands)]
+
+    def find(self, window_lines: List[str]) -> Optional[Tuple[int, float]]:
+        """Find the most similar indexed window at or above the threshold.
+        查找相似度不低于阈值的最相似已索引窗口。
+
+        Returns:
+            (window_idx, similarity) or None (窗口索引和相似度，或None)
+        """
+        items = shingles(window_lines)
+        best: Optional[Tuple[int, float]] = None
+        seen = set()
+        for band, key in enumerate(self._band_keys(self.signature(items))):
+            for candidate in self._buckets[band].get(key, ()):
+                if candidate in seen:
+                    continue
+                seen.add(candidate)
+                similarity = jaccard(items, self._sets[candidate])
+                if similarity >= self.threshold and (best is None or similarity > best[1]):
+                    best = (candidate, similarity)
+        return best
+
+    def add(self, window_idx: int, window_lines: List[str]):
+        """Index a window (为窗口建立索引)."""
+        items = shingles(window_lines)
+        self._sets[window_idx] = items
+        for band, key in enumerate(self._band_keys(self.signature(items))):
+            self._buckets[band].setdefault(key, []).append(window_idx)
+
+
+def plan_reuse(
+    windows: List[Tuple[int, List[str]]],
+    threshold: float = DEFAULT_THRESHOLD
+) -> Tuple[List[Tuple[int, List[str]]], Dict[int, Tuple[int, float]]]:
+    """Split windows into representatives to analyze and near-duplicates to reuse.
+    将窗口划分为需分析的代表窗口和可复用结果的近重复窗口。
+
+    Returns:
+        Tuple of (representative windows, duplicate window_idx -> (representative
+        window_idx, similarity))
+        (代表窗口列表, 重复窗口索引 -> (代表窗口索引, 相似度)) 元组
+    """
+    index = DuplicateIndex(threshold)
+    representatives = []
+    duplicates: Dict[int, Tuple[int, float]] = {}
+    for window_idx, window_lines in windows:
+        match = index.find(window_lines)
+        if match is not None:
+            duplicates[window_idx] = match
+        else:
+            index.add(window_idx, window_lines)
+            representatives.append((window_idx, window_lines))
+    return representatives, duplicates
+
+
+def apply_reuse(
+    results: List[Dict],
+    duplicates: Dict[int, Tuple[int, float]]
+) -> List[Dict]:
+    """Copy representative results to their duplicates, marked as inferred.
+    将代表窗口的结果复制给其重复窗口，并标记为推断结果。
+
+    Returns:
+        All results ordered by window_idx (按窗口索引排序的全部结果)
+    """
+    by_idx = {r["window_idx"]: r for r in results}
+    reused = []
+    for window_idx, (source_idx, similarity) in duplicates.items():
+        source = by_idx.get(source_idx)
+        if source is None:
+            continue
+        result = dict(source)
+        result.update({
+            "window_idx": window_idx,
+            "inferred": True,
+            "reused_from": source_idx,
+            "similarity": round(similarity, 3)
+        })
+        reused.append(result)
+    return sorted(results + reused, key=lambda r: r["window_idx"])
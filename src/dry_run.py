@@ -0,0 +1,144 @@
+"""Offline projection of the calls, tokens, cost and time of an analysis.
+分析所需调用数、token、成本和耗时的离线预估。
+
+Requests are built exactly as the client would build them, but never sent;
+tokens come from the local estimator and cost, latency and rate limits from
+the tables in pricing.py.
+请求按客户端的方式构建但从不发送；token来自本地估算，成本、延迟和速率限制来自pricing.py中的表。
+"""
+
+from typing import Any, Callable, Dict, Iterable, Iterator, List, Optional, Tuple
+
+from .bailian_client import PACKED_OUTPUT_TOKENS_PER_WINDOW, BailianClient, plan_packs
+from .pricing import (
+    EXPECTED_COMPACT_OUTPUT_TOKENS,
+    EXPECTED_OUTPUT_TOKENS,
+    estimate_cost,
+    estimate_latency,
+    model_rate_limits,
+)
+from .tokens import MESSAGE_OVERHEAD_TOKENS, estimate_tokens
+
+
+def payload_tokens(payload: Dict[str, Any]) -> int:
+    """Estimated input tokens of a chat completion payload (聊天补全请求负载的估算输入token数)."""
+    return sum(
+        estimate_tokens(message.get("content", "")) + MESSAGE_OVERHEAD_TOKENS
+        for message in payload.get("messages", [])
+    )
+
+
+def plan_requests(
+    client: BailianClient,
+    system_prompt: str,
+    windows: List[Tuple[int, List[str]]],
+    pack: int = 1,
+    pack_max_tokens: int = 6000,
+    prompt_fn: Optional[Callable[[List[str]], str]] = None
+) -> Iterator[Tuple[Dict[str, Any], int]]:
+    """Build the requests an analysis would send, one at a time.
+    逐个构建分析将要发送的请求。
+
+    Args:
+        client: Client whose settings (compact, serialize, model) shape the payloads
+               其设置（紧凑、序列化、模型）决定请求负载的客户端
+        system_prompt: System prompt (系统提示词)
+        windows: List of (window_idx, window_lines) (窗口列表)
+        pack: Maximum windows per packed request (每个打包请求的最多窗口数)
+        pack_max_tokens: Token budget per packed request (每个打包请求的token预算)
+        prompt_fn: Per-window system prompt, e.g. with retrieved spec sections
+                  按窗口生成的系统提示词，例如附带检索到的规范章节
+
+    Yields:
+        (payload, windows covered by the payload) (请求负载, 该负载覆盖的窗口数)
+    """
+    if pack > 1:
+        for group in plan_packs(windows, system_prompt, pack, pack_max_tokens):
+            if len(group) == 1:
+                yield client.build_payload(system_prompt, "\n".join(group[0][1])), 1
+            else:
+                yield client.build_packed_payload(system_prompt, group), len(group)
+        return
+    for _, window_lines in windows:
+        prompt = prompt_fn(window_lines) if prompt_fn else system_prompt
+        yield client.build_payload(prompt, "\n".join(window_lines)), 1
+
+
+def project(
+    requests: Iterable[Tuple[Dict[str, Any], int]],
+    model: Optional[str],
+    compact: bool = False,
+    rpm: Optional[int] = None
+) -> Dict[str, Any]:
+    """Project tokens, cost and time of a set of requests.
+    预估一组请求的token、成本和耗时。
+
+    Args:
+        requests: (payload, window count) pairs from plan_requests (来自plan_requests的(负载, 窗口数))
+        model: Model used for prices and latency (用于价格和延迟的模型)
+        compact: Expect compact-schema responses (预期紧凑模式响应)
+        rpm: Requests per minute allowed, overriding the table (允许的每分钟请求数，覆盖表中数值)
+
+    Returns:
+        Projection dict (预估结果字典)
+    """
+    per_window = EXPECTED_COMPACT_OUTPUT_TOKENS if compact else EXPECTED_OUTPUT_TOKENS
+    calls = windows = input_tokens = output_tokens = max_prompt = 0
+    cost = sequential = 0.0
+    for payload, count in requests:
+        prompt = payload_tokens(payload)
+        completion = per_window if count == 1 else count * min(per_window, PACKED_OUTPUT_TOKENS_PER_WINDOW)
+        calls += 1
+        windows += count
+        input_tokens += prompt
+        output_tokens += completion
+        max_prompt = max(max_prompt, prompt)
+        cost += estimate_cost(model, prompt, completion)
+        sequential += estimate_latency(model, completion)
+
+    table_rpm, tpm = model_rate_limits(model)
+    rpm = rpm or table_rpm
+    # Fastest any amount of concurrency could go under the rate limits
+    # 在速率限制下任意并发所能达到的最快耗时
+    floor = 60.0 * max(calls / rpm, (input_tokens + output_tokens) / tpm)
+    return {
+        "model": model,
+        "calls": calls,
+        "windows": windows,
+        "input_tokens": input_tokens,
+        "output_tokens": output_tokens,
+        "mean_prompt_tokens": round(input_tokens / calls) if calls else 0,
+        "max_prompt_tokens": max_prompt,
+        "estimated_cost": round(cost, 4),
+        "sequential_s": round(sequential, 1),
+        "rate_limit_floor_s": round(floor, 1),
+        "rpm": rpm,
+        "tpm": tpm
+    }
+
+
+def format_duration(seconds: float) -> str:
+    """Human-readable duration, e.g. 1h 02m 03s (可读的时长)."""
+    seconds = int(round(seconds))
+    hours, rest = divmod(seconds, 3600)
+    minutes, seconds = divmod(rest, 60)
+    if hours:
+        return f"{hours}h {minutes:02d}m {seconds:02d}s"
+    if minutes:
+        return f"{minutes}m {seconds:02d}s"
+    return f"{seconds}s"
+
+
+def format_projection(projection: Dict[str, Any]) -> str:
+    """Printable summary of a projection (预估结果的可打印摘要)."""
+    return "\n".join([
+        f"Dry run (no requests sent) 试运行（未发送请求） - model {projection['model']}",
+        f"  Requests 请求数:        {projection['calls']} ({projection['windows']} windows 窗口)",
+        f"  Input tokens 输入token:  {projection['input_tokens']:,} "
+        f"(mean {projection['mean_prompt_tokens']:,}, max {projection['max_prompt_tokens']:,} per request)",
+        f"  Output tokens 输出token: {projection['output_tokens']:,}",
+        f"  Estimated cost 估算成本: ¥{projection['estimated_cost']:.4f}",
+        f"  Sequential time 顺序耗时: {format_duration(projection['sequential_s'])}",
+        f"  Rate-limit floor 速率下限: {format_duration(projection['rate_limit_floor_s'])} "
+        f"at {projection['rpm']} RPM / {projection['tpm']:,} TPM",
+    ])
@@ -20,7 +20,10 @@ from .bailian_client import BailianClient
 from .log_parser import LogParser
 from .chunker import LogChunker
 from .masker import DataMasker
-from .analyzer import WindowAnalyzer
+from .metrics import summarize_usage
+from .analyzer import WindowAnalyzer, failed_window_result
+from .spec_retrieval import DEFAULT_MAX_TOKENS, SpecIndex
+from .dry_run import format_projection, plan_requests, project
 
 # Constants
 MIN_SPEC_DOC_LENGTH = 50  # Minimum length for specification document to be considered valid
@@ -50,6 +53,10 @@ class LogInspectorGUI:
         self.chunk_size_var = tk.IntVar(value=200)
         self.overlap_var = tk.IntVar(value=50)
         self.mask_var = tk.BooleanVar(value=False)
+        self.stream_var = tk.BooleanVar(value=False)
+        self.early_stop_var = tk.BooleanVar(value=False)
+        self.compact_var = tk.BooleanVar(value=False)
+        self.spec_tokens_var = tk.IntVar(value=DEFAULT_MAX_TOKENS)
         
         # Results storage
         self.analysis_report = None
@@ -143,6 +150,34 @@ class LogInspectorGUI:
             variable=self.mask_var
         ).grid(row=2, column=0, columnspan=2, sticky='w', pady=5)
         
+        ttk.Checkbutton(
+            param_frame,
+            text="流式显示窗口状态 Stream window states",
+            variable=self.stream_var
+        ).grid(row=3, column=0, columnspan=2, sticky='w', pady=5)
+        
+        ttk.Checkbutton(
+            param_frame,
+            text="关键字段完成后提前停止 Early stop after merge fields",
+            variable=self.early_stop_var
+        ).grid(row=4, column=0, columnspan=2, sticky='w', pady=5)
+        
+        ttk.Checkbutton(
+            param_frame,
+            text="紧凑响应格式 Compact response schema",
+            variable=self.compact_var
+        ).grid(row=5, column=0, columnspan=2, sticky='w', pady=5)
+        
+        ttk.Label(param_frame, text="规范token上限 Spec Tokens/Request:").grid(row=6, column=0, sticky='w', pady=5)
+        ttk.Spinbox(
+            param_frame,
+            from_=200,
+            to=20000,
+            increment=100,
+            textvariable=self.spec_tokens_var,
+            width=20
+        ).grid(row=6, column=1, sticky='w', padx=5, pady=5)
+        
     def _create_analysis_tab(self, parent):
         """Create analysis tab.
         创建分析标签页。
@@ -205,6 +240,13 @@ class LogInspectorGUI:
         )
         self.analyze_btn.pack(side='left', padx=5)
         
+        self.estimate_btn = ttk.Button(
+            button_frame,
+            text="预估成本 Estimate Cost",
+            command=self._start_estimate
+        )
+        self.estimate_btn.pack(side='left', padx=5)
+        
         # Note: Stop functionality not yet implemented
         # self.stop_btn = ttk.Button(
         #     action_frame,
@@ -326,6 +368,63 @@ class LogInspectorGUI:
         self.analysis_thread = threading.Thread(target=self._run_analysis, daemon=False)
         self.analysis_thread.start()
     
+    def _start_estimate(self):
+        """Start an offline cost and time estimate in a separate thread.
+        在单独的线程中开始离线成本和耗时预估。
+        """
+        if not self.log_file_path.get() or not Path(self.log_file_path.get()).exists():
+            messagebox.showerror("错误 Error", "请选择有效的日志文件 Please select a valid log file")
+            return
+        
+        self.estimate_btn.config(state='disabled')
+        self.progressbar.start()
+        self.spec_doc_text = self.spec_text.get('1.0', tk.END).strip()
+        self.results_text.delete('1.0', tk.END)
+        
+        self.analysis_thread = threading.Thread(target=self._run_estimate, daemon=False)
+        self.analysis_thread.start()
+    
+    def _run_estimate(self):
+        """Project requests, tokens, cost and time without any network call.
+        在不进行任何网络调用的情况下预估请求数、token、成本和耗时。
+        """
+        try:
+            self._update_progress("解析日志文件... Parsing log file...")
+            lines = LogParser().parse_and_filter(self.log_file_path.get())
+            if self.mask_var.get():
+                lines = DataMasker().mask_lines(lines)
+            windows = LogChunker(
+                chunk_size=self.chunk_size_var.get(),
+                overlap=self.overlap_var.get()
+            ).chunk_lines(lines)
+            
+            system_prompt = self._load_system_prompt()
+            spec_index = None
+            if self.spec_doc_text and len(self.spec_doc_text) > MIN_SPEC_DOC_LENGTH:
+                spec_index = SpecIndex(self.spec_doc_text, max_tokens=self.spec_tokens_var.get())
+            
+            # The placeholder key is never sent (占位密钥从不发送)
+            client = BailianClient(api_key="dry-run", model=self.model_var.get(), compact=self.compact_var.get())
+            requests = plan_requests(
+                client, system_prompt, windows,
+                prompt_fn=(lambda window_lines: spec_index.prompt_for(system_prompt, window_lines))
+                if spec_index else None
+            )
+            projection = project(requests, client.model, compact=self.compact_var.get())
+            
+            self._append_result(f"{len(lines)} 条音频相关日志 audio-related lines\n")
+            self._append_result(format_projection(projection) + "\n")
+            self._update_progress("✓ 预估完成 Estimate complete")
+        
+        except Exception as e:
+            error_msg = f"预估错误 Estimate error: {str(e)}"
+            self._update_progress(error_msg)
+            self._append_result(f"\n错误 Error: {str(e)}\n")
+        
+        finally:
+            self.root.after(0, lambda: self.estimate_btn.config(state='normal'))
+            self.root.after(0, lambda: self.progressbar.stop())
+    
     def _run_analysis(self):
         """Run the actual analysis (called in separate thread).
         运行实际的分析（在单独的线程中调用）。
@@ -334,7 +433,11 @@ class LogInspectorGUI:
             self._update_progress("初始化组件... Initializing components...")
             
             # Initialize components with API key passed directly
-            client = BailianClient(api_key=self.api_key_var.get(), model=self.model_var.get())
+            client = BailianClient(
+                api_key=self.api_key_var.get(),
+                model=self.model_var.get(),
+                compact=self.compact_var.get()
+            )
             parser = LogParser()
             chunker = LogChunker(
                 chunk_size=self.chunk_size_var.get(),
@@ -347,9 +450,15 @@ class LogInspectorGUI:
             self._update_progress("加载系统提示词... Loading system prompt...")
             system_prompt = self._load_system_prompt()
             
-            # Add specification document to system prompt if provided
+            # Index the specification document once; each window gets only the
+            # sections that match it (规范文档只索引一次；每个窗口只附加与其匹配的章节)
+            spec_index = None
             if self.spec_doc_text and len(self.spec_doc_text) > MIN_SPEC_DOC_LENGTH:
-                system_prompt += f"\n\n## 日志规范文档 Log Specification Document\n\n{self.spec_doc_text}"
+                spec_index = SpecIndex(self.spec_doc_text, max_tokens=self.spec_tokens_var.get())
+                self._update_progress(
+                    f"规范文档分为 {len(spec_index.sections)} 节 Specification split into "
+                    f"{len(spec_index.sections)} sections"
+                )
             
             # Parse and filter log
             self._update_progress("解析日志文件... Parsing log file...")
@@ -374,9 +483,18 @@ class LogInspectorGUI:
                 )
                 
                 log_content = "\n".join(window_lines)
+                window_prompt = spec_index.prompt_for(system_prompt, window_lines) if spec_index else system_prompt
                 
                 try:
-                    result = client.analyze_log_window(system_prompt, log_content)
+                    if self.stream_var.get():
+                        result = client.analyze_log_window_stream(
+                            window_prompt,
+                            log_content,
+                            on_field=self._make_stream_callback(window_idx, len(windows)),
+                            early_stop=self.early_stop_var.get()
+                        )
+                    else:
+                        result = client.analyze_log_window(window_prompt, log_content)
                     result["window_idx"] = window_idx
                     window_results.append(result)
                     
@@ -385,14 +503,7 @@ class LogInspectorGUI:
                         f"(置信度 confidence: {result['confidence']:.2f})\n"
                     )
                 except Exception as e:
-                    window_results.append({
-                        "window_idx": window_idx,
-                        "final_state": "UNKNOWN",
-                        "confidence": 0.0,
-                        "reason": f"Analysis failed: {str(e)}",
-                        "evidence": [],
-                        "next_actions": ["Retry analysis"]
-                    })
+                    window_results.append(failed_window_result(window_idx, str(e)))
                     self._append_result(f"窗口 Window {window_idx + 1}: 错误 Error: {str(e)}\n")
             
             # Merge segments
@@ -408,6 +519,11 @@ class LogInspectorGUI:
                 "overlap": self.overlap_var.get(),
                 "model": self.model_var.get(),
                 "masking_enabled": self.mask_var.get(),
+                "streaming": self.stream_var.get(),
+                "compact_schema": self.compact_var.get(),
+                "spec_sections": len(spec_index.sections) if spec_index else 0,
+                "spec_max_tokens": self.spec_tokens_var.get() if spec_index else None,
+                "usage": summarize_usage(window_results),
                 "total_windows": len(windows),
                 "total_lines": len(lines)
             }
@@ -451,7 +567,29 @@ class LogInspectorGUI:
             raise FileNotFoundError(f"System prompt not found at {prompt_path}")
         
         with open(prompt_path, 'r', encoding='utf-8') as f:
-            return f.read()
+            prompt = f.read()
+        
+        if self.compact_var.get():
+            with open(current_dir / "docs" / "prompt_compact.md", 'r', encoding='utf-8') as f:
+                prompt += f.read()
+        
+        return prompt
+    
+    def _make_stream_callback(self, window_idx: int, total: int):
+        """Build a callback showing a window's state while the rest streams.
+        构建回调，在其余内容流式接收时显示窗口状态。
+        
+        Args:
+            window_idx: Window index
+            total: Total number of windows
+        """
+        def on_field(field, value):
+            if field == "final_state":
+                self._update_progress(
+                    f"窗口 {window_idx + 1}/{total}: {value} ... "
+                    f"Window {window_idx + 1}/{total}: {value} (streaming)"
+                )
+        return on_field
     
     def _update_progress(self, message: str):
         """Update progress message.
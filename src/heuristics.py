@@ -0,0 +1,237 @@
+"""Local heuristic pre-classifier for obvious windows.
+针对明显窗口的本地启发式预分类器。
+
+Scores PLAYING and MUTED indicators from docs/prompt.md per window and decides
+locally when the evidence is one-sided; everything else is escalated to the LLM.
+按docs/prompt.md中的PLAYING和MUTED指标为每个窗口打分，证据一边倒时本地判定，其余交给大模型。
+
+Usage (评估用法):
+    python -m src.heuristics --log samples/demo.log --report out/report.json
+"""
+
+import argparse
+import json
+import re
+import sys
+from typing import Any, Dict, List, Optional, Tuple
+
+
+# (pattern, weight) indicators of active playback (正在播放的指标)
+PLAYING_PATTERNS = [
+    (r'\btrack (?:started|playing)\b|\bstarted successfully\b', 2.0),
+    (r'\bunmuted\b|\bmuted=false\b|\bmute=0\b|\bremoving mute\b', 2.0),
+    (r'\bobtainBuffer\(\) success\b|\bbuffer obtained\b', 1.0),
+    (r'\bwrite\(\).*bytes written\b|\bdata flowing\b|\bmixing audio\b', 1.0),
+    (r'\bSTATE_(?:PLAYING|STARTED)\b|\bstate=ACTIVE\b|\bactive playback\b|\bplayback resumed\b', 1.5),
+    (r'\bactive track count [1-9]\d*\b|\bprocessing active tracks\b', 1.0),
+    (r'\bvolume[=:]\s*(?:0\.\d*[1-9]\d*|[1-9]\d*(?:\.\d+)?)\b|\blevel=[1-9]\d*\b', 0.5),
+]
+
+# (pattern, weight) indicators of muted or inactive audio (静音或未激活的指标)
+MUTED_PATTERNS = [
+    (r'(?<!un)\bmuted\b(?!=false)|\bmuted=true\b|\bmute=1\b|\bapplying mute\b', 2.0),
+    (r'\bvolume[=:]\s*0(?:\.0+)?\b(?!\.)|\blevel=0\b', 2.0),
+    (r'\btrack (?:stopped|paused)\b|\bstate (?:changed )?to (?:STOPPED|PAUSED)\b|\bstop\(\) called\b', 2.0),
+    (r'\bno active tracks\b|\bstandby\b|\binactive\b', 1.5),
+    (r'\bdevice disconnected\b|\bSTATE_(?:STOPPED|PAUSED)\b', 1.5),
+]
+
+# Default confidence required to decide a window without the LLM
+# 无需大模型即可判定窗口所需的默认置信度
+DEFAULT_THRESHOLD = 0.85
+
+
+class HeuristicClassifier:
+    """Keyword/event scorer emitting results in the LLM response schema.
+    关键词/事件打分器，输出与大模型响应相同模式的结果。
+    """
+
+    def __init__(self, threshold: float = DEFAULT_THRESHOLD):
+        """Initialize the classifier.
+        初始化分类器。
+
+        Args:
+            threshold: Minimum confidence for a local decision (本地判定的最低置信度)
+        """
+        self.threshold = threshold
+        self._playing = [(re.compile(p, re.IGNORECASE), w) for p, w in PLAYING_PATTERNS]
+        self._muted = [(re.compile(p, re.IGNORECASE), w) for p, w in MUTED_PATTERNS]
+
+    def extract_features(self, window_lines: List[str]) -> Dict[str, Any]:
+        """Score indicator matches in a window.
+        为窗口中的指标匹配打分。
+
+        Later lines weigh more (up to 2x), since the verdict describes the state
+        the window ends in.
+        靠后的行权重更高（最多2倍），因为判定描述的是窗口结束时的状态。
+
+        Returns:
+            Dict with playing/muted scores, matched line counts and evidence lines
+            包含播放/静音得分、匹配行数和证据行的字典
+        """
+        playing_score = 0.0
+        muted_score = 0.0
+        playing_lines: List[str] = []
+        muted_lines: List[str] = []
+        last_signal: Optional[str] = None
+        count = len(window_lines)
+
+        for i, line in enumerate(window_lines):
+            recency = 1.0 + (i / (count - 1) if count > 1 else 1.0)
+            p = sum(w for pattern, w in self._playing if pattern.search(line))
+            m = sum(w for pattern, w in self._muted if pattern.search(line))
+            if p > m:
+                playing_score += p * recency
+                playing_lines.append(line)
+                last_signal = "PLAYING"
+            elif m > p:
+                muted_score += m * recency
+                muted_lines.append(line)
+                last_signal = "MUTED"
+
+        return {
+            "playing_score": playing_score,
+            "muted_score": muted_score,
+            "playing_lines": playing_lines,
+            "muted_lines": muted_lines,
+            "last_signal": last_signal
+        }
+
+    def classify(self, window_lines: List[str]) -> Dict[str, Any]:
+        """Classify a window, returning a result in the LLM schema.
+        对窗口分类，返回与大模型相同模式的结果。
+
+        Confidence grows with the total score and shrinks with conflicting
+        signals, so mixed windows stay below the threshold.
+        置信度随总分增加，随冲突信号减少，因此混合窗口会低于阈值。
+        """
+        features = self.extract_features(window_lines)
+        playing = features["playing_score"]
+        muted = features["muted_score"]
+        total = playing + muted
+
+        if total == 0:
+            return {
+                "final_state": "UNKNOWN",
+                "confidence": 0.0,
+                "reason": "Local heuristic: no playback or mute indicators",
+                "evidence": [],
+                "next_actions": [],
+                "decided_by": "heuristic"
+            }
+
+        state = "PLAYING" if playing >= muted else "MUTED"
+        dominant = max(playing, muted)
+        purity = dominant / total
+        # Saturates at ~0.95 once enough one-sided evidence accumulates
+        # 单边证据足够时约饱和于0.95
+        strength = dominant / (dominant + 4.0)
+        confidence = round(min(0.99, purity ** 2 * (0.5 + 0.5 * strength) * 1.1), 2)
+        if features["last_signal"] != state:
+            # The window ends on the opposite signal: a transition (窗口以相反信号结束：状态转换)
+            confidence = round(confidence * 0.5, 2)
+
+        lines = features["playing_lines"] if state == "PLAYING" else features["muted_lines"]
+        return {
+            "final_state": state,
+            "confidence": confidence,
+            "reason": (f"Local heuristic: playing score {playing:.1f}, "
+                       f"muted score {muted:.1f}"),
+            "evidence": lines[-5:],
+            "next_actions": [],
+            "decided_by": "heuristic"
+        }
+
+    def decide(self, window_lines: List[str]) -> Optional[Dict[str, Any]]:
+        """Return a local result if confident enough, else None to escalate.
+        置信度足够时返回本地结果，否则返回None表示交给大模型。
+        """
+        result = self.classify(window_lines)
+        if result["final_state"] != "UNKNOWN" and result["confidence"] >= self.threshold:
+            return result
+        return None
+
+
+def evaluate_thresholds(
+    windows: List[Tuple[int, List[str]]],
+    reference: Dict[int, str],
+    thresholds: List[float]
+) -> List[Dict[str, Any]]:
+    """Measure accuracy versus LLM calls across thresholds.
+    在不同阈值下衡量准确率与大模型调用次数的关系。
+
+    Args:
+        windows: List of (window_idx, window_lines) (窗口列表)
+        reference: window_idx -> reference state, e.g. from an LLM report
+                  窗口索引 -> 参考状态，例如来自大模型报告
+        thresholds: Thresholds to evaluate (要评估的阈值)
+
+    Returns:
+        One row per threshold: LLM calls needed, calls saved, local decisions and
+        their accuracy against the reference
+        每个阈值一行：所需大模型调用数、节省的调用数、本地判定数及其相对参考的准确率
+    """
+    classifier = HeuristicClassifier()
+    scored = [(idx, classifier.classify(lines)) for idx, lines in windows if idx in reference]
+    rows = []
+    for threshold in thresholds:
+        local = [(idx, r) for idx, r in scored
+                 if r["final_state"] != "UNKNOWN" and r["confidence"] >= threshold]
+        correct = sum(1 for idx, r in local if r["final_state"] == reference[idx])
+        rows.append({
+            "threshold": threshold,
+            "windows": len(scored),
+            "llm_calls": len(scored) - len(local),
+            "calls_saved": len(local),
+            "local_accuracy": round(correct / len(local), 3) if local else None,
+            # Escalated windows are assumed to match the reference (交给大模型的窗口假定与参考一致)
+            "overall_accuracy": round((len(scored) - len(local) + correct) / len(scored), 3) if scored else None
+        })
+    return rows
+
+
+def main():
+    """Evaluate the pre-classifier against an existing LLM report.
+    对照已有的大模型报告评估预分类器。
+    """
+    from .chunker import LogChunker
+    from .log_parser import LogParser
+    from .masker import DataMasker
+
+    parser = argparse.ArgumentParser(
+        prog="python -m src.heuristics",
+        description="Accuracy-versus-calls evaluation of the local pre-classifier"
+                    "\n本地预分类器的准确率与调用次数评估"
+    )
+    parser.add_argument("--log", required=True, help="Path to input log file (输入日志文件路径)")
+    parser.add_argument("--report", required=True,
+                        help="report.json from an LLM run of the same log and settings "
+                             "(相同日志和设置下大模型运行生成的report.json)")
+    parser.add_argument("--thresholds", default="0.6,0.7,0.8,0.85,0.9,0.95",
+                        help="Comma-separated thresholds (逗号分隔的阈值)")
+    args = parser.parse_args()
+
+    with open(args.report, 'r', encoding='utf-8') as f:
+        report = json.load(f)
+    metadata = report.get("metadata", {})
+    reference = {
+        r["window_idx"]: r["final_state"] for r in report.get("window_results", [])
+        if r.get("decided_by", "llm") == "llm" and not r.get("reason", "").startswith("Analysis failed")
+    }
+
+    lines = LogParser().parse_and_filter(args.log)
+    if metadata.get("masking_enabled"):
+        lines = DataMasker().mask_lines(lines)
+    windows = LogChunker(metadata.get("chunk_size", 200), metadata.get("overlap", 50)).chunk_lines(lines)
+
+    thresholds = [float(t) for t in args.thresholds.split(",")]
+    print(f"{'threshold':>10}{'llm_calls':>11}{'saved':>7}{'local_acc':>11}{'overall_acc':>13}")
+    for row in evaluate_thresholds(windows, reference, thresholds):
+        local_acc = "-" if row["local_accuracy"] is None else f"{row['local_accuracy']:.3f}"
+        overall = "-" if row["overall_accuracy"] is None else f"{row['overall_accuracy']:.3f}"
+        print(f"{row['threshold']:>10.2f}{row['llm_calls']:>11}{row['calls_saved']:>7}{local_acc:>11}{overall:>13}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,179 @@
+"""Append-only journal of window results for resuming interrupted analyses.
+用于恢复中断分析的窗口结果追加式日志。
+
+The first line is a header with the input fingerprint, the scheme that computed
+it and the settings that decide window boundaries and verdicts; every following line is one window result, written
+and flushed as soon as the window completes. A crash can at worst leave a
+partial last line, which is ignored on load.
+第一行是包含输入指纹、计算该指纹的方案以及决定窗口边界和结论的设置的头部；之后每行是一个窗口结果，窗口完成后立即写入并刷新。
+崩溃最多留下不完整的最后一行，加载时会被忽略。
+"""
+
+import hashlib
+import json
+import os
+import threading
+from pathlib import Path
+from typing import Any, Dict
+
+JOURNAL_VERSION = 1
+JOURNAL_NAME = "journal.jsonl"
+
+# Header fields that must match for a journal to be resumed (恢复时必须一致的头部字段)
+RESUME_KEYS = ("fingerprint", "chunk_size", "overlap", "masking_enabled", "model", "compact", "serialize")
+
+
+class JournalMismatch(ValueError):
+    """Raised when a journal was written for a different input or settings.
+    日志对应的输入或设置不同时抛出。
+    """
+
+
+def file_fingerprint(path: str, block_size: int = 1 << 20) -> str:
+    """SHA-256 of a file's contents, read in blocks (按块读取的文件内容SHA-256)."""
+    digest = hashlib.sha256()
+    with open(path, 'rb') as f:
+        for block in iter(lambda: f.read(block_size), b""):
+            digest.update(block)
+    return digest.hexdigest()
+
+
+def quick_fingerprint(path: str, sample: int = 1 << 20) -> str:
+    """Fingerprint from the size and the first and last ``sample`` bytes of a file.
+    由文件大小及首尾各 ``sample`` 字节计算的指纹。
+
+    Used by the pipelined mode, which must not read a multi-GB file before the
+    first request. Appending to a log changes it; an edit in the middle of a
+    large file does not.
+    用于流水线模式，该模式不能在第一个请求前读完数GB的文件。向日志追加内容会改变该指纹；
+    修改大文件中间部分则不会。
+    """
+    digest = hashlib.sha256()
+    with open(path, 'rb') as f:
+        size = f.seek(0, 2)
+        digest.update(str(size).encode())
+        f.seek(0)
+        digest.update(f.read(sample))
+        f.seek(max(size - sample, 0))
+        digest.update(f.read(sample))
+    return "quick:" + digest.hexdigest()
+
+
+def fingerprint_scheme(header: Dict[str, Any]) -> str:
+    """Scheme that computed a header's fingerprint: "sha256" or "quick".
+    计算头部指纹的方案："sha256" 或 "quick"。
+
+    Headers written before the scheme was recorded are told apart by the
+    "quick:" prefix.
+    记录方案之前写入的头部通过 "quick:" 前缀区分。
+    """
+    if header.get("fingerprint_scheme"):
+        return header["fingerprint_scheme"]
+    return "quick" if str(header.get("fingerprint", "")).startswith("quick:") else "sha256"
+
+
+class ResultJournal:
+    """Per-window results journal of one output directory.
+    单个输出目录的逐窗口结果日志。
+    """
+
+    def __init__(self, path: Path):
+        """Initialize the journal.
+        初始化日志。
+
+        Args:
+            path: JSONL journal file (JSONL日志文件)
+        """
+        self.path = Path(path)
+        self._lock = threading.Lock()
+        self._file = None
+
+    def start(self, header: Dict[str, Any], resume: bool = False) -> Dict[int, Dict[str, Any]]:
+        """Open the journal for appending, returning results to carry over.
+        打开日志以追加写入，返回需要沿用的结果。
+
+        Args:
+            header: Fingerprint and settings of this run (本次运行的指纹和设置)
+            resume: Keep an existing journal instead of starting over (保留已有日志而非重新开始)
+
+        Returns:
+            Completed results by window index; empty unless resuming
+            按窗口索引的已完成结果；非恢复时为空
+
+        Raises:
+            JournalMismatch: The existing journal belongs to another input or settings
+                            已有日志属于其他输入或设置
+        """
+        completed: Dict[int, Dict[str, Any]] = {}
+        if resume and self.path.exists():
+            saved, completed = self.load()
+            saved_scheme, scheme = fingerprint_scheme(saved), fingerprint_scheme(header)
+            if saved_scheme != scheme:
+                # The fingerprints cannot be compared, so say why instead of "fingerprint changed"
+                # 两个指纹无法比较，因此说明原因而非只报告"fingerprint changed"
+                raise JournalMismatch(
+                    f"Journal {self.path} was fingerprinted with the {saved_scheme} scheme but this run "
+                    f"uses the {scheme} scheme; resume in the mode that wrote it "
+                    f"({'with' if saved_scheme == 'quick' else 'without'} --pipeline)"
+                )
+            mismatched = [key for key in RESUME_KEYS if saved.get(key) != header.get(key)]
+            if mismatched:
+                raise JournalMismatch(
+                    f"Journal {self.path} was written for a different run ({', '.join(mismatched)} changed)"
+                )
+            self._drop_partial_line()
+            self._file = open(self.path, 'a', encoding='utf-8')
+            return completed
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        self._file = open(self.path, 'w', encoding='utf-8')
+        self._write({"type": "header", "version": JOURNAL_VERSION, **header})
+        return completed
+
+    def load(self):
+        """Read the header and the last successful result of each window.
+        读取头部以及每个窗口最后一次成功的结果。
+
+        Failed results are kept in the journal for the record but are not
+        returned, so resuming retries those windows.
+        失败结果保留在日志中供查阅，但不会返回，因此恢复时会重试这些窗口。
+        """
+        header: Dict[str, Any] = {}
+        completed: Dict[int, Dict[str, Any]] = {}
+        with open(self.path, 'r', encoding='utf-8') as f:
+            for line in f:
+                try:
+                    record = json.loads(line)
+                except json.JSONDecodeError:
+                    # Partial line from an interrupted write (中断写入留下的不完整行)
+                    continue
+                if record.get("type") == "header":
+                    header = record
+                elif record.get("type") == "result" and not record["result"].get("error"):
+                    completed[record["result"]["window_idx"]] = record["result"]
+        return header, completed
+
+    def append(self, result: Dict[str, Any]):
+        """Record one completed window (记录一个已完成的窗口)."""
+        with self._lock:
+            self._write({"type": "result", "result": result})
+
+    def close(self):
+        """Close the journal file (关闭日志文件)."""
+        with self._lock:
+            if self._file:
+                self._file.close()
+                self._file = None
+
+    def _drop_partial_line(self):
+        # Cut an unterminated last line so appended records start on their own line
+        # 截掉未结束的最后一行，使追加的记录从新行开始
+        with open(self.path, 'rb+') as f:
+            data = f.read()
+            if data and not data.endswith(b"\n"):
+                f.truncate(data.rfind(b"\n") + 1)
+
+    def _write(self, record: Dict[str, Any]):
+        self._file.write(json.dumps(record, ensure_ascii=False) + "\n")
+        self._file.flush()
+        os.fsync(self._file.fileno())
+
@@ -3,7 +3,9 @@
 """
 
 import re
-from typing import List, Optional
+from typing import Iterator, List, Optional, Tuple
+
+from .provenance import LineProvenance
 
 
 # Default audio-related tags commonly found in Android logcat
@@ -25,6 +27,10 @@ DEFAULT_AUDIO_TAGS = [
     "audio",
 ]
 
+# Splits a binary line at \r\n, \r or \n like text mode's universal newlines
+# 像文本模式的通用换行一样在 \r\n、\r 或 \n 处切分二进制行
+_NEWLINES = re.compile(rb'[^\r\n]*(?:\r\n|\r|\n)|[^\r\n]+')
+
 
 class LogParser:
     """Parser for Android logcat files.
@@ -56,6 +62,36 @@ class LogParser:
             lines = [line.rstrip() for line in f if line.strip()]
         return lines
 
+    def parse_file_with_provenance(self, file_path: str) -> Tuple[List[str], LineProvenance]:
+        """Parse a file like parse_file, also recording where each line came from.
+        与parse_file相同地解析文件，并记录每行的来源。
+        
+        Args:
+            file_path: Path to the log file (日志文件路径)
+            
+        Returns:
+            Tuple of (lines, provenance) with one provenance row per line
+            (行, 来源) 元组，每行对应一条来源记录
+        """
+        provenance = LineProvenance()
+        file_id = provenance.add_file(str(file_path))
+        lines = []
+        offset = 0
+        line_number = 0
+        with open(file_path, 'rb') as f:
+            for chunk in f:
+                # Lone \r only occurs in odd files; skip the regex otherwise (单独的\r仅见于少数文件，否则跳过正则)
+                raws = [chunk] if b'\r' not in chunk else [m.group() for m in _NEWLINES.finditer(chunk)]
+                for raw in raws:
+                    line_number += 1
+                    line = raw.decode('utf-8', errors='ignore')
+                    if line.strip():
+                        line = line.rstrip()
+                        lines.append(line)
+                        provenance.append(file_id, offset, line_number, line)
+                    offset += len(raw)
+        return lines, provenance
+
     def filter_audio_lines(self, lines: List[str]) -> List[str]:
         """Filter lines to only include audio-related content.
         过滤日志行，只保留音频相关的内容。
@@ -77,21 +113,55 @@ class LogParser:
             # 如果未指定标签，返回所有行
             return lines
         
+        pattern = self._tag_pattern()
+        
+        filtered = []
+        for line in lines:
+            if pattern.search(line):
+                filtered.append(line)
+        
+        return filtered
+
+    def filter_with_provenance(
+        self,
+        lines: List[str],
+        provenance: LineProvenance
+    ) -> Tuple[List[str], LineProvenance]:
+        """Filter like filter_audio_lines, keeping the provenance rows of retained lines.
+        与filter_audio_lines相同地过滤，并保留所留行的来源记录。
+        """
+        if not self.audio_tags:
+            return lines, provenance
+        pattern = self._tag_pattern()
+        kept = [i for i, line in enumerate(lines) if pattern.search(line)]
+        return [lines[i] for i in kept], provenance.select(kept)
+
+    def _tag_pattern(self):
         # Create a regex pattern that matches any of the audio tags
         # 创建匹配任何音频标签的正则表达式模式
         # Use word boundaries for more accurate matching
         # 使用单词边界以获得更准确的匹配
-        pattern = re.compile(
+        return re.compile(
             r'\b(' + '|'.join(re.escape(tag) for tag in self.audio_tags) + r')\b',
             re.IGNORECASE
         )
+
+    def iter_audio_lines(self, file_path: str) -> Iterator[str]:
+        """Yield the audio-related lines of a file while reading it.
+        边读取边产出文件中音频相关的行。
         
-        filtered = []
-        for line in lines:
-            if pattern.search(line):
-                filtered.append(line)
+        Yields the same lines as parse_and_filter without holding the file in
+        memory.
+        产出与parse_and_filter相同的行，但不会把整个文件保存在内存中。
         
-        return filtered
+        Args:
+            file_path: Path to the log file (日志文件路径)
+        """
+        pattern = self._tag_pattern() if self.audio_tags else None
+        with open(file_path, 'r', encoding='utf-8', errors='ignore') as f:
+            for line in f:
+                if line.strip() and (pattern is None or pattern.search(line)):
+                    yield line.rstrip()
 
     def parse_and_filter(self, file_path: str) -> List[str]:
         """Parse a file and filter for audio-related lines.
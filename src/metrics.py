@@ -0,0 +1,112 @@
+"""Small statistics helpers for latency and throughput reporting.
+用于延迟和吞吐量报告的统计工具。
+"""
+
+import math
+from typing import Any, Dict, List, Sequence
+
+from .pricing import estimate_cost
+
+
+def percentile(values: Sequence[float], pct: float) -> float:
+    """Return the pct-th percentile using linear interpolation.
+    使用线性插值计算第pct百分位数。
+
+    Args:
+        values: Sample values (样本值)
+        pct: Percentile between 0 and 100 (0到100之间的百分位)
+
+    Returns:
+        Percentile value, or 0.0 for an empty sample (百分位值，空样本返回0.0)
+    """
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    rank = (len(ordered) - 1) * pct / 100.0
+    low = math.floor(rank)
+    high = math.ceil(rank)
+    if low == high:
+        return float(ordered[low])
+    return ordered[low] + (ordered[high] - ordered[low]) * (rank - low)
+
+
+def summarize_latencies(latencies: List[float]) -> Dict[str, float]:
+    """Summarize latencies (seconds) as mean and p50/p95/p99.
+    将延迟（秒）汇总为均值及p50/p95/p99。
+    """
+    return {
+        "count": len(latencies),
+        "mean": round(sum(latencies) / len(latencies), 4) if latencies else 0.0,
+        "p50": round(percentile(latencies, 50), 4),
+        "p95": round(percentile(latencies, 95), 4),
+        "p99": round(percentile(latencies, 99), 4),
+        "max": round(max(latencies), 4) if latencies else 0.0
+    }
+
+
+def summarize_usage(window_results: List[Dict[str, Any]]) -> Dict[str, Any]:
+    """Aggregate per-window token usage, latency, retries and cost of a run.
+    汇总一次运行中各窗口的token用量、延迟、重试次数和成本。
+
+    Inferred results (reused or interpolated) cost nothing and are skipped;
+    windows that shared one packed request are counted as a single call. Calls
+    of lower cascade tiers a result replaced are read from ``lower_tier_calls``.
+    推断结果（复用或插值）没有成本，会被跳过；共享同一个打包请求的窗口只计为一次调用。
+    结果所取代的较低级联层级的调用从 ``lower_tier_calls`` 读取。
+
+    Args:
+        window_results: Window results carrying ``usage`` (带 ``usage`` 的窗口结果)
+
+    Returns:
+        Totals, latency percentiles and a per-model breakdown (总计、延迟百分位和按模型的细分)
+    """
+    calls: Dict[Any, Dict[str, Any]] = {}
+    for position, result in enumerate(window_results):
+        if result.get("inferred"):
+            continue
+        for level, record in enumerate([result] + result.get("lower_tier_calls", [])):
+            if not record.get("usage"):
+                continue
+            model = record.get("model")
+            key = (model, record["call_id"]) if record.get("call_id") is not None else ("window", position, level)
+            call = calls.setdefault(key, {
+                "model": model,
+                "prompt_tokens": 0,
+                "completion_tokens": 0,
+                "cached_tokens": 0,
+                "estimated": False,
+                "latency_s": record.get("latency_s"),
+                "retries": record.get("retries", 0)
+            })
+            for field in ("prompt_tokens", "completion_tokens", "cached_tokens"):
+                call[field] += record["usage"].get(field, 0)
+            call["estimated"] = call["estimated"] or record["usage"].get("estimated", False)
+
+    by_model: Dict[str, Dict[str, Any]] = {}
+    for call in calls.values():
+        stats = by_model.setdefault(call["model"] or "unknown", {
+            "calls": 0, "prompt_tokens": 0, "completion_tokens": 0, "cost_cny": 0.0
+        })
+        stats["calls"] += 1
+        stats["prompt_tokens"] += round(call["prompt_tokens"])
+        stats["completion_tokens"] += round(call["completion_tokens"])
+        stats["cost_cny"] += estimate_cost(call["model"], call["prompt_tokens"], call["completion_tokens"])
+    for stats in by_model.values():
+        stats["cost_cny"] = round(stats["cost_cny"], 6)
+
+    prompt = sum(stats["prompt_tokens"] for stats in by_model.values())
+    completion = sum(stats["completion_tokens"] for stats in by_model.values())
+    return {
+        "calls": len(calls),
+        "prompt_tokens": prompt,
+        "completion_tokens": completion,
+        "total_tokens": prompt + completion,
+        "cached_tokens": round(sum(call["cached_tokens"] for call in calls.values())),
+        "estimated_usage_calls": sum(1 for call in calls.values() if call["estimated"]),
+        "retries": sum(call["retries"] for call in calls.values()),
+        "latency_s": summarize_latencies(
+            [call["latency_s"] for call in calls.values() if call["latency_s"] is not None]
+        ),
+        "cost_cny": round(sum(stats["cost_cny"] for stats in by_model.values()), 6),
+        "by_model": by_model
+    }
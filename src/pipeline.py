@@ -0,0 +1,290 @@
+"""Pipelined analysis: reader, mask workers, LLM dispatcher and merger.
+流水线分析：读取器、脱敏工作线程、大模型调度器和合并器。
+
+The stages run concurrently and are connected by bounded queues:
+各阶段并发运行，通过有界队列连接：
+
+    reader ──raw──▶ mask workers ──masked──▶ LLM workers ──results──▶ merger
+
+The reader streams the file, filters audio lines and cuts windows as it goes,
+so the first request is sent as soon as the first window is read. When the
+LLM workers fall behind, the queues fill up and ``put`` blocks, which stops
+the reader: the windows held by the stages are bounded by the queue sizes, not
+by the file size. Results complete out of order; the reader also waits while
+a window is ``reorder_limit`` or more ahead of the oldest unfinished one, so
+a consumer that puts results back in order buffers at most ``reorder_limit``
+of them even when one request is slow. Results are handed to ``on_result``
+and only collected when no callback is given. When any stage fails, the
+reader stops and the other stages drain their queues without sending further
+requests.
+读取器以流式读取文件，边读边过滤音频行并切分窗口，因此读到第一个窗口即可发送第一个请求。
+当大模型工作线程跟不上时，队列填满，``put`` 阻塞并使读取器停下：各阶段持有的窗口受队列大小而非文件大小限制。
+结果乱序完成；当某窗口领先最早未完成的窗口达到 ``reorder_limit`` 个时，读取器同样等待，
+因此即使某个请求很慢，按顺序重排结果的消费者缓冲的结果也不超过 ``reorder_limit`` 个。
+结果交给 ``on_result``，仅在未提供回调时才收集。任一阶段失败时，读取器停止，其他阶段清空队列且不再发送请求。
+"""
+
+import queue
+import threading
+import time
+from typing import Any, Callable, Dict, List, Optional
+
+from .chunker import LogChunker
+from .log_parser import LogParser
+from .masker import DataMasker
+from .tracing import NULL_TRACER, Tracer
+
+# End-of-stream marker passed down each queue (沿各队列向下传递的流结束标记)
+_DONE = object()
+
+
+class Pipeline:
+    """Staged, backpressured analysis of one log file.
+    对单个日志文件的分阶段、带背压的分析。
+    """
+
+    def __init__(
+        self,
+        analyze: Callable[[int, List[str]], Dict[str, Any]],
+        chunker: LogChunker,
+        parser: Optional[LogParser] = None,
+        masker: Optional[DataMasker] = None,
+        workers: int = 4,
+        mask_workers: int = 2,
+        queue_size: int = 64,
+        reorder_limit: Optional[int] = None,
+        tracer: Optional[Tracer] = None
+    ):
+        """Initialize the pipeline.
+        初始化流水线。
+
+        Args:
+            analyze: Analyzes one window, returning its result; must not raise
+                    分析单个窗口并返回结果；不得抛出异常
+            chunker: Window size and overlap (窗口大小和重叠)
+            parser: Audio line filter (音频行过滤器)
+            masker: Masks windows before analysis, None to skip the stage
+                   分析前对窗口脱敏，为None时跳过该阶段
+            workers: Requests in flight (并发请求数)
+            mask_workers: Threads masking windows (脱敏线程数)
+            queue_size: Capacity of each queue, in windows (每个队列的容量，以窗口计)
+            reorder_limit: How far the reader may run ahead of the oldest unfinished
+                          window, in windows; defaults to queue_size plus workers
+                          读取器可领先最早未完成窗口的窗口数；默认为队列容量加并发请求数
+            tracer: Receives queue depth counters and stage spans (接收队列深度计数器和阶段跨度)
+        """
+        self.analyze = analyze
+        self.chunker = chunker
+        self.parser = parser or LogParser()
+        self.masker = masker
+        self.workers = max(workers, 1)
+        self.mask_workers = max(mask_workers, 1) if masker else 0
+        self.queue_size = max(queue_size, 1)
+        self.reorder_limit = max(reorder_limit or self.queue_size + self.workers, 1)
+        self.tracer = tracer or NULL_TRACER
+        self.queues: Dict[str, queue.Queue] = {}
+        self.max_depth: Dict[str, int] = {}
+        self.lines = 0
+        self.windows = 0
+        self.first_request_s: Optional[float] = None
+        self._error: Optional[BaseException] = None
+        self._stop = threading.Event()
+        self._lock = threading.Lock()
+        # Oldest window without a result, advanced by run() (尚无结果的最早窗口，由run()推进)
+        self._oldest = 0
+        self._advanced = threading.Condition(self._lock)
+
+    def depths(self) -> Dict[str, int]:
+        """Current number of windows waiting in each queue (各队列中当前等待的窗口数)."""
+        return {name: q.qsize() for name, q in self.queues.items()}
+
+    def _sample(self):
+        depths = self.depths()
+        with self._lock:
+            for name, depth in depths.items():
+                self.max_depth[name] = max(self.max_depth.get(name, 0), depth)
+        self.tracer.counter("queue_depth", **depths)
+
+    def _fail(self, error: BaseException):
+        # Keep the first error and stop every stage (保留第一个错误并停止所有阶段)
+        with self._lock:
+            if self._error is None:
+                self._error = error
+            self._stop.set()
+            self._advanced.notify_all()
+
+    def _wait_for_room(self, window_idx: int):
+        # Hold the window until the reorder limit allows it (等待重排上限允许该窗口)
+        with self._advanced:
+            self._advanced.wait_for(
+                lambda: window_idx < self._oldest + self.reorder_limit or self._stop.is_set()
+            )
+
+    def _complete(self, window_idx: int, finished: set):
+        # Advance past every window whose result is in (越过所有已有结果的窗口)
+        finished.add(window_idx)
+        with self._advanced:
+            while self._oldest in finished:
+                finished.discard(self._oldest)
+                self._oldest += 1
+            self._advanced.notify_all()
+
+    def _read(self, path: str, out: queue.Queue, consumers: int):
+        try:
+            with self.tracer.span("read_and_chunk", cat="pipeline"):
+                lines = self._count(self.parser.iter_audio_lines(path))
+                for window in self.chunker.iter_windows(lines):
+                    self._wait_for_room(window[0])
+                    if self._stop.is_set():
+                        break
+                    out.put(window)
+                    self.windows += 1
+                    self._sample()
+        except BaseException as e:
+            self._fail(e)
+        finally:
+            for _ in range(consumers):
+                out.put(_DONE)
+
+    def _count(self, lines):
+        for line in lines:
+            self.lines += 1
+            yield line
+
+    def _drain(self, inbox: queue.Queue):
+        # Keep consuming after a failure so upstream put() calls never block
+        # 失败后继续消费，使上游的put()调用不会阻塞
+        while inbox.get() is not _DONE:
+            pass
+
+    def _mask(self, inbox: queue.Queue, out: queue.Queue, remaining: List[int], consumers: int):
+        try:
+            while True:
+                item = inbox.get()
+                if item is _DONE:
+                    break
+                if self._stop.is_set():
+                    continue
+                window_idx, window_lines = item
+                out.put((window_idx, self.masker.mask_lines(window_lines)))
+        except BaseException as e:
+            self._fail(e)
+            self._drain(inbox)
+        finally:
+            # The last mask worker to finish ends the stream for the LLM workers
+            # 最后结束的脱敏线程为大模型工作线程结束数据流
+            with self._lock:
+                remaining[0] -= 1
+                last = remaining[0] == 0
+            if last:
+                for _ in range(consumers):
+                    out.put(_DONE)
+
+    def _dispatch(self, inbox: queue.Queue, out: queue.Queue, started: float):
+        try:
+            while True:
+                item = inbox.get()
+                if item is _DONE:
+                    break
+                if self._stop.is_set():
+                    # Drop queued windows instead of paying for requests whose results are discarded
+                    # 丢弃排队的窗口，而不是为会被丢弃的结果付费请求
+                    continue
+                with self._lock:
+                    if self.first_request_s is None:
+                        self.first_request_s = time.monotonic() - started
+                window_idx, window_lines = item
+                out.put(self.analyze(window_idx, window_lines))
+        except BaseException as e:
+            self._fail(e)
+            self._drain(inbox)
+        finally:
+            out.put(_DONE)
+
+    def run(
+        self,
+        path: str,
+        on_result: Optional[Callable[[Dict[str, Any]], None]] = None
+    ) -> List[Dict[str, Any]]:
+        """Analyze a file, calling ``on_result`` from this thread as results complete.
+        分析文件，结果完成时在当前线程中调用 ``on_result``。
+
+        An exception raised by ``on_result`` stops the pipeline like a stage
+        failure and is raised once the stages have shut down.
+        ``on_result`` 抛出的异常与阶段失败一样会停止流水线，并在各阶段关闭后抛出。
+
+        Returns:
+            Window results ordered by window index without ``on_result``; empty
+            with it, since the callback takes each result
+            未提供 ``on_result`` 时为按窗口索引排序的窗口结果；提供时为空，因为回调接收每个结果
+
+        Raises:
+            OSError: The file could not be read (无法读取文件)
+        """
+        started = time.monotonic()
+        self._error = None
+        self._stop.clear()
+        self._oldest = 0
+        raw = queue.Queue(maxsize=self.queue_size)
+        masked = queue.Queue(maxsize=self.queue_size) if self.masker else raw
+        results = queue.Queue(maxsize=self.queue_size)
+        self.queues = {"raw": raw, "masked": masked, "results": results} if self.masker else {
+            "raw": raw, "results": results
+        }
+
+        threads = [threading.Thread(
+            target=self._read, args=(path, raw, self.mask_workers or self.workers), name="pipeline-reader"
+        )]
+        remaining = [self.mask_workers]
+        threads += [
+            threading.Thread(
+                target=self._mask, args=(raw, masked, remaining, self.workers), name=f"pipeline-mask-{i}"
+            )
+            for i in range(self.mask_workers)
+        ]
+        threads += [
+            threading.Thread(target=self._dispatch, args=(masked, results, started), name=f"pipeline-llm-{i}")
+            for i in range(self.workers)
+        ]
+        for thread in threads:
+            thread.daemon = True
+            thread.start()
+
+        window_results = []
+        finished = 0
+        completed: set = set()
+        while finished < self.workers:
+            item = results.get()
+            if item is _DONE:
+                finished += 1
+                continue
+            self._sample()
+            self._complete(item["window_idx"], completed)
+            if self._stop.is_set():
+                continue
+            if on_result is None:
+                window_results.append(item)
+                continue
+            try:
+                on_result(item)
+            except BaseException as e:
+                # Keep consuming so the workers can finish (继续消费，使工作线程能够结束)
+                self._fail(e)
+        for thread in threads:
+            thread.join()
+        if self._error:
+            raise self._error
+        return sorted(window_results, key=lambda r: r["window_idx"])
+
+    def stats(self) -> Dict[str, Any]:
+        """Counts, queue capacity and peak depths of the last run (上次运行的计数、队列容量和峰值深度)."""
+        return {
+            "lines": self.lines,
+            "windows": self.windows,
+            "workers": self.workers,
+            "mask_workers": self.mask_workers,
+            "queue_size": self.queue_size,
+            "reorder_limit": self.reorder_limit,
+            "max_queue_depth": dict(self.max_depth),
+            "first_request_s": round(self.first_request_s, 4) if self.first_request_s is not None else None
+        }
@@ -0,0 +1,77 @@
+"""Per-model prices, latencies and rate limits for cost and time estimates.
+用于成本和耗时估算的各模型价格、延迟和速率限制。
+
+Prices are list prices in CNY per 1,000 tokens and change over time; adjust
+MODEL_PRICES to match your account. Latencies and rate limits are typical
+values; adjust MODEL_LATENCY and MODEL_RATE_LIMITS likewise.
+价格为每千token的人民币标价，会随时间调整；请按账户实际价格修改MODEL_PRICES。
+延迟和速率限制为典型值，同样请按需修改MODEL_LATENCY和MODEL_RATE_LIMITS。
+"""
+
+from typing import Dict, Optional
+
+
+# model -> (input price, output price), CNY per 1K tokens (模型 -> (输入单价, 输出单价)，元/千token)
+MODEL_PRICES: Dict[str, tuple] = {
+    "qwen-turbo": (0.0003, 0.0006),
+    "qwen-plus": (0.0008, 0.002),
+    "qwen-max": (0.0024, 0.0096),
+    "qwen-long": (0.0005, 0.002),
+}
+
+# model -> (seconds before the first output token, output tokens per second)
+# 模型 -> (首个输出token前的秒数, 每秒输出token数)
+MODEL_LATENCY: Dict[str, tuple] = {
+    "qwen-turbo": (0.4, 120.0),
+    "qwen-plus": (0.6, 60.0),
+    "qwen-max": (1.0, 30.0),
+    "qwen-long": (0.8, 50.0),
+}
+
+# model -> (requests per minute, tokens per minute) (模型 -> (每分钟请求数, 每分钟token数))
+MODEL_RATE_LIMITS: Dict[str, tuple] = {
+    "qwen-turbo": (1200, 5000000),
+    "qwen-plus": (15000, 1200000),
+    "qwen-max": (1200, 1000000),
+    "qwen-long": (100, 1000000),
+}
+
+# Prices assumed for models missing from the table (表中没有的模型所采用的价格)
+DEFAULT_MODEL = "qwen-plus"
+
+# Typical output tokens of one single-window response (单窗口响应的典型输出token数)
+EXPECTED_OUTPUT_TOKENS = 300
+
+# Typical output tokens of one compact-schema response (单个紧凑模式响应的典型输出token数)
+EXPECTED_COMPACT_OUTPUT_TOKENS = 80
+
+
+def model_prices(model: Optional[str]) -> tuple:
+    """(input, output) price per 1K tokens for a model (模型每千token的(输入, 输出)价格)."""
+    return MODEL_PRICES.get(model or DEFAULT_MODEL, MODEL_PRICES[DEFAULT_MODEL])
+
+
+def estimate_cost(model: Optional[str], prompt_tokens: int, completion_tokens: int) -> float:
+    """Cost in CNY of a call with the given token counts.
+    按给定token数计算一次调用的人民币成本。
+    """
+    input_price, output_price = model_prices(model)
+    return (prompt_tokens * input_price + completion_tokens * output_price) / 1000.0
+
+
+def model_latency(model: Optional[str]) -> tuple:
+    """(first-token seconds, output tokens/s) for a model (模型的(首token秒数, 每秒输出token数))."""
+    return MODEL_LATENCY.get(model or DEFAULT_MODEL, MODEL_LATENCY[DEFAULT_MODEL])
+
+
+def model_rate_limits(model: Optional[str]) -> tuple:
+    """(requests, tokens) per minute for a model (模型每分钟的(请求数, token数))."""
+    return MODEL_RATE_LIMITS.get(model or DEFAULT_MODEL, MODEL_RATE_LIMITS[DEFAULT_MODEL])
+
+
+def estimate_latency(model: Optional[str], completion_tokens: int) -> float:
+    """Seconds for one call producing the given output tokens.
+    产生给定输出token数的单次调用耗时（秒）。
+    """
+    first_token, tokens_per_second = model_latency(model)
+    return first_token + completion_tokens / tokens_per_second
@@ -0,0 +1,167 @@
+"""Source positions of retained log lines and evidence lookup.
+保留日志行的源位置及证据查找。
+
+Parsing drops empty lines and filtering drops most of the rest, so a line's
+index in the filtered list says nothing about where it came from. A
+LineProvenance keeps, for every retained line, its source file, byte offset,
+1-based line number and parsed timestamp in parallel ``array`` columns (about
+26 bytes per line) instead of per-line objects. Masking replaces lines one for
+one, so the columns stay valid after it.
+解析会丢弃空行，过滤会丢弃其余大部分行，因此行在过滤后列表中的索引无法说明其来源。
+LineProvenance以并行的 ``array`` 列（每行约26字节）而非逐行对象，记录每个保留行的源文件、字节偏移、
+从1开始的行号和解析后的时间戳。脱敏逐行替换，因此脱敏后各列仍然有效。
+
+Timestamps are stored as milliseconds since January 1st; logcat omits the
+year, so a leap year is assumed and no year is reported.
+时间戳以自1月1日起的毫秒数存储；logcat不含年份，因此按闰年计算且不报告年份。
+"""
+
+import re
+from array import array
+from typing import Any, Dict, Iterable, List, Optional
+
+# Stored for lines without a timestamp (无时间戳的行存储此值)
+NO_TIME = -1
+
+_TIMESTAMP = re.compile(r'(\d{2})-(\d{2})\s+(\d{2}):(\d{2}):(\d{2})\.(\d{3})')
+# Days before each month in a leap year (闰年中每月之前的天数)
+_MONTH_START = (0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335)
+
+
+def parse_timestamp(line: str) -> int:
+    """Milliseconds since January 1st of the timestamp a line starts with.
+    行首时间戳自1月1日起的毫秒数。
+
+    Returns:
+        Milliseconds, or NO_TIME if the line has no timestamp (毫秒数；无时间戳时为NO_TIME)
+    """
+    m = _TIMESTAMP.match(line)
+    if not m:
+        return NO_TIME
+    month, day, hour, minute, second, millis = (int(g) for g in m.groups())
+    if not 1 <= month <= 12:
+        return NO_TIME
+    days = _MONTH_START[month - 1] + day - 1
+    return (((days * 24 + hour) * 60 + minute) * 60 + second) * 1000 + millis
+
+
+def format_timestamp(millis: int) -> Optional[str]:
+    """Logcat form of a stored timestamp, e.g. "01-06 10:15:23.456" (存储时间戳的logcat形式)."""
+    if millis == NO_TIME:
+        return None
+    seconds, millis = divmod(millis, 1000)
+    minutes, second = divmod(seconds, 60)
+    hours, minute = divmod(minutes, 60)
+    days, hour = divmod(hours, 24)
+    month = max(i for i, start in enumerate(_MONTH_START) if start <= days)
+    return f"{month + 1:02d}-{days - _MONTH_START[month] + 1:02d} {hour:02d}:{minute:02d}:{second:02d}.{millis:03d}"
+
+
+class LineProvenance:
+    """Parallel columns of source positions, one row per retained line.
+    源位置的并行列，每个保留行一行。
+    """
+
+    def __init__(self, files: Optional[List[str]] = None):
+        """Initialize empty columns.
+        初始化空列。
+
+        Args:
+            files: Source file table indexed by the file column (按文件列索引的源文件表)
+        """
+        self.files: List[str] = list(files or [])
+        self.file_ids = array('H')
+        self.offsets = array('q')
+        self.line_numbers = array('q')
+        self.times = array('q')
+
+    def __len__(self) -> int:
+        return len(self.offsets)
+
+    def add_file(self, path: str) -> int:
+        """Register a source file and return its id (注册源文件并返回其编号)."""
+        self.files.append(path)
+        return len(self.files) - 1
+
+    def append(self, file_id: int, offset: int, line_number: int, line: str):
+        """Record the position of the next retained line.
+        记录下一个保留行的位置。
+
+        Args:
+            file_id: Id from add_file (add_file返回的编号)
+            offset: Byte offset of the line in the file (行在文件中的字节偏移)
+            line_number: 1-based line number in the file (文件中从1开始的行号)
+            line: Line text, for its timestamp (行文本，用于解析时间戳)
+        """
+        self.file_ids.append(file_id)
+        self.offsets.append(offset)
+        self.line_numbers.append(line_number)
+        self.times.append(parse_timestamp(line))
+
+    def select(self, indices: Iterable[int]) -> "LineProvenance":
+        """Rows at the given indices, e.g. the lines kept by a filter (给定索引处的行，例如过滤保留的行)."""
+        selected = LineProvenance(self.files)
+        for i in indices:
+            selected.file_ids.append(self.file_ids[i])
+            selected.offsets.append(self.offsets[i])
+            selected.line_numbers.append(self.line_numbers[i])
+            selected.times.append(self.times[i])
+        return selected
+
+    def timestamp(self, idx: int) -> Optional[str]:
+        """Timestamp of a retained line, None if it has none (保留行的时间戳，无则为None)."""
+        return format_timestamp(self.times[idx])
+
+    def elapsed_s(self, first: int, last: int) -> Optional[float]:
+        """Seconds between two retained lines' timestamps, None if unknown.
+        两个保留行时间戳之间的秒数，未知时为None。
+        """
+        start, end = self.times[first], self.times[last]
+        if start == NO_TIME or end == NO_TIME or end < start:
+            return None
+        return (end - start) / 1000
+
+    def position(self, idx: int) -> Dict[str, Any]:
+        """Source file, byte offset, line number and timestamp of a retained line.
+        保留行的源文件、字节偏移、行号和时间戳。
+        """
+        return {
+            "file": self.files[self.file_ids[idx]],
+            "byte_offset": self.offsets[idx],
+            "line_number": self.line_numbers[idx],
+            "timestamp": self.timestamp(idx)
+        }
+
+
+class EvidenceIndex:
+    """Resolves evidence lines quoted by the LLM to their file positions in O(1).
+    以O(1)将大模型引用的证据行解析为其文件位置。
+
+    Evidence is quoted from the (possibly masked) lines that were sent, so the
+    index maps those exact lines, stripped, to their first occurrence.
+    证据引用自已发送的（可能已脱敏的）行，因此索引将这些行（去除首尾空白）映射到其首次出现的位置。
+    """
+
+    def __init__(self, lines: List[str], provenance: LineProvenance):
+        """Build the index.
+        构建索引。
+
+        Args:
+            lines: Retained lines as sent to the LLM (发送给大模型的保留行)
+            provenance: Positions of the same lines (相同行的位置)
+        """
+        self.provenance = provenance
+        self._first: Dict[str, int] = {}
+        for idx, line in enumerate(lines):
+            self._first.setdefault(line.strip(), idx)
+
+    def line_index(self, evidence: str) -> Optional[int]:
+        """Index of an evidence line among the retained lines (证据行在保留行中的索引)."""
+        return self._first.get(evidence.strip())
+
+    def resolve(self, evidence: str) -> Optional[Dict[str, Any]]:
+        """File position of an evidence line, None if it is not a retained line.
+        证据行的文件位置；不是保留行时为None。
+        """
+        idx = self.line_index(evidence)
+        return self.provenance.position(idx) if idx is not None else None
@@ -0,0 +1,168 @@
+"""Record real LLM exchanges and replay them from the local stub server.
+录制真实的大模型交互，并通过本地替身服务器回放。
+"""
+
+import hashlib
+import json
+import math
+import random
+import threading
+import time
+from pathlib import Path
+from typing import Any, Dict, List, Optional
+
+from .stub_server import default_responder
+
+
+def exchange_key(payload: Dict[str, Any]) -> str:
+    """Stable key for a request: hash of its messages.
+    请求的稳定键：消息内容的哈希。
+    """
+    messages = json.dumps(payload.get("messages", []), sort_keys=True, ensure_ascii=False)
+    return hashlib.sha256(messages.encode("utf-8")).hexdigest()
+
+
+class ExchangeRecorder:
+    """Appends request/response pairs to a JSONL recording file.
+    将请求/响应对追加写入JSONL录制文件。
+
+    Pass an instance as ``BailianClient(recorder=...)``; the client calls it with
+    the request payload and the raw response body of every completed request.
+    作为 ``BailianClient(recorder=...)`` 传入；客户端在每个请求完成后以请求负载和原始响应体调用它。
+    """
+
+    def __init__(self, path: Path):
+        """Initialize the recorder.
+        初始化录制器。
+
+        Args:
+            path: JSONL file to append to (要追加写入的JSONL文件)
+        """
+        self.path = Path(path)
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        self._lock = threading.Lock()
+
+    def __call__(self, payload: Dict[str, Any], response_body: Dict[str, Any], latency: float = 0.0):
+        record = {
+            "key": exchange_key(payload),
+            "request": payload,
+            "response": response_body,
+            "latency": round(latency, 4)
+        }
+        line = json.dumps(record, ensure_ascii=False) + "\n"
+        with self._lock:
+            with open(self.path, 'a', encoding='utf-8') as f:
+                f.write(line)
+
+
+def load_recordings(path: Path) -> List[Dict[str, Any]]:
+    """Load all records from a recording file (从录制文件加载全部记录)."""
+    records = []
+    with open(path, 'r', encoding='utf-8') as f:
+        for line in f:
+            if line.strip():
+                records.append(json.loads(line))
+    return records
+
+
+class LatencyModel:
+    """Seeded latency distribution for reproducible replay.
+    可复现回放所用的带种子延迟分布。
+
+    Specs (seconds) (规格，单位秒):
+        ``none``, ``fixed:0.5``, ``uniform:0.2,1.5``,
+        ``lognormal:0.8,0.4`` (median, sigma), ``recorded`` (use recorded latency)
+    """
+
+    def __init__(self, spec: str = "none", seed: int = 0, scale: float = 1.0):
+        """Initialize the latency model.
+        初始化延迟模型。
+
+        Args:
+            spec: Distribution spec (分布规格)
+            seed: Random seed (随机种子)
+            scale: Multiplier applied to every sample (应用于每个采样的倍数)
+        """
+        kind, _, params = spec.partition(":")
+        self.kind = kind.strip().lower()
+        self.params = [float(p) for p in params.split(",") if p.strip()]
+        self.scale = scale
+        self._rng = random.Random(seed)
+        self._lock = threading.Lock()
+
+        expected = {"none": 0, "recorded": 0, "fixed": 1, "uniform": 2, "lognormal": 2}
+        if self.kind not in expected:
+            raise ValueError(f"Unknown latency distribution: {spec}")
+        if len(self.params) != expected[self.kind]:
+            raise ValueError(f"Latency distribution '{self.kind}' needs {expected[self.kind]} parameters")
+
+    def sample(self, recorded: float = 0.0) -> float:
+        """Draw one latency in seconds (采样一个延迟值，单位秒)."""
+        with self._lock:
+            if self.kind == "fixed":
+                value = self.params[0]
+            elif self.kind == "uniform":
+                value = self._rng.uniform(self.params[0], self.params[1])
+            elif self.kind == "lognormal":
+                value = self._rng.lognormvariate(math.log(self.params[0]), self.params[1])
+            elif self.kind == "recorded":
+                value = recorded
+            else:
+                value = 0.0
+        return max(value, 0.0) * self.scale
+
+
+class ReplayResponder:
+    """StubServer responder that answers from recorded exchanges.
+    根据录制的交互作答的StubServer响应器。
+
+    Requests are matched by ``exchange_key``. Unmatched requests are answered by
+    cycling through the recordings in order, unless ``strict`` is set.
+    请求按 ``exchange_key`` 匹配。未匹配的请求按顺序循环使用录制内容作答，除非设置了 ``strict``。
+    """
+
+    def __init__(
+        self,
+        records: List[Dict[str, Any]],
+        latency: Optional[LatencyModel] = None,
+        strict: bool = False,
+        sleep=time.sleep
+    ):
+        """Initialize the replay responder.
+        初始化回放响应器。
+
+        Args:
+            records: Records from load_recordings (load_recordings加载的记录)
+            latency: Latency model applied before answering (作答前应用的延迟模型)
+            strict: Raise KeyError for unmatched requests (对未匹配请求抛出KeyError)
+            sleep: Sleep function (休眠函数)
+        """
+        self.records = records
+        self.by_key = {record["key"]: record for record in records}
+        self.latency = latency or LatencyModel()
+        self.strict = strict
+        self.sleep = sleep
+        self.hits = 0
+        self.misses = 0
+        self._next = 0
+        self._lock = threading.Lock()
+
+    def __call__(self, payload: Dict[str, Any]) -> Any:
+        record = self.by_key.get(exchange_key(payload))
+        with self._lock:
+            if record is not None:
+                self.hits += 1
+            else:
+                self.misses += 1
+                if self.strict:
+                    raise KeyError("No recording for request")
+                if self.records:
+                    record = self.records[self._next % len(self.records)]
+                    self._next += 1
+
+        delay = self.latency.sample(record.get("latency", 0.0) if record else 0.0)
+        if delay > 0:
+            self.sleep(delay)
+        if record is None:
+            return default_responder(payload)
+        return record["response"]
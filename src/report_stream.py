@@ -0,0 +1,252 @@
+"""JSON Lines report format, read lazily.
+可惰性读取的JSON Lines报告格式。
+
+A report is one JSON object per line: a ``window`` record per window result,
+then the ``segment`` records, ``summary``, ``metadata``, optional
+``diagnosis`` and ``timeline`` records and a final ``end`` record. The report
+is written once the analysis has finished, one record at a time, so nothing
+holds the whole report as one object; readers can iterate window records
+without loading the file. A run that dies before then leaves no report, only
+its journal. The file may be compressed with zstd (needs the
+``zstandard`` package) or gzip; ``orjson`` is used for encoding when installed.
+报告每行一个JSON对象：每个窗口结果一条 ``window`` 记录，之后是 ``segment`` 记录、
+``summary``、``metadata``、可选的 ``diagnosis`` 和 ``timeline`` 记录以及最后的 ``end`` 记录。报告在分析完成后逐条写出，
+不会把整个报告作为单个对象保存；读取方可以逐条读取窗口记录而无需加载整个文件。在此之前终止的运行不会留下报告，只有其日志。文件可用zstd（需要 ``zstandard`` 包）或gzip压缩；
+安装了 ``orjson`` 时用它进行编码。
+
+Usage (用法):
+    python -m src.report_stream output/report.jsonl.zst
+"""
+
+import argparse
+import gzip
+import io
+import json
+import sys
+from pathlib import Path
+from typing import Any, Dict, Iterator, List, Optional
+
+try:
+    import orjson
+except ImportError:  # pragma: no cover - optional dependency
+    orjson = None
+
+try:
+    import zstandard
+except ImportError:  # pragma: no cover - optional dependency
+    zstandard = None
+
+FORMAT_VERSION = 1
+COMPRESSIONS = ("zstd", "gzip")
+SUFFIXES = {None: "", "zstd": ".zst", "gzip": ".gz"}
+
+_ZSTD_MAGIC = b"\x28\xb5\x2f\xfd"
+_GZIP_MAGIC = b"\x1f\x8b"
+# Window records start with this prefix, so readers can skip them unparsed
+# 窗口记录以此前缀开头，读取方无需解析即可跳过
+_WINDOW_PREFIX = b'{"type":"window"'
+
+
+def dumps(record: Dict[str, Any]) -> bytes:
+    """Compact UTF-8 JSON of a record, with orjson when available.
+    记录的紧凑UTF-8 JSON，可用时使用orjson。
+    """
+    if orjson is not None:
+        return orjson.dumps(record, option=orjson.OPT_NON_STR_KEYS)
+    return json.dumps(record, ensure_ascii=False, separators=(",", ":")).encode("utf-8")
+
+
+def report_path(out_dir: Path, compression: Optional[str] = None) -> Path:
+    """Report file name for a compression, e.g. report.jsonl.zst (对应压缩方式的报告文件名)."""
+    return Path(out_dir) / f"report.jsonl{SUFFIXES[compression]}"
+
+
+def check_compression(compression: Optional[str]):
+    """Fail early if a compression is unknown or its package is missing.
+    压缩方式未知或所需包缺失时尽早失败。
+    """
+    if compression not in SUFFIXES:
+        raise ValueError(f"Unknown compression: {compression!r} (expected one of {', '.join(COMPRESSIONS)})")
+    if compression == "zstd" and zstandard is None:
+        raise ValueError("zstd compression needs the zstandard package (pip install zstandard)")
+
+
+def _open_write(path: Path, compression: Optional[str]):
+    check_compression(compression)
+    if compression is None:
+        return open(path, 'wb')
+    if compression == "gzip":
+        return gzip.open(path, 'wb', compresslevel=6)
+    return zstandard.ZstdCompressor(level=3).stream_writer(open(path, 'wb'), closefd=True)
+
+
+def _open_read(path: Path):
+    with open(path, 'rb') as f:
+        magic = f.read(4)
+    if magic.startswith(_GZIP_MAGIC):
+        return gzip.open(path, 'rb')
+    if magic == _ZSTD_MAGIC:
+        if zstandard is None:
+            raise ValueError(f"{path} is zstd-compressed; install the zstandard package to read it")
+        return io.BufferedReader(zstandard.ZstdDecompressor().stream_reader(open(path, 'rb'), closefd=True))
+    return open(path, 'rb')
+
+
+class ReportWriter:
+    """Writes a JSONL report record by record.
+    逐条记录写出JSONL报告。
+    """
+
+    def __init__(self, path: Path, compression: Optional[str] = None):
+        """Open the report for writing.
+        打开报告以写入。
+
+        Args:
+            path: Report file (报告文件)
+            compression: None, "zstd" or "gzip" (压缩方式)
+        """
+        self.path = Path(path)
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        self._file = _open_write(self.path, compression)
+        self.windows = 0
+
+    def _write(self, kind: str, record: Dict[str, Any]):
+        self._file.write(dumps({"type": kind, **record}) + b"\n")
+
+    def window(self, result: Dict[str, Any]):
+        """Append one window result (追加一个窗口结果)."""
+        self._write("window", result)
+        self.windows += 1
+
+    def finish(
+        self,
+        segments: List[Dict[str, Any]],
+        summary: Dict[str, Any],
+        metadata: Dict[str, Any],
+        diagnosis: Optional[Dict[str, Any]] = None,
+        timeline: Optional[Dict[str, Any]] = None
+    ):
+        """Write the closing records and close the file.
+        写出结尾记录并关闭文件。
+        """
+        for segment in segments:
+            self._write("segment", segment)
+        self._write("summary", summary)
+        self._write("metadata", metadata)
+        if diagnosis is not None:
+            self._write("diagnosis", diagnosis)
+        if timeline is not None:
+            self._write("timeline", timeline)
+        self._write("end", {"version": FORMAT_VERSION, "windows": self.windows, "segments": len(segments)})
+        self.close()
+
+    def close(self):
+        """Close the file; a report closed before finish() has no end record.
+        关闭文件；在finish()之前关闭的报告没有end记录。
+        """
+        if self._file:
+            self._file.close()
+            self._file = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+class ReportReader:
+    """Lazy reader of a JSONL report.
+    JSONL报告的惰性读取器。
+
+    ``windows()`` streams window results one at a time; the small closing
+    records are read in one pass that skips window lines without parsing them.
+    ``windows()`` 逐个流式读取窗口结果；较小的结尾记录通过一次扫描读取，窗口行不解析直接跳过。
+    """
+
+    def __init__(self, path: Path):
+        self.path = Path(path)
+        self._tail: Optional[Dict[str, Any]] = None
+
+    def records(self) -> Iterator[Dict[str, Any]]:
+        """All records in file order (按文件顺序的全部记录)."""
+        with _open_read(self.path) as f:
+            for line in f:
+                if line.strip():
+                    yield json.loads(line)
+
+    def windows(self) -> Iterator[Dict[str, Any]]:
+        """Window results in file order (按文件顺序的窗口结果)."""
+        with _open_read(self.path) as f:
+            for line in f:
+                if line.startswith(_WINDOW_PREFIX):
+                    record = json.loads(line)
+                    del record["type"]
+                    yield record
+
+    def _closing(self) -> Dict[str, Any]:
+        if self._tail is None:
+            tail: Dict[str, Any] = {"segment": []}
+            with _open_read(self.path) as f:
+                for line in f:
+                    if not line.strip() or line.startswith(_WINDOW_PREFIX):
+                        continue
+                    record = json.loads(line)
+                    kind = record.pop("type")
+                    if kind == "segment":
+                        tail["segment"].append(record)
+                    else:
+                        tail[kind] = record
+            self._tail = tail
+        return self._tail
+
+    def segments(self) -> List[Dict[str, Any]]:
+        """Merged segments (合并后的片段)."""
+        return self._closing()["segment"]
+
+    def summary(self) -> Dict[str, Any]:
+        """Report summary (报告摘要)."""
+        return self._closing().get("summary", {})
+
+    def metadata(self) -> Dict[str, Any]:
+        """Analysis metadata (分析元数据)."""
+        return self._closing().get("metadata", {})
+
+    def diagnosis(self) -> Optional[Dict[str, Any]]:
+        """Whole-log diagnosis, if the run produced one (整份日志诊断，如有)."""
+        return self._closing().get("diagnosis")
+
+    def timeline(self) -> Optional[Dict[str, Any]]:
+        """Line-level state timeline (行级状态时间线)."""
+        return self._closing().get("timeline")
+
+    @property
+    def complete(self) -> bool:
+        """Whether the report was finished (end record present) (报告是否已写完)."""
+        return "end" in self._closing()
+
+
+def main(argv: Optional[List[str]] = None):
+    """Print the summary of a JSONL report.
+    打印JSONL报告的摘要。
+    """
+    parser = argparse.ArgumentParser(
+        prog="python -m src.report_stream",
+        description="Summarize a JSONL report\n汇总JSONL报告"
+    )
+    parser.add_argument("report", help="report.jsonl, report.jsonl.zst or report.jsonl.gz (报告文件)")
+    args = parser.parse_args(argv)
+
+    reader = ReportReader(Path(args.report))
+    if not reader.complete:
+        print("Warning: report has no end record (writing was interrupted)", file=sys.stderr)
+    summary = reader.summary()
+    print(f"Windows: {summary.get('total_windows', 0)}, segments: {summary.get('total_segments', 0)}")
+    for segment in reader.segments():
+        print(f"  {segment['state']}: windows {segment['start_window']}-{segment['end_window']} "
+              f"(confidence {segment['confidence_avg']:.2f})")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,179 @@
+"""Salience scoring and budgeted window scheduling.
+显著性评分与预算内的窗口调度。
+
+Windows with errors, underruns, buffer timeouts, routing changes and mute
+commands are the most informative, so under a fixed budget they are analyzed
+first. Windows left over are reported as unanalyzed gaps.
+包含错误、欠载、缓冲区超时、路由变化和静音命令的窗口信息量最大，因此在固定预算下优先分析。剩余窗口作为未分析区间报告。
+"""
+
+import re
+import threading
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+from .pricing import EXPECTED_OUTPUT_TOKENS, estimate_cost
+from .tokens import MESSAGE_OVERHEAD_TOKENS, estimate_lines_tokens, estimate_tokens
+
+
+# (pattern, weight) salience features (显著性特征)
+SALIENCE_FEATURES = [
+    (re.compile(r'^\S+\s+\S+\s+\d+\s+\d+\s+E\s'), 3.0),
+    (re.compile(r'^\S+\s+\S+\s+\d+\s+\d+\s+W\s'), 1.5),
+    (re.compile(r'underrun', re.IGNORECASE), 3.0),
+    (re.compile(r'obtainBuffer.*timed out|\btimed out\b|\btimeout\b', re.IGNORECASE), 3.0),
+    (re.compile(r'\b(?:error|fail(?:ed|ure)?|exception)\b', re.IGNORECASE), 2.0),
+    (re.compile(r'\brouting\b|\boutput device\b|\bdevice (?:dis)?connected\b', re.IGNORECASE), 2.0),
+    (re.compile(r'\bmute\b|\bmuted\b|\bunmute', re.IGNORECASE), 2.0),
+    (re.compile(r'\bvolume\b|\blevel=', re.IGNORECASE), 1.0),
+    (re.compile(r'\b(?:start|stop|pause)\(\)|\btrack (?:started|stopped|paused)\b', re.IGNORECASE), 1.5),
+]
+
+# Matches of one feature beyond this count add nothing (单个特征超过此次数的匹配不再加分)
+FEATURE_CAP = 5
+
+
+def salience_score(window_lines: List[str]) -> float:
+    """Score how informative a window is (评估窗口的信息量).
+
+    Each feature contributes its weight per matching line, capped at
+    FEATURE_CAP lines so one repeated message cannot dominate.
+    每个特征按匹配行数计分，上限为FEATURE_CAP行，避免单条重复消息占主导。
+    """
+    counts = [0] * len(SALIENCE_FEATURES)
+    for line in window_lines:
+        for i, (pattern, _) in enumerate(SALIENCE_FEATURES):
+            if counts[i] < FEATURE_CAP and pattern.search(line):
+                counts[i] += 1
+    return sum(count * weight for count, (_, weight) in zip(counts, SALIENCE_FEATURES))
+
+
+def estimate_window_cost(model: Optional[str], system_prompt: str, window_lines: List[str]) -> float:
+    """Estimated cost in CNY of analyzing one window (分析单个窗口的估算人民币成本)."""
+    prompt_tokens = estimate_tokens(system_prompt) + estimate_lines_tokens(window_lines) + 2 * MESSAGE_OVERHEAD_TOKENS
+    return estimate_cost(model, prompt_tokens, EXPECTED_OUTPUT_TOKENS)
+
+
+def plan_budget(
+    windows: List[Tuple[int, List[str]]],
+    max_calls: Optional[int] = None,
+    max_cost: Optional[float] = None,
+    cost_fn: Optional[Callable[[List[str]], float]] = None
+) -> Tuple[List[Tuple[int, List[str]]], Dict[str, Any]]:
+    """Pick windows in salience order until the budget is spent.
+    按显著性顺序选择窗口，直到预算用完。
+
+    Salience only decides which windows make the cut; they are returned in
+    window order, since transition search and request packing rely on it.
+    显著性只决定哪些窗口入选；返回时按窗口顺序排列，因为转换搜索和请求打包依赖该顺序。
+
+    Args:
+        windows: List of (window_idx, window_lines) (窗口列表)
+        max_calls: Maximum number of windows to analyze (最多分析的窗口数)
+        max_cost: Maximum estimated cost in CNY (最高估算成本，单位元)
+        cost_fn: Estimated cost of one window, required with max_cost
+                单个窗口的估算成本，使用max_cost时必需
+
+    Returns:
+        Tuple of (selected windows in window order, budget summary)
+        (按窗口顺序排列的选中窗口, 预算摘要) 元组
+    """
+    if max_cost is not None and cost_fn is None:
+        raise ValueError("cost_fn is required with max_cost")
+
+    ranked = sorted(windows, key=lambda w: (-salience_score(w[1]), w[0]))
+    selected = []
+    spent = 0.0
+    for window in ranked:
+        if max_calls is not None and len(selected) >= max_calls:
+            break
+        cost = cost_fn(window[1]) if cost_fn else 0.0
+        if max_cost is not None and spent + cost > max_cost:
+            break
+        selected.append(window)
+        spent += cost
+
+    selected.sort(key=lambda w: w[0])
+    return selected, {
+        "max_calls": max_calls,
+        "max_cost": max_cost,
+        "selected_windows": len(selected),
+        "estimated_cost": round(spent, 6)
+    }
+
+
+# Start of the error recorded for windows refused by a SpendMeter (被SpendMeter拒绝的窗口所记录错误的开头)
+BUDGET_EXHAUSTED = "Cost budget exhausted"
+
+
+class BudgetExhausted(RuntimeError):
+    """Raised instead of sending a request once the cost budget is spent.
+    成本预算用完后不再发送请求，而是抛出此异常。
+    """
+
+
+class SpendMeter:
+    """Actual spend of a run, checked before every request.
+    一次运行的实际花费，在每个请求之前检查。
+
+    plan_budget selects windows by estimated cost; the meter enforces the cap
+    against the ``cost_cny`` of the calls that were actually made, including
+    cascade escalations, pack fallbacks and reduction calls. Requests already
+    in flight when the cap is reached still complete.
+    plan_budget按估算成本选择窗口；该计量器按实际调用的 ``cost_cny``（包括级联升级、打包回退和归约调用）执行上限。
+    达到上限时已在进行中的请求仍会完成。
+    """
+
+    def __init__(self, max_cost: float):
+        self.max_cost = max_cost
+        self.spent = 0.0
+        self.calls = 0
+        self.refused = 0
+        self._lock = threading.Lock()
+
+    def charge(self, cost: float):
+        """Add the cost of a completed call (累加已完成调用的成本)."""
+        with self._lock:
+            self.spent += cost
+            self.calls += 1
+
+    def check(self):
+        """Raise BudgetExhausted if the budget is spent (预算用完时抛出BudgetExhausted)."""
+        with self._lock:
+            if self.spent < self.max_cost:
+                return
+            self.refused += 1
+        raise BudgetExhausted(f"{BUDGET_EXHAUSTED} (¥{self.spent:.4f} of ¥{self.max_cost:.4f} spent)")
+
+    def to_dict(self) -> Dict[str, Any]:
+        return {"actual_cost": round(self.spent, 6), "charged_calls": self.calls, "refused_requests": self.refused}
+
+
+def refused_by_budget(result: Dict[str, Any]) -> bool:
+    """Whether a failed window result was refused by a SpendMeter (失败的窗口结果是否被SpendMeter拒绝)."""
+    return str(result.get("error", "")).startswith(BUDGET_EXHAUSTED)
+
+
+def find_gaps(window_indices: List[int], analyzed: List[int]) -> List[Dict[str, int]]:
+    """Contiguous runs of windows that were not analyzed.
+    未被分析的连续窗口区间。
+
+    Args:
+        window_indices: All window indices in order (按顺序排列的全部窗口索引)
+        analyzed: Indices that were analyzed (已分析的索引)
+
+    Returns:
+        List of {start_window, end_window, window_count} (区间列表)
+    """
+    done = set(analyzed)
+    gaps = []
+    current = None
+    for idx in window_indices:
+        if idx in done:
+            current = None
+            continue
+        if current is None:
+            current = {"start_window": idx, "end_window": idx, "window_count": 0}
+            gaps.append(current)
+        current["end_window"] = idx
+        current["window_count"] += 1
+    return gaps
@@ -0,0 +1,284 @@
+"""Token-efficient, reversible serialization of log windows.
+日志窗口的高token效率可逆序列化。
+
+Every logcat line repeats its date, absolute time, pid, tid and full tag, and
+messages repeat 16-digit hex pointers that tokenize badly. The serialized form
+puts a legend first, then one line per original line:
+每行logcat都重复日期、绝对时间、pid、tid和完整标签，消息中还反复出现分词效率很差的16位十六进制指针。
+序列化形式先给出图例，然后每个原始行对应一行：
+
+    # fmt: +ms since 01-06 10:15:23.456; [pid/tid] when changed; L TAG: msg; ~ = verbatim
+    # tags: AF=AudioFlinger AT=AudioTrack
+    # hex: #h1=0xb4000071f3f18800
+    +0 [1234/1235] I AF: AudioFlinger's thread #1 ready to run
+    +1 D AF: createTrack() sessionId: 12345 type: 1
+
+Body lines map 1:1 to the original lines, and every line is checked to decode
+back exactly; lines that would not are sent verbatim after ``~``.
+正文行与原始行一一对应，并且每行都会校验能否精确还原；无法还原的行以 ``~`` 开头原样发送。
+
+Usage (用法):
+    python -m src.serializer --log samples/demo.log
+"""
+
+import argparse
+import re
+import sys
+from datetime import datetime, timedelta
+from typing import Any, Dict, List, Optional, Tuple
+
+from .compact import number_lines
+from .tokens import estimate_lines_tokens
+
+
+_LINE = re.compile(
+    r'^(\d{2}-\d{2}) (\d{2}:\d{2}:\d{2}\.\d{3})\s+(\d+)\s+(\d+) ([VDIWEFA]) (.+?): (.*)$'
+)
+_BODY = re.compile(r'^([+-]\d+) (?:\[(\d+)/(\d+)\] )?([VDIWEFA]) (.+?): (.*)$')
+
+# Hex values with at least this many digits get an alias (至少有这么多位的十六进制值会使用别名)
+MIN_HEX_DIGITS = 8
+_HEX = re.compile(r'0x[0-9a-fA-F]{%d,}' % MIN_HEX_DIGITS)
+_HEX_ALIAS = re.compile(r'#h(\d+)')
+
+VERBATIM_PREFIX = "~ "
+LEGEND_PREFIX = "# "
+
+
+def _parse_time(date: str, clock: str) -> datetime:
+    # Leap year so that 02-29 parses (使用闰年以便解析02-29)
+    return datetime.strptime(f"2000-{date} {clock}", "%Y-%m-%d %H:%M:%S.%f")
+
+
+def _format_time(moment: datetime) -> Tuple[str, str]:
+    return moment.strftime("%m-%d"), moment.strftime("%H:%M:%S.") + f"{moment.microsecond // 1000:03d}"
+
+
+def tag_alias(tag: str) -> str:
+    """Initials of a tag's words, e.g. AudioFlinger -> AF, audio_hw -> AH.
+    标签各单词的首字母，例如 AudioFlinger -> AF，audio_hw -> AH。
+    """
+    words = re.findall(r'[A-Z]+(?![a-z])|[A-Z]?[a-z]+|\d+', tag)
+    return "".join(w[0].upper() if not w.isdigit() else w for w in words)
+
+
+class SerializedWindow:
+    """A serialized window with the tables needed to reverse it.
+    带有还原所需映射表的序列化窗口。
+    """
+
+    def __init__(
+        self,
+        originals: List[str],
+        header: List[str],
+        body: List[str]
+    ):
+        self.originals = originals
+        self.header = header
+        self.body = body
+        self._by_body = {}
+        for i, line in enumerate(body):
+            self._by_body.setdefault(line.strip(), i)
+
+    @property
+    def text(self) -> str:
+        """Legend followed by the body (图例加正文)."""
+        return "\n".join(self.header + self.body)
+
+    def numbered_text(self) -> str:
+        """Legend followed by the body with 1-based line numbers (图例加带行号的正文)."""
+        return "\n".join(self.header + [number_lines(self.body)] if self.body else self.header)
+
+    def resolve(self, evidence: List[Any]) -> List[Any]:
+        """Map evidence copied from the serialized body back to original lines.
+        将从序列化正文复制的证据映射回原始行。
+
+        Items matching a body line exactly, or contained in exactly one body
+        line, are replaced; anything else is kept as given.
+        与正文行完全匹配或只被一个正文行包含的条目会被替换；其他条目保持原样。
+        """
+        resolved = []
+        for item in evidence:
+            if not isinstance(item, str):
+                resolved.append(item)
+                continue
+            text = item.strip()
+            index = self._by_body.get(text)
+            if index is None and text:
+                matches = [i for i, line in enumerate(self.body) if text in line]
+                index = matches[0] if len(matches) == 1 else None
+            resolved.append(self.originals[index] if index is not None else item)
+        return resolved
+
+
+class _Decoder:
+    """Stateful decoder for body lines (正文行的有状态解码器)."""
+
+    def __init__(self, base: Optional[datetime], tags: Dict[str, str], hexes: Dict[str, str]):
+        self.base = base
+        self.tags = tags
+        self.hexes = hexes
+        self.pid_tid: Optional[Tuple[str, str]] = None
+
+    def decode(self, line: str) -> Optional[str]:
+        if line.startswith(VERBATIM_PREFIX):
+            return line[len(VERBATIM_PREFIX):]
+        m = _BODY.match(line)
+        if m is None or self.base is None:
+            return None
+        offset, pid, tid, level, tag, message = m.groups()
+        if pid is not None:
+            self.pid_tid = (pid, tid)
+        if self.pid_tid is None:
+            return None
+        date, clock = _format_time(self.base + timedelta(milliseconds=int(offset)))
+        tag = self.tags.get(tag, tag)
+        message = _HEX_ALIAS.sub(lambda h: self.hexes.get(h.group(1), h.group(0)), message)
+        return f"{date} {clock} {self.pid_tid[0]:>5} {self.pid_tid[1]:>5} {level} {tag}: {message}"
+
+
+def serialize_window(lines: List[str]) -> SerializedWindow:
+    """Serialize window lines (序列化窗口日志行).
+
+    Args:
+        lines: Original log lines (原始日志行)
+
+    Returns:
+        SerializedWindow whose body maps 1:1 to ``lines`` (正文与 ``lines`` 一一对应的SerializedWindow)
+    """
+    parsed = [_LINE.match(line) for line in lines]
+
+    base = None
+    for m in parsed:
+        if m:
+            base = _parse_time(m.group(1), m.group(2))
+            break
+
+    # Tag aliases, only where shorter and unambiguous (仅在更短且无歧义时使用标签别名)
+    tag_counts: Dict[str, int] = {}
+    for m in parsed:
+        if m:
+            tag_counts[m.group(6)] = tag_counts.get(m.group(6), 0) + 1
+    aliases: Dict[str, str] = {}
+    used = set(tag_counts)
+    for tag in sorted(tag_counts, key=lambda t: -tag_counts[t]):
+        alias = tag_alias(tag)
+        candidate, n = alias, 2
+        while candidate in used:
+            candidate, n = f"{alias}{n}", n + 1
+        if candidate and len(candidate) < len(tag):
+            aliases[tag] = candidate
+            used.add(candidate)
+
+    # Hex aliases only pay off for repeated values (十六进制别名仅对重复出现的值有收益)
+    hex_counts: Dict[str, int] = {}
+    for m in parsed:
+        if m:
+            for value in _HEX.findall(m.group(7)):
+                hex_counts[value] = hex_counts.get(value, 0) + 1
+    hexes: Dict[str, str] = {}
+    for value, count in hex_counts.items():
+        if count > 1:
+            hexes[value] = str(len(hexes) + 1)
+
+    header = [f"{LEGEND_PREFIX}fmt: +ms since {' '.join(_format_time(base)) if base else '-'}; "
+              f"[pid/tid] when changed; L TAG: msg; ~ = verbatim"]
+    if aliases:
+        header.append(LEGEND_PREFIX + "tags: " + " ".join(f"{a}={t}" for t, a in aliases.items()))
+    if hexes:
+        header.append(LEGEND_PREFIX + "hex: " + " ".join(f"#h{n}={h}" for h, n in hexes.items()))
+
+    decoder = _Decoder(base, {a: t for t, a in aliases.items()}, {n: h for h, n in hexes.items()})
+    body = []
+    for line, m in zip(lines, parsed):
+        encoded = None
+        if m:
+            date, clock, pid, tid, level, tag, message = m.groups()
+            offset = int((_parse_time(date, clock) - base).total_seconds() * 1000)
+            ids = "" if decoder.pid_tid == (pid, tid) else f"[{pid}/{tid}] "
+            message = _HEX.sub(lambda h: f"#h{hexes[h.group(0)]}" if h.group(0) in hexes else h.group(0), message)
+            encoded = f"{offset:+d} {ids}{level} {aliases.get(tag, tag)}: {message}"
+            saved = decoder.pid_tid
+            if decoder.decode(encoded) != line:
+                decoder.pid_tid = saved
+                encoded = None
+        body.append(encoded if encoded is not None else VERBATIM_PREFIX + line)
+    return SerializedWindow(list(lines), header, body)
+
+
+def deserialize(text: str) -> List[str]:
+    """Rebuild the original lines from a serialized window's text.
+    根据序列化窗口文本重建原始行。
+    """
+    base = None
+    tags: Dict[str, str] = {}
+    hexes: Dict[str, str] = {}
+    lines = []
+    decoder = None
+    for line in text.split("\n"):
+        if decoder is None and line.startswith(LEGEND_PREFIX):
+            key, _, value = line[len(LEGEND_PREFIX):].partition(": ")
+            if key == "fmt":
+                stamp = value.split(";")[0].replace("+ms since ", "")
+                if stamp != "-":
+                    date, clock = stamp.split(" ")
+                    base = _parse_time(date, clock)
+            elif key == "tags":
+                tags = dict(pair.split("=", 1) for pair in value.split(" "))
+            elif key == "hex":
+                hexes = {k[len("#h"):]: v for k, v in (pair.split("=", 1) for pair in value.split(" "))}
+            continue
+        if decoder is None:
+            decoder = _Decoder(base, tags, hexes)
+        decoded = decoder.decode(line)
+        if decoded is None:
+            raise ValueError(f"Cannot decode serialized line: {line}")
+        lines.append(decoded)
+    return lines
+
+
+def measure(windows: List[Tuple[int, List[str]]]) -> Dict[str, Any]:
+    """Estimated tokens of windows before and after serialization.
+    序列化前后窗口的估算token数。
+    """
+    original = sum(estimate_lines_tokens(lines) for _, lines in windows)
+    serialized = sum(estimate_lines_tokens(serialize_window(lines).text.split("\n")) for _, lines in windows)
+    return {
+        "windows": len(windows),
+        "original_tokens": original,
+        "serialized_tokens": serialized,
+        "saving": round(1 - serialized / original, 3) if original else 0.0
+    }
+
+
+def main():
+    """Report token savings of serialization on a log.
+    报告序列化在某个日志上节省的token。
+    """
+    from .chunker import LogChunker
+    from .log_parser import LogParser
+
+    parser = argparse.ArgumentParser(
+        prog="python -m src.serializer",
+        description="Measure token savings of the compact window serialization"
+                    "\n测量紧凑窗口序列化节省的token"
+    )
+    parser.add_argument("--log", required=True, help="Path to input log file (输入日志文件路径)")
+    parser.add_argument("--chunk-size", type=int, default=200, help="Lines per window (每个窗口的行数)")
+    parser.add_argument("--overlap", type=int, default=50, help="Overlapping lines (重叠行数)")
+    parser.add_argument("--show", action="store_true", help="Print the first serialized window (打印第一个序列化窗口)")
+    args = parser.parse_args()
+
+    lines = LogParser().parse_and_filter(args.log)
+    windows = LogChunker(args.chunk_size, args.overlap).chunk_lines(lines)
+    if args.show and windows:
+        print(serialize_window(windows[0][1]).text)
+        print()
+    result = measure(windows)
+    print(f"{result['windows']} windows: {result['original_tokens']} -> {result['serialized_tokens']} "
+          f"estimated tokens ({result['saving']:.1%} saved)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
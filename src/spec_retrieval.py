@@ -0,0 +1,235 @@
+"""Per-window retrieval of specification sections (BM25).
+按窗口检索规范文档章节（BM25）。
+
+A long log specification is split into sections and indexed once per run. For
+each window, the tags, function names and message keys that appear in it are
+the query, and only the best-scoring sections that fit the token cap are
+added to the system prompt.
+较长的日志规范被拆分为章节，每次运行只建立一次索引。对每个窗口，以其中出现的标签、函数名和消息键作为查询，
+只把得分最高且不超过token上限的章节加入系统提示词。
+
+Usage (用法):
+    python -m src.spec_retrieval --spec samples/audio_spec.md --log samples/demo.log
+"""
+
+import argparse
+import math
+import re
+import sys
+from typing import Dict, List, Optional, Tuple
+
+from .tokens import estimate_tokens
+
+
+# Default cap on specification tokens per request (每个请求的规范token默认上限)
+DEFAULT_MAX_TOKENS = 1500
+# Sections longer than this are split at paragraph breaks (超过此长度的章节会按段落拆分)
+MAX_SECTION_TOKENS = 400
+
+SPEC_HEADING = "## 日志规范文档 Log Specification Document"
+
+_HEADING = re.compile(r'^#{1,6}\s+.+$', re.MULTILINE)
+_WORD = re.compile(r'[A-Za-z_][A-Za-z0-9_]*')
+_CAMEL = re.compile(r'[A-Z]+(?![a-z])|[A-Z]?[a-z]+|\d+')
+_LOGCAT = re.compile(r'^\d{2}-\d{2}\s+\d{2}:\d{2}:\d{2}\.\d{3}\s+\d+\s+\d+\s+[VDIWEFA]\s+(.+?):\s(.*)$')
+
+# Words too common in specs and logs to say anything about a section (在规范和日志中过于常见、无区分度的词)
+STOPWORDS = frozenset(
+    "the and for with that this from are was were not but has have had its into when then than "
+    "will can may all any each one two per via log logs line lines value values field fields".split()
+)
+
+
+def terms(text: str) -> List[str]:
+    """Lowercase index terms of a text: whole identifiers plus their camelCase parts.
+    文本的小写索引词：完整标识符及其驼峰拆分部分。
+    """
+    result = []
+    for word in _WORD.findall(text):
+        lower = word.lower()
+        if len(lower) > 2 and lower not in STOPWORDS:
+            result.append(lower)
+        parts = _CAMEL.findall(word.replace("_", " "))
+        if len(parts) > 1:
+            result.extend(p.lower() for p in parts if len(p) > 2 and p.lower() not in STOPWORDS)
+    return result
+
+
+def window_query(window_lines: List[str]) -> List[str]:
+    """Distinct query terms of a window: tags and identifiers in messages.
+    窗口的去重查询词：标签和消息中的标识符。
+    """
+    seen: Dict[str, None] = {}
+    for line in window_lines:
+        m = _LOGCAT.match(line)
+        for term in terms(f"{m.group(1)} {m.group(2)}" if m else line):
+            seen.setdefault(term, None)
+    return list(seen)
+
+
+def split_sections(text: str, max_section_tokens: int = MAX_SECTION_TOKENS) -> List[str]:
+    """Split a specification into sections at headings, then at paragraphs.
+    按标题、再按段落把规范拆分为章节。
+
+    A section split at paragraphs repeats its heading in every part so each
+    part still says what it documents. A single paragraph over the limit is
+    kept whole.
+    按段落拆分的章节在每个部分都重复其标题，使每部分仍能说明其描述对象。超过上限的单个段落保持完整。
+    """
+    starts = sorted({0} | {m.start() for m in _HEADING.finditer(text)})
+    sections = []
+    for begin, end in zip(starts, starts[1:] + [len(text)]):
+        section = text[begin:end].strip()
+        if not section:
+            continue
+        if estimate_tokens(section) <= max_section_tokens:
+            sections.append(section)
+            continue
+        heading, _, rest = section.partition("\n")
+        if not _HEADING.match(heading):
+            heading, rest = "", section
+        part: List[str] = []
+        for paragraph in re.split(r'\n\s*\n', rest):
+            candidate = "\n".join(filter(None, [heading, "\n\n".join(part + [paragraph])]))
+            if part and estimate_tokens(candidate) > max_section_tokens:
+                sections.append("\n".join(filter(None, [heading, "\n\n".join(part).strip()])))
+                part = []
+            part.append(paragraph)
+        if part:
+            sections.append("\n".join(filter(None, [heading, "\n\n".join(part).strip()])))
+    return sections
+
+
+class SpecIndex:
+    """BM25 index over the sections of a specification document.
+    规范文档章节的BM25索引。
+    """
+
+    def __init__(
+        self,
+        text: str,
+        max_tokens: int = DEFAULT_MAX_TOKENS,
+        k1: float = 1.5,
+        b: float = 0.75
+    ):
+        """Split and index a specification.
+        拆分规范并建立索引。
+
+        Args:
+            text: Specification document (规范文档)
+            max_tokens: Cap on specification tokens added per request (每个请求加入的规范token上限)
+            k1: BM25 term frequency saturation (BM25词频饱和参数)
+            b: BM25 length normalization (BM25长度归一化参数)
+        """
+        self.sections = split_sections(text)
+        self.max_tokens = max_tokens
+        self.k1 = k1
+        self.b = b
+        self.section_tokens = [estimate_tokens(s) for s in self.sections]
+        self.total_tokens = estimate_tokens(text)
+
+        self._tf: List[Dict[str, int]] = []
+        self._lengths: List[int] = []
+        df: Dict[str, int] = {}
+        for section in self.sections:
+            counts: Dict[str, int] = {}
+            for term in terms(section):
+                counts[term] = counts.get(term, 0) + 1
+            self._tf.append(counts)
+            self._lengths.append(sum(counts.values()))
+            for term in counts:
+                df[term] = df.get(term, 0) + 1
+        n = len(self.sections)
+        self._avg_length = (sum(self._lengths) / n) if n else 0.0
+        self._idf = {t: math.log(1 + (n - f + 0.5) / (f + 0.5)) for t, f in df.items()}
+
+    def score(self, query: List[str]) -> List[float]:
+        """BM25 score of every section for a query (每个章节对查询的BM25得分)."""
+        scores = []
+        for counts, length in zip(self._tf, self._lengths):
+            total = 0.0
+            norm = self.k1 * (1 - self.b + self.b * length / self._avg_length) if self._avg_length else self.k1
+            for term in query:
+                tf = counts.get(term)
+                if tf:
+                    total += self._idf[term] * tf * (self.k1 + 1) / (tf + norm)
+            scores.append(total)
+        return scores
+
+    def select(self, window_lines: List[str]) -> List[int]:
+        """Indices of the sections to send with a window, in document order.
+        随窗口发送的章节索引，按文档顺序排列。
+
+        Sections are taken by descending score while they fit the token cap;
+        sections that match nothing are never sent.
+        按得分从高到低选取章节，直到达到token上限；不匹配任何词的章节不会发送。
+        """
+        scores = self.score(window_query(window_lines))
+        chosen = []
+        budget = self.max_tokens
+        for index in sorted(range(len(scores)), key=lambda i: -scores[i]):
+            if scores[index] <= 0:
+                break
+            if self.section_tokens[index] <= budget:
+                chosen.append(index)
+                budget -= self.section_tokens[index]
+        return sorted(chosen)
+
+    def prompt_for(self, system_prompt: str, window_lines: List[str]) -> str:
+        """System prompt with the sections relevant to a window appended.
+        附加了与窗口相关章节的系统提示词。
+        """
+        chosen = self.select(window_lines)
+        if not chosen:
+            return system_prompt
+        body = "\n\n".join(self.sections[i] for i in chosen)
+        return f"{system_prompt}\n\n{SPEC_HEADING}\n\n{body}"
+
+
+def measure(index: SpecIndex, windows: List[Tuple[int, List[str]]]) -> Dict[str, float]:
+    """Specification tokens per request with and without retrieval.
+    使用与不使用检索时每个请求的规范token数。
+    """
+    retrieved = [sum(index.section_tokens[i] for i in index.select(lines)) for _, lines in windows]
+    full = index.total_tokens * len(windows)
+    return {
+        "windows": len(windows),
+        "sections": len(index.sections),
+        "full_tokens": full,
+        "retrieved_tokens": sum(retrieved),
+        "max_request_tokens": max(retrieved, default=0),
+        "reduction": round(1 - sum(retrieved) / full, 3) if full else 0.0
+    }
+
+
+def main(argv: Optional[List[str]] = None):
+    """Report the specification token reduction for a log.
+    报告某个日志的规范token缩减量。
+    """
+    from .chunker import LogChunker
+    from .log_parser import LogParser
+
+    parser = argparse.ArgumentParser(
+        prog="python -m src.spec_retrieval",
+        description="Measure per-window specification retrieval\n测量按窗口的规范检索效果"
+    )
+    parser.add_argument("--spec", required=True, help="Specification document (规范文档)")
+    parser.add_argument("--log", required=True, help="Path to input log file (输入日志文件路径)")
+    parser.add_argument("--chunk-size", type=int, default=200, help="Lines per window (每个窗口的行数)")
+    parser.add_argument("--overlap", type=int, default=50, help="Overlapping lines (重叠行数)")
+    parser.add_argument("--max-tokens", type=int, default=DEFAULT_MAX_TOKENS,
+                        help="Specification tokens per request (每个请求的规范token数)")
+    args = parser.parse_args(argv)
+
+    with open(args.spec, 'r', encoding='utf-8') as f:
+        index = SpecIndex(f.read(), max_tokens=args.max_tokens)
+    windows = LogChunker(args.chunk_size, args.overlap).chunk_lines(LogParser().parse_and_filter(args.log))
+    result = measure(index, windows)
+    print(f"{result['sections']} sections, {result['windows']} windows: "
+          f"{result['full_tokens']} -> {result['retrieved_tokens']} spec tokens "
+          f"({result['reduction']:.1%} less, at most {result['max_request_tokens']} per request)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
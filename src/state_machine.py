@@ -0,0 +1,294 @@
+"""Deterministic line-rate audio state machine.
+确定性的逐行音频状态机。
+
+Tracks per-output and per-session state from AudioFlinger/AudioTrack/
+AudioPolicyService events and produces an exact state timeline at line
+granularity. It needs no LLM calls, so it doubles as a zero-cost baseline and as
+a cross-check for LLM window results.
+根据AudioFlinger/AudioTrack/AudioPolicyService事件跟踪每个输出和每个会话的状态，生成行粒度的精确状态时间线。
+无需调用大模型，既可作为零成本基线，也可用于交叉校验大模型的窗口结果。
+
+Usage (用法):
+    python -m src.state_machine --log samples/demo.log --out output/timeline.json
+"""
+
+import argparse
+import bisect
+import json
+import re
+import sys
+import time
+from typing import Any, Dict, List, Optional, Set, Tuple
+
+
+# Key for events that name no output or session (未指明输出或会话的事件所用的键)
+DEFAULT_KEY = "-"
+
+# Event rules: (kind, trigger substrings, pattern), applied to the lowercased
+# line in this order. A rule's regex only runs when one of its triggers occurs
+# in the line, so most lines cost a few substring checks. A line may carry
+# several events, e.g. "stream MUSIC unmuted, volume=1.0" yields unmute and volume.
+# 事件规则：(类型, 触发子串, 模式)，按顺序作用于小写化后的行。仅当行中出现某个触发子串时才运行该规则的正则，
+# 因此大多数行只需几次子串检查。一行可能包含多个事件，例如 "stream MUSIC unmuted, volume=1.0" 产生unmute和volume。
+EVENT_RULES = [
+    ("start", ("track", "state_", "playback resumed"),
+     r'\btrack (?:started|playing)\b|\baudiotrack started\b|\bstate_(?:playing|started)\b|\bplayback resumed\b'),
+    ("pause", ("pause",),
+     r'\btrack paused\b|\bpause\(\) called\b|\bstate_paused\b|\bstate (?:changed )?to paused\b'),
+    ("stop", ("stop",),
+     r'\btrack stopped\b|\bstate (?:changed )?to stopped\b|\bstate_stopped\b'),
+    ("idle", ("no active tracks", "standby"),
+     r'\bno active tracks\b|\bstandby\b'),
+    ("unmute", ("unmute", "muted=false", "mute=0", "removing mute"),
+     r'\bunmuted\b|\bmuted=false\b|\bmute=0\b|\bremoving mute\b'),
+    ("mute", ("mute",),
+     r'\bmuted=true\b|\bmute=1\b|\bstream \w+ muted\b|\bapplying mute\b'),
+    ("volume", ("volume", "level="),
+     r'\bvolume[=:]\s*(?P<volume>\d+(?:\.\d+)?)\b|\blevel=(?P<level>\d+)\b'),
+    ("route", ("output device", "routing="),
+     r'\boutput device:?\s*(?P<device>\w+)|\brouting=(?P<routing>\w+)'),
+    ("disconnect", ("disconnected",),
+     r'\bdevice disconnected\b'),
+]
+
+_RULES = [(kind, triggers, re.compile(pattern)) for kind, triggers, pattern in EVENT_RULES]
+_SESSION = re.compile(r'\bsession(?:id)?[:=]?\s*(\d+)')
+_OUTPUT = re.compile(r'\boutput\s+(\d+)\b')
+_TIMESTAMP = re.compile(r'^(\d{2}-\d{2}\s+\d{2}:\d{2}:\d{2}\.\d{3})')
+
+
+def line_timestamp(line: str) -> Optional[str]:
+    """Logcat timestamp at the start of a line, e.g. "01-06 10:15:23.456" (行首的logcat时间戳)."""
+    timestamp = _TIMESTAMP.match(line)
+    return timestamp.group(1) if timestamp else None
+
+
+class OutputState:
+    """State of one audio output (mixer thread).
+    单个音频输出（混音线程）的状态。
+    """
+
+    def __init__(self, output_id: str):
+        self.output_id = output_id
+        self.active_sessions: Set[str] = set()
+        self.muted = False
+        self.volume: Optional[float] = None
+        self.device: Optional[str] = None
+
+    def to_dict(self) -> Dict[str, Any]:
+        return {
+            "output_id": self.output_id,
+            "active_sessions": sorted(self.active_sessions),
+            "muted": self.muted,
+            "volume": self.volume,
+            "device": self.device
+        }
+
+
+class AudioStateMachine:
+    """Finite-state engine fed one filtered log line at a time.
+    每次输入一行过滤后日志的有限状态引擎。
+
+    The overall state is PLAYING when some output has an active session and is
+    neither muted nor at volume 0, MUTED once any stop/pause/mute/idle evidence
+    (or volume 0) has been seen otherwise, and UNKNOWN until then.
+    当某个输出有活动会话且未静音、音量不为0时整体状态为PLAYING；否则一旦出现停止/暂停/静音/空闲证据（或音量为0）即为MUTED；在此之前为UNKNOWN。
+    """
+
+    def __init__(self):
+        self.outputs: Dict[str, OutputState] = {}
+        self.sessions: Dict[str, str] = {}
+        self.session_outputs: Dict[str, str] = {}
+        self.current_output = DEFAULT_KEY
+        self.state = "UNKNOWN"
+        # Whether any stop/pause/mute/idle evidence has been seen (是否出现过停止/暂停/静音/空闲证据)
+        self.silence_seen = False
+        self.lines_seen = 0
+        self.events_seen = 0
+        self.timeline: List[Dict[str, Any]] = []
+        self._starts: List[int] = []
+
+    def _output(self, output_id: str) -> OutputState:
+        output = self.outputs.get(output_id)
+        if output is None:
+            output = self.outputs[output_id] = OutputState(output_id)
+        return output
+
+    def _end_sessions(self, output: OutputState, session: Optional[str], status: str):
+        """Stop/pause one session, or every session on the output if none is named.
+        停止/暂停一个会话；未指明会话时停止该输出上的所有会话。
+        """
+        if session is None:
+            ended = set(output.active_sessions)
+        else:
+            # Unattributed activity belongs to the session that ends (未归属的活动属于结束的会话)
+            ended = {session, DEFAULT_KEY}
+        for sid in ended:
+            output.active_sessions.discard(sid)
+            if sid != DEFAULT_KEY:
+                self.sessions[sid] = status
+
+    def feed(self, line: str) -> str:
+        """Apply one line and return the overall state after it.
+        应用一行日志并返回其后的整体状态。
+        """
+        line_no = self.lines_seen
+        self.lines_seen += 1
+        low = line.lower()
+        matched = []
+        for kind, triggers, pattern in _RULES:
+            for trigger in triggers:
+                if trigger in low:
+                    m = pattern.search(low)
+                    if m:
+                        matched.append((kind, m))
+                    break
+        if not matched:
+            return self.state
+        self.events_seen += 1
+
+        session_match = _SESSION.search(low)
+        session = session_match.group(1) if session_match else None
+        output_match = _OUTPUT.search(low)
+        if output_match:
+            self.current_output = output_match.group(1)
+        elif session and session in self.session_outputs:
+            self.current_output = self.session_outputs[session]
+        output = self._output(self.current_output)
+
+        for kind, m in matched:
+            if kind == "start":
+                sid = session or DEFAULT_KEY
+                output.active_sessions.add(sid)
+                self.session_outputs.setdefault(sid, output.output_id)
+                if session:
+                    self.sessions[session] = "STARTED"
+            elif kind == "pause":
+                self._end_sessions(output, session, "PAUSED")
+            elif kind == "stop":
+                self._end_sessions(output, session, "STOPPED")
+            elif kind == "idle":
+                self._end_sessions(output, None, "STOPPED")
+            elif kind == "mute":
+                output.muted = True
+            elif kind == "unmute":
+                output.muted = False
+            elif kind == "volume":
+                output.volume = float(m.group("volume") or m.group("level"))
+                if output.volume == 0:
+                    self.silence_seen = True
+            elif kind == "route":
+                output.device = (m.group("device") or m.group("routing")).upper()
+            elif kind == "disconnect":
+                output.device = None
+                self._end_sessions(output, None, "STOPPED")
+            if kind in ("pause", "stop", "idle", "mute", "disconnect"):
+                self.silence_seen = True
+
+        self._update(line_no, line)
+        return self.state
+
+    def _update(self, line_no: int, line: str):
+        """Recompute the overall state and extend the timeline.
+        重新计算整体状态并扩展时间线。
+        """
+        if any(o.active_sessions and not o.muted and o.volume != 0 for o in self.outputs.values()):
+            state = "PLAYING"
+        elif self.silence_seen:
+            state = "MUTED"
+        else:
+            # Only route/volume/unmute events so far: nothing says audio is silent
+            # 目前只有路由/音量/取消静音事件：没有证据表明音频无声
+            state = "UNKNOWN"
+        if state == self.state:
+            return
+        self.state = state
+
+        entry = {
+            "state": state,
+            "start_line": line_no,
+            "start_time": line_timestamp(line),
+            "trigger": line
+        }
+        self.timeline.append(entry)
+        self._starts.append(line_no)
+
+    def run(self, lines: List[str]) -> List[Dict[str, Any]]:
+        """Feed all lines and return the finished timeline.
+        输入全部行并返回完成的时间线。
+        """
+        for line in lines:
+            self.feed(line)
+        return self.finish()
+
+    def finish(self) -> List[Dict[str, Any]]:
+        """Close the timeline: fill in each segment's end line (inclusive).
+        结束时间线：填写每个片段的结束行（包含）。
+        """
+        for i, entry in enumerate(self.timeline):
+            end = self._starts[i + 1] - 1 if i + 1 < len(self._starts) else self.lines_seen - 1
+            entry["end_line"] = end
+        return self.timeline
+
+    def state_at(self, line_no: int) -> str:
+        """Overall state after the given 0-based line (O(log n)).
+        给定行（从0开始）之后的整体状态（O(log n)）。
+        """
+        i = bisect.bisect_right(self._starts, line_no) - 1
+        return self.timeline[i]["state"] if i >= 0 else "UNKNOWN"
+
+    def window_states(self, spans: List[Tuple[int, int, int]]) -> Dict[int, str]:
+        """Engine state at the last line of each window.
+        每个窗口最后一行处的引擎状态。
+
+        Args:
+            spans: List of (window_idx, start_line, end_line_exclusive)
+                  (窗口索引, 起始行, 结束行（不包含）) 列表
+        """
+        return {idx: self.state_at(end - 1) for idx, start, end in spans}
+
+    def snapshot(self) -> Dict[str, Any]:
+        """Per-output and per-session state at the current line.
+        当前行处每个输出和每个会话的状态。
+        """
+        return {
+            "state": self.state,
+            "outputs": [o.to_dict() for o in self.outputs.values()],
+            "sessions": dict(self.sessions)
+        }
+
+
+def main():
+    """Build a baseline timeline for a log without any LLM calls.
+    无需调用大模型即可为日志构建基线时间线。
+    """
+    from .log_parser import LogParser
+
+    parser = argparse.ArgumentParser(
+        prog="python -m src.state_machine",
+        description="Rule-driven audio state timeline (no LLM calls)"
+                    "\n基于规则的音频状态时间线（不调用大模型）"
+    )
+    parser.add_argument("--log", required=True, help="Path to input log file (输入日志文件路径)")
+    parser.add_argument("--out", default=None, help="Write the timeline as JSON to this path (将时间线以JSON写入此路径)")
+    args = parser.parse_args()
+
+    lines = LogParser().parse_and_filter(args.log)
+    engine = AudioStateMachine()
+    started = time.perf_counter()
+    timeline = engine.run(lines)
+    elapsed = time.perf_counter() - started
+
+    for entry in timeline:
+        print(f"{entry['start_line']:>8}-{entry['end_line']:<8} {entry['start_time'] or '-':<20} {entry['state']}")
+    rate = len(lines) / elapsed if elapsed > 0 else 0.0
+    print(f"{len(lines)} lines, {engine.events_seen} events, {len(timeline)} segments, {rate:,.0f} lines/s")
+
+    if args.out:
+        with open(args.out, 'w', encoding='utf-8') as f:
+            json.dump({"timeline": timeline, "final": engine.snapshot()}, f, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,118 @@
+"""Incremental JSON parsing for streamed LLM responses.
+流式大模型响应的增量JSON解析。
+"""
+
+import json
+from typing import Any, Dict, List, Tuple
+
+
+class IncrementalJSONParser:
+    """Emits top-level fields of a JSON object as soon as each value is complete.
+    在每个值完整后立即输出JSON对象的顶层字段。
+
+    Text is fed in arbitrary chunks. Scalars are emitted when their terminating
+    ``,`` or ``}`` arrives, strings at their closing quote, and arrays/objects
+    when their closing bracket arrives.
+    文本可按任意分块输入。标量在遇到结尾的 ``,`` 或 ``}`` 时输出，
+    字符串在闭合引号处输出，数组/对象在闭合括号处输出。
+    """
+
+    def __init__(self):
+        """Initialize an empty parser (初始化空解析器)."""
+        self.text = ""
+        self.fields: Dict[str, Any] = {}
+        self.complete = False
+        self._pos = 0
+        self._depth = 0
+        self._in_string = False
+        self._escape = False
+        # Top-level state: key, colon, value, string, scalar, nested, after
+        # 顶层状态：key, colon, value, string, scalar, nested, after
+        self._state = "key"
+        self._key = None
+        self._start = 0
+
+    def feed(self, chunk: str) -> List[Tuple[str, Any]]:
+        """Consume a chunk of text and return newly completed fields.
+        处理一段文本并返回新完成的字段。
+
+        Args:
+            chunk: Next piece of the response text (响应文本的下一段)
+
+        Returns:
+            List of (key, value) pairs completed by this chunk (本段完成的 (键, 值) 列表)
+        """
+        self.text += chunk
+        emitted: List[Tuple[str, Any]] = []
+        text = self.text
+
+        for i in range(self._pos, len(text)):
+            c = text[i]
+
+            if self._in_string:
+                if self._escape:
+                    self._escape = False
+                elif c == "\\":
+                    self._escape = True
+                elif c == '"':
+                    self._in_string = False
+                    if self._depth == 1 and self._state == "key":
+                        self._key = self._decode(self._start, i + 1)
+                        self._state = "colon"
+                    elif self._depth == 1 and self._state == "string":
+                        self._emit(emitted, self._start, i + 1)
+                continue
+
+            if c == '"':
+                self._in_string = True
+                if self._depth == 1 and self._state in ("key", "value"):
+                    self._start = i
+                    if self._state == "value":
+                        self._state = "string"
+            elif c in "{[":
+                if self._depth == 1 and self._state == "value":
+                    self._start = i
+                    self._state = "nested"
+                self._depth += 1
+            elif c in "}]":
+                if self._depth == 1 and self._state == "scalar":
+                    self._emit(emitted, self._start, i)
+                self._depth -= 1
+                if self._depth == 1 and self._state == "nested":
+                    self._emit(emitted, self._start, i + 1)
+                elif self._depth == 0:
+                    self.complete = True
+            elif self._depth == 1:
+                if c == ":" and self._state == "colon":
+                    self._state = "value"
+                elif c == ",":
+                    if self._state == "scalar":
+                        self._emit(emitted, self._start, i)
+                    self._state = "key"
+                elif not c.isspace() and self._state == "value":
+                    self._start = i
+                    self._state = "scalar"
+
+        self._pos = len(text)
+        return emitted
+
+    def _decode(self, start: int, end: int) -> Any:
+        """Decode a JSON fragment, returning None if it is invalid.
+        解码JSON片段，无效时返回None。
+        """
+        try:
+            return json.loads(self.text[start:end])
+        except json.JSONDecodeError:
+            return None
+
+    def _emit(self, emitted: List[Tuple[str, Any]], start: int, end: int):
+        """Record a completed top-level value (记录已完成的顶层值)."""
+        self._state = "after"
+        if self._key is None:
+            return
+        try:
+            value = json.loads(self.text[start:end].strip())
+        except json.JSONDecodeError:
+            return
+        self.fields[self._key] = value
+        emitted.append((self._key, value))
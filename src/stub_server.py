@@ -0,0 +1,399 @@
+"""Local OpenAI-compatible stand-in server for offline testing.
+用于离线测试的本地OpenAI兼容替身服务器。
+
+Implements the subset of the DashScope compatible-mode API used by this tool:
+实现本工具使用的DashScope兼容模式API子集：
+
+- POST /v1/chat/completions (including ``stream: true`` server-sent events)
+- POST /v1/files, GET /v1/files/{id}/content
+- POST /v1/batches, GET /v1/batches/{id}
+"""
+
+import argparse
+import email
+import email.policy
+import json
+import sys
+import threading
+import uuid
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+
+# Result returned by the default responder (默认响应器返回的结果)
+DEFAULT_RESULT = {
+    "final_state": "UNKNOWN",
+    "confidence": 0.5,
+    "reason": "Stub server response",
+    "evidence": [],
+    "next_actions": []
+}
+
+
+def default_responder(payload: Dict[str, Any]) -> Dict[str, Any]:
+    """Return a fixed analysis result for any request.
+    对任何请求返回固定的分析结果。
+    """
+    return dict(DEFAULT_RESULT)
+
+
+def make_chat_completion(content: str, model: str = "stub") -> Dict[str, Any]:
+    """Wrap message content in a chat completion response body.
+    将消息内容包装为聊天补全响应体。
+
+    Args:
+        content: Assistant message content (助手消息内容)
+        model: Model name to report (报告的模型名称)
+
+    Returns:
+        Chat completion response dict (聊天补全响应字典)
+    """
+    return {
+        "id": f"chatcmpl-{uuid.uuid4().hex[:12]}",
+        "object": "chat.completion",
+        "model": model,
+        "choices": [
+            {
+                "index": 0,
+                "message": {"role": "assistant", "content": content},
+                "finish_reason": "stop"
+            }
+        ]
+    }
+
+
+class _Server(ThreadingHTTPServer):
+    """Threading server with a listen backlog sized for load tests.
+    监听队列按负载测试需求设置的多线程服务器。
+    """
+
+    daemon_threads = True
+    request_queue_size = 512
+
+
+class EventStream:
+    """Server-sent event body: each event is sent as a ``data:`` line.
+    服务器推送事件响应体：每个事件作为一行 ``data:`` 发送。
+    """
+
+    def __init__(self, events: List[Any]):
+        self.events = events
+
+
+def make_stream_events(content: str, model: str = "stub", chunk_chars: int = 8) -> List[Any]:
+    """Split message content into chat completion chunk events.
+    将消息内容拆分为聊天补全分块事件。
+
+    Args:
+        content: Assistant message content (助手消息内容)
+        model: Model name to report (报告的模型名称)
+        chunk_chars: Characters per delta (每个增量的字符数)
+
+    Returns:
+        List of chunk dicts followed by the ``[DONE]`` marker (分块字典列表，末尾为 ``[DONE]`` 标记)
+    """
+    stream_id = f"chatcmpl-{uuid.uuid4().hex[:12]}"
+    events: List[Any] = []
+    for i in range(0, len(content), chunk_chars):
+        events.append({
+            "id": stream_id,
+            "object": "chat.completion.chunk",
+            "model": model,
+            "choices": [{"index": 0, "delta": {"content": content[i:i + chunk_chars]}, "finish_reason": None}]
+        })
+    events.append({
+        "id": stream_id,
+        "object": "chat.completion.chunk",
+        "model": model,
+        "choices": [{"index": 0, "delta": {}, "finish_reason": "stop"}]
+    })
+    events.append("[DONE]")
+    return events
+
+
+class StubServer:
+    """In-process HTTP server speaking the chat completion and batch protocols.
+    进程内HTTP服务器，支持聊天补全和批处理协议。
+
+    The responder maps a chat completion request payload to a result dict
+    (serialized as the message content), a raw string used verbatim as content,
+    or a complete response body (a dict with ``choices``). Responder exceptions
+    are answered with HTTP 500.
+    响应器将聊天补全请求负载映射为结果字典（序列化为消息内容）、直接用作内容的原始字符串，
+    或完整响应体（含 ``choices`` 的字典）。响应器抛出异常时返回HTTP 500。
+    """
+
+    def __init__(
+        self,
+        responder: Optional[Callable[[Dict[str, Any]], Any]] = None,
+        host: str = "127.0.0.1",
+        port: int = 0,
+        batch_polls_until_complete: int = 1
+    ):
+        """Initialize the stub server.
+        初始化替身服务器。
+
+        Args:
+            responder: Function producing a result for each request payload
+                      为每个请求负载生成结果的函数
+            host: Bind address (绑定地址)
+            port: Bind port, 0 picks a free port (绑定端口，0表示自动选择空闲端口)
+            batch_polls_until_complete: Number of status polls a batch stays in_progress
+                                       批处理保持in_progress状态的轮询次数
+        """
+        self.responder = responder or default_responder
+        self.batch_polls_until_complete = batch_polls_until_complete
+        self.files: Dict[str, bytes] = {}
+        self.batches: Dict[str, Dict[str, Any]] = {}
+        self.request_count = 0
+        self._lock = threading.Lock()
+        self._httpd = _Server((host, port), self._make_handler())
+        self._thread: Optional[threading.Thread] = None
+
+    @property
+    def base_url(self) -> str:
+        """Base URL to pass to BailianClient (传给BailianClient的基础URL)."""
+        host, port = self._httpd.server_address[:2]
+        return f"http://{host}:{port}/v1"
+
+    def start(self) -> "StubServer":
+        """Start serving in a background thread (在后台线程中开始服务)."""
+        self._thread = threading.Thread(
+            target=self._httpd.serve_forever,
+            kwargs={"poll_interval": 0.05},
+            daemon=True
+        )
+        self._thread.start()
+        return self
+
+    def stop(self):
+        """Stop the server and release the socket (停止服务器并释放套接字)."""
+        self._httpd.shutdown()
+        self._httpd.server_close()
+        if self._thread is not None:
+            self._thread.join()
+
+    def __enter__(self) -> "StubServer":
+        return self.start()
+
+    def __exit__(self, exc_type, exc, tb):
+        self.stop()
+
+    def complete(self, payload: Dict[str, Any]) -> Dict[str, Any]:
+        """Produce a chat completion response body for a request payload.
+        为请求负载生成聊天补全响应体。
+        """
+        with self._lock:
+            self.request_count += 1
+        answer = self.responder(payload)
+        if isinstance(answer, dict) and "choices" in answer:
+            # Responder supplied a complete response body (响应器提供了完整响应体)
+            return answer
+        content = answer if isinstance(answer, str) else json.dumps(answer, ensure_ascii=False)
+        return make_chat_completion(content, payload.get("model", "stub"))
+
+    def handle(self, method: str, path: str, headers, body: bytes) -> Tuple[int, Any]:
+        """Route a request and return (status, body).
+        路由请求并返回 (状态码, 响应体)。
+
+        A dict/list body is sent as JSON, bytes are sent verbatim, and objects
+        with a ``write_to(handler)`` method write the raw response themselves.
+        字典/列表响应体以JSON发送，字节串原样发送，带 ``write_to(handler)`` 方法的对象自行写出原始响应。
+        """
+        if path.startswith("/v1"):
+            path = path[len("/v1"):]
+        parts = [p for p in path.split("/") if p]
+
+        if method == "POST" and parts == ["chat", "completions"]:
+            payload = json.loads(body or b"{}")
+            completion = self.complete(payload)
+            if payload.get("stream"):
+                content = completion["choices"][0]["message"]["content"]
+                return 200, EventStream(make_stream_events(content, completion["model"]))
+            return 200, completion
+        if method == "POST" and parts == ["files"]:
+            return self._upload_file(headers, body)
+        if method == "GET" and len(parts) == 3 and parts[0] == "files" and parts[2] == "content":
+            if parts[1] not in self.files:
+                return 404, {"error": {"message": f"File {parts[1]} not found"}}
+            return 200, self.files[parts[1]]
+        if method == "POST" and parts == ["batches"]:
+            return self._create_batch(json.loads(body or b"{}"))
+        if method == "GET" and len(parts) == 2 and parts[0] == "batches":
+            return self._get_batch(parts[1])
+        return 404, {"error": {"message": f"Unknown route {method} {path}"}}
+
+    def _upload_file(self, headers, body: bytes) -> Tuple[int, Any]:
+        """Store an uploaded multipart file (保存上传的multipart文件)."""
+        raw = b"Content-Type: " + headers.get("Content-Type", "").encode() + b"\r\n\r\n" + body
+        message = email.message_from_bytes(raw, policy=email.policy.HTTP)
+        content = None
+        for part in message.iter_parts():
+            if part.get_param("name", header="content-disposition") == "file":
+                content = part.get_payload(decode=True)
+        if content is None:
+            return 400, {"error": {"message": "Missing file field"}}
+
+        file_id = f"file-{uuid.uuid4().hex[:12]}"
+        self.files[file_id] = content
+        return 200, {"id": file_id, "object": "file", "bytes": len(content), "purpose": "batch"}
+
+    def _create_batch(self, request: Dict[str, Any]) -> Tuple[int, Any]:
+        """Create a batch job over an uploaded file (基于已上传文件创建批处理任务)."""
+        input_file_id = request.get("input_file_id")
+        if input_file_id not in self.files:
+            return 404, {"error": {"message": f"File {input_file_id} not found"}}
+
+        batch_id = f"batch-{uuid.uuid4().hex[:12]}"
+        self.batches[batch_id] = {
+            "id": batch_id,
+            "object": "batch",
+            "endpoint": request.get("endpoint"),
+            "input_file_id": input_file_id,
+            "status": "in_progress",
+            "output_file_id": None,
+            "error_file_id": None,
+            "polls": 0
+        }
+        return 200, self._batch_view(batch_id)
+
+    def _get_batch(self, batch_id: str) -> Tuple[int, Any]:
+        """Return batch status, completing it after the configured number of polls.
+        返回批处理状态，在配置的轮询次数后完成任务。
+        """
+        batch = self.batches.get(batch_id)
+        if batch is None:
+            return 404, {"error": {"message": f"Batch {batch_id} not found"}}
+
+        batch["polls"] += 1
+        if batch["status"] == "in_progress" and batch["polls"] >= self.batch_polls_until_complete:
+            self._run_batch(batch)
+        return 200, self._batch_view(batch_id)
+
+    def _run_batch(self, batch: Dict[str, Any]):
+        """Execute every request of a batch and store the output file.
+        执行批处理中的每个请求并保存输出文件。
+        """
+        output_lines: List[str] = []
+        for raw_line in self.files[batch["input_file_id"]].decode("utf-8").splitlines():
+            if not raw_line.strip():
+                continue
+            item = json.loads(raw_line)
+            output_lines.append(json.dumps({
+                "id": f"resp-{uuid.uuid4().hex[:12]}",
+                "custom_id": item["custom_id"],
+                "response": {"status_code": 200, "body": self.complete(item["body"])},
+                "error": None
+            }, ensure_ascii=False))
+
+        output_file_id = f"file-{uuid.uuid4().hex[:12]}"
+        self.files[output_file_id] = ("\n".join(output_lines) + "\n").encode("utf-8")
+        batch["output_file_id"] = output_file_id
+        batch["status"] = "completed"
+
+    def _batch_view(self, batch_id: str) -> Dict[str, Any]:
+        """Public view of a batch record (批处理记录的公开视图)."""
+        return {k: v for k, v in self.batches[batch_id].items() if k != "polls"}
+
+    def _make_handler(self):
+        """Build the request handler class bound to this server.
+        构建绑定到此服务器的请求处理类。
+        """
+        stub = self
+
+        class Handler(BaseHTTPRequestHandler):
+            protocol_version = "HTTP/1.1"
+
+            def _dispatch(self, method: str):
+                length = int(self.headers.get("Content-Length") or 0)
+                body = self.rfile.read(length) if length else b""
+                try:
+                    status, data = stub.handle(method, self.path, self.headers, body)
+                except Exception as e:
+                    status, data = 500, {"error": {"message": f"Stub server error: {e}"}}
+                self._send(status, data)
+
+            def _send(self, status: int, data: Any):
+                if hasattr(data, "write_to"):
+                    # Body controls its own framing (e.g. fault injection)
+                    # 响应体自行控制帧格式（例如故障注入）
+                    data.write_to(self)
+                    return
+                if isinstance(data, EventStream):
+                    self._send_events(status, data)
+                    return
+                if isinstance(data, bytes):
+                    payload, content_type = data, "application/octet-stream"
+                else:
+                    payload, content_type = json.dumps(data).encode("utf-8"), "application/json"
+                self.send_response(status)
+                self.send_header("Content-Type", content_type)
+                self.send_header("Content-Length", str(len(payload)))
+                self.end_headers()
+                self.wfile.write(payload)
+
+            def _send_events(self, status: int, stream: EventStream):
+                # No Content-Length: the body ends when the connection closes
+                # 不设置Content-Length：连接关闭即表示响应体结束
+                self.send_response(status)
+                self.send_header("Content-Type", "text/event-stream")
+                self.send_header("Connection", "close")
+                self.end_headers()
+                self.close_connection = True
+                try:
+                    for event in stream.events:
+                        data = event if isinstance(event, str) else json.dumps(event, ensure_ascii=False)
+                        self.wfile.write(f"data: {data}\n\n".encode("utf-8"))
+                        self.wfile.flush()
+                except (BrokenPipeError, ConnectionResetError):
+                    # Client cancelled the stream (客户端取消了流)
+                    pass
+
+            def do_GET(self):
+                self._dispatch("GET")
+
+            def do_POST(self):
+                self._dispatch("POST")
+
+            def log_message(self, format, *args):
+                # Keep test output quiet (保持测试输出简洁)
+                pass
+
+        return Handler
+
+
+def main():
+    """Run the stub server standalone, optionally replaying a recording.
+    独立运行替身服务器，可选回放录制文件。
+    """
+    from .replay import LatencyModel, ReplayResponder, load_recordings
+
+    parser = argparse.ArgumentParser(
+        prog="python -m src.stub_server",
+        description="Local OpenAI-compatible stand-in server (本地OpenAI兼容替身服务器)"
+    )
+    parser.add_argument("--host", default="127.0.0.1", help="Bind address (绑定地址)")
+    parser.add_argument("--port", type=int, default=8000, help="Bind port (default: 8000) (绑定端口)")
+    parser.add_argument("--replay", default=None, help="JSONL recording to replay (要回放的JSONL录制文件)")
+    parser.add_argument("--latency", default="recorded",
+                        help="Latency distribution for replay (default: recorded) (回放的延迟分布)")
+    parser.add_argument("--seed", type=int, default=0, help="Random seed (随机种子)")
+    args = parser.parse_args()
+
+    responder = None
+    if args.replay:
+        responder = ReplayResponder(load_recordings(args.replay), LatencyModel(args.latency, seed=args.seed))
+
+    server = StubServer(responder=responder, host=args.host, port=args.port)
+    print(f"Stub server listening on {server.base_url} (set BAILIAN_BASE_URL to this)")
+    try:
+        server._httpd.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server._httpd.server_close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
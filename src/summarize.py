@@ -0,0 +1,178 @@
+"""Map-reduce hierarchical summarization into a whole-log diagnosis.
+通过映射-归约分层摘要得到整份日志的诊断。
+
+Window results are turned into compact items and reduced in groups of
+``fan_in`` per level, every group of a level in parallel, until one summary
+remains. Wall time therefore grows with log_fan_in(windows), not with windows.
+窗口结果被转换为紧凑条目，每层按 ``fan_in`` 个一组归约，同一层的所有组并行处理，直到只剩一个摘要。
+因此总耗时随 log_fan_in(窗口数) 增长，而不是随窗口数增长。
+"""
+
+import json
+import threading
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from typing import Any, Callable, Dict, List, Optional
+
+from .bailian_client import VALID_STATES, BailianClient
+
+
+# Longest reason kept in a window item (窗口条目保留的最长原因)
+MAX_REASON_CHARS = 200
+
+
+def load_reduce_prompt() -> str:
+    """Load the reduction prompt from docs/prompt_reduce.md.
+    从docs/prompt_reduce.md加载归约提示词。
+    """
+    prompt_path = Path(__file__).parent.parent / "docs" / "prompt_reduce.md"
+    if not prompt_path.exists():
+        raise FileNotFoundError(f"Reduce prompt not found at {prompt_path}")
+    with open(prompt_path, 'r', encoding='utf-8') as f:
+        return f.read()
+
+
+def window_item(result: Dict[str, Any]) -> Dict[str, Any]:
+    """Compact level-0 item for one window result (单个窗口结果的紧凑第0层条目)."""
+    return {
+        "first_window": result["window_idx"],
+        "last_window": result["window_idx"],
+        "final_state": result["final_state"],
+        "confidence": result["confidence"],
+        "summary": result.get("reason", "")[:MAX_REASON_CHARS]
+    }
+
+
+def _as_list(value: Any) -> List[Any]:
+    """A model-returned field as a list; null or other types become empty (模型返回的字段转为列表)."""
+    return value if isinstance(value, list) else []
+
+
+def local_reduce(items: List[Dict[str, Any]], error: Optional[str] = None) -> Dict[str, Any]:
+    """Reduce a group without the LLM: keep states and transitions only.
+    不使用大模型归约一个组：仅保留状态和转换。
+
+    Used when a reduction request fails, so one bad call never loses the
+    windows below it.
+    在归约请求失败时使用，确保单次失败的调用不会丢失其下的窗口。
+    """
+    transitions = []
+    previous = None
+    for item in items:
+        transitions.extend(item.get("transitions", []))
+        if previous is not None and item["final_state"] != previous:
+            transitions.append({"window": item["first_window"], "from": previous, "to": item["final_state"]})
+        previous = item["final_state"]
+    issues = [f"Reduction failed: {error}"] if error else []
+    return {
+        "first_window": items[0]["first_window"],
+        "last_window": items[-1]["last_window"],
+        "final_state": items[-1]["final_state"],
+        "confidence": round(min(item["confidence"] for item in items), 2),
+        "summary": f"{len(items)} stretches, {len(transitions)} state changes (not summarized)",
+        "transitions": transitions,
+        "issues": issues
+    }
+
+
+class HierarchicalSummarizer:
+    """Tree reduction of window results with one LLM call per group.
+    对窗口结果进行树形归约，每组一次大模型调用。
+    """
+
+    def __init__(
+        self,
+        client: BailianClient,
+        prompt: str,
+        fan_in: int = 16,
+        concurrency: int = 8
+    ):
+        """Initialize the summarizer.
+        初始化摘要器。
+
+        Args:
+            client: Client used for reduction calls (用于归约调用的客户端)
+            prompt: Reduction system prompt (归约系统提示词)
+            fan_in: Items combined per call (每次调用合并的条目数)
+            concurrency: Groups reduced in parallel within a level (同一层内并行归约的组数)
+        """
+        if fan_in < 2:
+            raise ValueError("fan_in must be at least 2")
+        self.client = client
+        self.prompt = prompt
+        self.fan_in = fan_in
+        self.concurrency = max(concurrency, 1)
+        self.calls = 0
+        self.failures = 0
+        # Usage of every reduction call, shaped like window results (每次归约调用的用量，格式与窗口结果相同)
+        self.usage: List[Dict[str, Any]] = []
+        self._lock = threading.Lock()
+
+    def reduce_group(self, items: List[Dict[str, Any]]) -> Dict[str, Any]:
+        """Reduce one group of items to a summary (将一组条目归约为摘要)."""
+        usage: Dict[str, Any] = {}
+        try:
+            parsed = self.client.complete_json(self.prompt, json.dumps(items, ensure_ascii=False), usage=usage)
+        except Exception as e:
+            with self._lock:
+                self.failures += 1
+            return local_reduce(items, str(e))
+        finally:
+            if usage:
+                with self._lock:
+                    self.usage.append(usage)
+
+        state = str(parsed.get("final_state", "")).upper()
+        try:
+            confidence = float(parsed.get("confidence", 0.0))
+        except (TypeError, ValueError):
+            confidence = 0.0
+        return {
+            # The covered range comes from the inputs, not the model (覆盖范围取自输入，而非模型)
+            "first_window": items[0]["first_window"],
+            "last_window": items[-1]["last_window"],
+            "final_state": state if state in VALID_STATES else items[-1]["final_state"],
+            "confidence": max(0.0, min(confidence, 1.0)),
+            "summary": str(parsed.get("summary", "")),
+            "transitions": [t for t in _as_list(parsed.get("transitions")) if isinstance(t, dict)],
+            "issues": [str(i) for i in _as_list(parsed.get("issues"))][:5]
+        }
+
+    def run(
+        self,
+        window_results: List[Dict[str, Any]],
+        on_level: Optional[Callable[[int, int], None]] = None
+    ) -> Dict[str, Any]:
+        """Reduce all window results into a whole-log diagnosis.
+        将所有窗口结果归约为整份日志的诊断。
+
+        Args:
+            window_results: Ordered window results (有序的窗口结果)
+            on_level: Called with (level, group count) before each level
+                     每层开始前以 (层号, 组数) 调用
+
+        Returns:
+            Dict with ``diagnosis`` (root summary), ``levels`` (summaries per
+            level), ``calls``, ``failures`` and ``usage`` (per-call usage records)
+            包含 ``diagnosis``（根摘要）、``levels``（各层摘要）、``calls``、``failures`` 和 ``usage``（每次调用的用量记录）的字典
+        """
+        items = [window_item(r) for r in window_results]
+        levels: List[List[Dict[str, Any]]] = []
+        if not items:
+            return {"diagnosis": None, "levels": levels, "calls": 0, "failures": 0, "usage": []}
+
+        while True:
+            groups = [items[i:i + self.fan_in] for i in range(0, len(items), self.fan_in)]
+            if on_level:
+                on_level(len(levels) + 1, len(groups))
+            self.calls += len(groups)
+            with ThreadPoolExecutor(max_workers=min(self.concurrency, len(groups))) as pool:
+                items = list(pool.map(self.reduce_group, groups))
+            levels.append(items)
+            if len(items) == 1:
+                break
+
+        return {
+            "diagnosis": items[0], "levels": levels, "calls": self.calls, "failures": self.failures,
+            "usage": self.usage
+        }
@@ -0,0 +1,134 @@
+"""Line-level state timeline reconciled from overlapping window verdicts.
+由重叠窗口结论调和得到的行级状态时间线。
+
+Each window result votes for its state on the lines its window covers, with
+its confidence as the weight. A sweep over the window boundaries keeps the
+weight of each state among the windows covering the current line range, and
+every line takes the state with the most weight. Overlap lines covered by two
+windows therefore follow the more confident verdict instead of whichever
+window comes first, and transitions land on a line, not on a window. Sorting
+the 2n boundaries dominates: O(n log n) for n windows, whatever the window size.
+每个窗口结果以其置信度为权重，为其窗口覆盖的行投票。对窗口边界进行扫描，维护覆盖当前行区间的窗口中
+各状态的权重，每一行取权重最大的状态。因此被两个窗口覆盖的重叠行服从置信度更高的结论，而不是先出现的窗口，
+状态转换落在具体的行而非窗口上。对2n个边界排序占主要开销：n个窗口为O(n log n)，与窗口大小无关。
+"""
+
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+STATES = ("PLAYING", "MUTED", "UNKNOWN")
+
+
+def _winner(weights: Dict[str, float], votes: Dict[str, int], previous: Optional[str]) -> str:
+    """State with the most weight; ties go to states with votes, then to the previous state.
+    权重最大的状态；平局时优先有投票的状态，其次为前一个状态。
+    """
+    # Rounding keeps float residue from the running sums from breaking ties (取整避免累加残差影响平局判断)
+    return max(
+        STATES,
+        key=lambda state: (round(weights[state], 9), votes[state] > 0, state == previous, -STATES.index(state))
+    )
+
+
+def line_timeline(
+    window_results: List[Dict[str, Any]],
+    spans: List[Tuple[int, int, int]],
+    timestamp_of: Optional[Callable[[int], Optional[str]]] = None,
+    source_line_of: Optional[Callable[[int], int]] = None
+) -> Dict[str, Any]:
+    """Project window verdicts onto lines and reconcile overlaps by weighted vote.
+    将窗口结论投影到行上，并通过加权投票调和重叠部分。
+    
+    ``start_line``, ``end_line`` and a transition's ``line`` are 0-based
+    indices into the filtered lines; ``source_start_line``, ``source_end_line``
+    and ``source_line`` give the 1-based line numbers in the log file.
+    ``start_line``、``end_line`` 及转换的 ``line`` 是过滤后行列表中从0开始的索引；
+    ``source_start_line``、``source_end_line`` 和 ``source_line`` 给出日志文件中从1开始的行号。
+    
+    Args:
+        window_results: Results with window_idx, final_state and confidence
+                       包含window_idx、final_state和confidence的结果
+        spans: (window_idx, start_line, end_line_exclusive) from LogChunker.window_spans
+              来自LogChunker.window_spans的 (窗口索引, 起始行, 结束行（不包含）)
+        timestamp_of: Line number -> timestamp, None to leave times out
+                     行号 -> 时间戳，为None时不填时间
+        source_line_of: Line number -> line number in the log file, None to
+                       leave source lines out
+                       行号 -> 日志文件中的行号，为None时不填源行号
+        
+    Returns:
+        Dict with ``entries`` (state runs with inclusive line ranges, times,
+        mean winning confidence and agreement) and ``transitions``
+        包含 ``entries``（状态区间，含行范围、时间、获胜方平均置信度和一致度）和 ``transitions`` 的字典
+    """
+    bounds = {idx: (start, end) for idx, start, end in spans}
+    events = []
+    for result in window_results:
+        span = bounds.get(result["window_idx"])
+        if span is None or span[0] >= span[1]:
+            continue
+        state = result["final_state"] if result["final_state"] in STATES else "UNKNOWN"
+        weight = max(float(result.get("confidence") or 0.0), 0.0)
+        events.append((span[0], 1, state, weight, result["window_idx"]))
+        events.append((span[1], -1, state, weight, result["window_idx"]))
+    events.sort(key=lambda e: (e[0], e[1]))
+    
+    weights = {state: 0.0 for state in STATES}
+    votes = {state: 0 for state in STATES}
+    active: Dict[int, int] = {}
+    entries: List[Dict[str, Any]] = []
+    current: Optional[Dict[str, Any]] = None
+    i = 0
+    while i < len(events):
+        line = events[i][0]
+        while i < len(events) and events[i][0] == line:
+            _, delta, state, weight, window_idx = events[i]
+            votes[state] += delta
+            weights[state] = weights[state] + delta * weight if votes[state] else 0.0
+            active[window_idx] = active.get(window_idx, 0) + delta
+            if not active[window_idx]:
+                del active[window_idx]
+            i += 1
+        if not active or i == len(events):
+            current = None
+            continue
+        end = events[i][0]
+        state = _winner(weights, votes, current["state"] if current else None)
+        total = sum(weights.values())
+        length = end - line
+        if current is None or current["state"] != state:
+            current = {
+                "state": state,
+                "start_line": line,
+                "end_line": end - 1,
+                "windows": [min(active), max(active)],
+                "_confidence": 0.0,
+                "_agreement": 0.0,
+                "contested_lines": 0
+            }
+            entries.append(current)
+        current["end_line"] = end - 1
+        current["windows"] = [min(current["windows"][0], min(active)), max(current["windows"][1], max(active))]
+        current["_confidence"] += length * (weights[state] / votes[state] if votes[state] else 0.0)
+        current["_agreement"] += length * (weights[state] / total if total > 0 else 0.0)
+        if sum(1 for s in STATES if votes[s]) > 1:
+            current["contested_lines"] += length
+    
+    transitions = []
+    for previous, entry in zip([None] + entries, entries):
+        lines = entry["end_line"] - entry["start_line"] + 1
+        entry["confidence"] = round(entry.pop("_confidence") / lines, 2)
+        entry["agreement"] = round(entry.pop("_agreement") / lines, 2)
+        entry["start_time"] = timestamp_of(entry["start_line"]) if timestamp_of else None
+        entry["end_time"] = timestamp_of(entry["end_line"]) if timestamp_of else None
+        entry["source_start_line"] = source_line_of(entry["start_line"]) if source_line_of else None
+        entry["source_end_line"] = source_line_of(entry["end_line"]) if source_line_of else None
+        # A run after unanalyzed lines has no known predecessor (未分析行之后的区间没有已知的前驱)
+        if previous is not None and previous["end_line"] + 1 == entry["start_line"]:
+            transitions.append({
+                "line": entry["start_line"],
+                "source_line": entry["source_start_line"],
+                "time": entry["start_time"],
+                "from": previous["state"],
+                "to": entry["state"]
+            })
+    return {"entries": entries, "transitions": transitions}
@@ -0,0 +1,49 @@
+"""Local token count estimation.
+本地token数量估算。
+
+Qwen tokenizers encode roughly one token per CJK character and about four
+characters per token for ASCII log text. The estimate is used for budgeting
+only, so it errs on the high side.
+通义千问分词器大约每个中日韩字符一个token，ASCII日志文本约每四个字符一个token。
+估算仅用于预算，因此偏向高估。
+"""
+
+import re
+from typing import Iterable
+
+
+# CJK unified ideographs and full-width punctuation (中日韩统一表意文字及全角标点)
+_CJK_PATTERN = re.compile('[\u3000-\u303f\u4e00-\u9fff\uff00-\uffef]')
+
+# Extra tokens per chat message for role and separators (每条聊天消息的角色和分隔符额外token)
+MESSAGE_OVERHEAD_TOKENS = 4
+
+
+def estimate_tokens(text: str) -> int:
+    """Estimate the number of tokens in a text.
+    估算文本的token数量。
+
+    Args:
+        text: Text to estimate (要估算的文本)
+
+    Returns:
+        Estimated token count (估算的token数量)
+    """
+    if not text:
+        return 0
+    cjk = len(_CJK_PATTERN.findall(text))
+    other = len(text) - cjk
+    return cjk + (other + 3) // 4
+
+
+def estimate_lines_tokens(lines: Iterable[str]) -> int:
+    """Estimate tokens for log lines joined by newlines.
+    估算以换行符连接的日志行的token数量。
+    """
+    total = 0
+    count = 0
+    for line in lines:
+        total += estimate_tokens(line)
+        count += 1
+    # One newline token between lines (行之间各一个换行token)
+    return total + max(count - 1, 0)
@@ -0,0 +1,148 @@
+"""Span tracing exported as Chrome trace-event JSON.
+导出为Chrome trace-event JSON的跨度追踪。
+
+Spans are recorded as complete ("X") events with microsecond timestamps, one
+track per thread, so a run opens directly in chrome://tracing or
+https://ui.perfetto.dev. Spans on the same thread nest by time.
+跨度记录为微秒时间戳的完整（"X"）事件，每个线程一条轨道，因此一次运行可以直接在
+chrome://tracing或https://ui.perfetto.dev中打开。同一线程上的跨度按时间嵌套。
+"""
+
+import json
+import os
+import threading
+import time
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Any, Dict, Iterator, List, Optional
+
+
+class Tracer:
+    """Thread-safe collector of trace spans.
+    线程安全的追踪跨度收集器。
+    """
+
+    def __init__(self, enabled: bool = True, process_name: str = "mtk-log-inspector"):
+        """Initialize the tracer.
+        初始化追踪器。
+
+        Args:
+            enabled: Record events; a disabled tracer costs almost nothing
+                    是否记录事件；禁用的追踪器几乎没有开销
+            process_name: Name shown for the process track (进程轨道显示的名称)
+        """
+        self.enabled = enabled
+        self.process_name = process_name
+        self._origin = time.perf_counter()
+        self._events: List[Dict[str, Any]] = []
+        self._threads: Dict[int, tuple] = {}
+        self._lock = threading.Lock()
+
+    @staticmethod
+    def now() -> float:
+        """Clock used for span boundaries (跨度边界所用的时钟)."""
+        return time.perf_counter()
+
+    def _tid(self) -> int:
+        thread = threading.current_thread()
+        with self._lock:
+            if thread.ident not in self._threads:
+                self._threads[thread.ident] = (len(self._threads) + 1, thread.name)
+            return self._threads[thread.ident][0]
+
+    def _ts(self, moment: float) -> float:
+        return round((moment - self._origin) * 1e6, 1)
+
+    def add_span(
+        self,
+        name: str,
+        start: float,
+        end: float,
+        cat: str = "stage",
+        args: Optional[Dict[str, Any]] = None
+    ):
+        """Record a span measured by the caller with ``now()``.
+        记录调用方用 ``now()`` 测得的跨度。
+        """
+        if not self.enabled:
+            return
+        event = {
+            "name": name,
+            "cat": cat,
+            "ph": "X",
+            "ts": self._ts(start),
+            "dur": round(max(end - start, 0.0) * 1e6, 1),
+            "pid": os.getpid(),
+            "tid": self._tid(),
+        }
+        if args:
+            event["args"] = args
+        with self._lock:
+            self._events.append(event)
+
+    @contextmanager
+    def span(self, name: str, cat: str = "stage", **args) -> Iterator[Dict[str, Any]]:
+        """Trace the enclosed block; the yielded dict becomes the span's args.
+        追踪所包围的代码块；产出的字典会成为跨度的参数。
+        """
+        if not self.enabled:
+            yield args
+            return
+        start = self.now()
+        try:
+            yield args
+        finally:
+            self.add_span(name, start, self.now(), cat, args)
+
+    def counter(self, name: str, **values: float):
+        """Record counter values, e.g. queue depths (记录计数器值，例如队列深度)."""
+        if not self.enabled:
+            return
+        event = {
+            "name": name,
+            "ph": "C",
+            "ts": self._ts(self.now()),
+            "pid": os.getpid(),
+            "tid": self._tid(),
+            "args": values
+        }
+        with self._lock:
+            self._events.append(event)
+
+    def events(self) -> List[Dict[str, Any]]:
+        """Recorded events in timestamp order (按时间戳排序的已记录事件)."""
+        with self._lock:
+            return sorted(self._events, key=lambda e: e["ts"])
+
+    def stage_totals(self) -> Dict[str, float]:
+        """Seconds spent per stage span name, in first-seen order.
+        按首次出现顺序列出每个阶段跨度名称的耗时（秒）。
+        """
+        totals: Dict[str, float] = {}
+        for event in self.events():
+            if event["ph"] == "X" and event["cat"] == "stage":
+                totals[event["name"]] = totals.get(event["name"], 0.0) + event["dur"] / 1e6
+        return totals
+
+    def to_chrome(self) -> Dict[str, Any]:
+        """Chrome trace-event JSON object (Chrome trace-event JSON对象)."""
+        pid = os.getpid()
+        metadata = [{"name": "process_name", "ph": "M", "pid": pid, "args": {"name": self.process_name}}]
+        with self._lock:
+            threads = list(self._threads.values())
+        metadata.extend(
+            {"name": "thread_name", "ph": "M", "pid": pid, "tid": tid, "args": {"name": name}}
+            for tid, name in threads
+        )
+        return {"traceEvents": metadata + self.events(), "displayTimeUnit": "ms"}
+
+    def write(self, path: str):
+        """Write the trace as JSON (以JSON写出追踪)."""
+        target = Path(path)
+        target.parent.mkdir(parents=True, exist_ok=True)
+        with open(target, 'w', encoding='utf-8') as f:
+            json.dump(self.to_chrome(), f)
+
+
+# Shared disabled tracer for components created without one (未提供追踪器的组件共用的禁用追踪器)
+NULL_TRACER = Tracer(enabled=False)
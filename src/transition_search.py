@@ -0,0 +1,118 @@
+"""Coarse-to-fine search for state transitions.
+由粗到细的状态转换搜索。
+
+Analyzes a sparse sample of windows, then bisects only the gaps whose two ends
+disagree, so a log with k transitions needs about n/stride + k*log2(stride)
+calls instead of n. Windows between agreeing samples inherit their state.
+先分析稀疏采样的窗口，然后只对两端结论不一致的区间做二分，因此包含k个转换的日志约需 n/stride + k*log2(stride) 次调用而非n次。
+结论一致的采样点之间的窗口继承其状态。
+
+A state that starts and ends between two agreeing samples is not seen, so the
+stride bounds the shortest segment the search is guaranteed to find.
+在两个结论一致的采样点之间开始并结束的状态不会被发现，因此步长决定了搜索能保证发现的最短片段。
+"""
+
+import math
+from concurrent.futures import ThreadPoolExecutor
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+
+def default_stride(window_count: int) -> int:
+    """Sampling stride that balances sampling and bisection calls (~sqrt(n)).
+    在采样调用和二分调用之间取得平衡的采样步长（约为sqrt(n)）。
+    """
+    return max(1, math.isqrt(max(window_count - 1, 0)))
+
+
+class TransitionSearch:
+    """Bisection scheduler over an ordered list of windows.
+    在有序窗口列表上进行二分调度。
+    """
+
+    def __init__(
+        self,
+        analyze: Callable[[int, List[str]], Dict[str, Any]],
+        stride: Optional[int] = None,
+        concurrency: int = 1
+    ):
+        """Initialize the search.
+        初始化搜索。
+
+        Args:
+            analyze: Called with (window_idx, window_lines); returns a window result
+                    and must not raise (以 (窗口索引, 窗口日志行) 调用，返回窗口结果且不得抛出异常)
+            stride: Distance between initial samples, default ~sqrt(n) (初始采样间距，默认约sqrt(n))
+            concurrency: Windows analyzed in parallel within a round (每轮内并行分析的窗口数)
+        """
+        self.analyze = analyze
+        self.stride = stride
+        self.concurrency = max(concurrency, 1)
+        self.calls = 0
+        self.rounds = 0
+
+    def _analyze_round(
+        self,
+        windows: List[Tuple[int, List[str]]],
+        positions: List[int],
+        results: Dict[int, Dict[str, Any]]
+    ):
+        """Analyze the windows at the given list positions (分析给定列表位置处的窗口)."""
+        self.rounds += 1
+        self.calls += len(positions)
+        if self.concurrency > 1 and len(positions) > 1:
+            with ThreadPoolExecutor(max_workers=self.concurrency) as pool:
+                outcomes = list(pool.map(lambda p: self.analyze(*windows[p]), positions))
+        else:
+            outcomes = [self.analyze(*windows[p]) for p in positions]
+        for position, result in zip(positions, outcomes):
+            results[position] = result
+
+    def run(self, windows: List[Tuple[int, List[str]]]) -> List[Dict[str, Any]]:
+        """Search for transitions and return a result for every window.
+        搜索状态转换并为每个窗口返回结果。
+
+        Returns:
+            Ordered window results, ready for WindowAnalyzer.merge_windows. Windows
+            that were not analyzed copy the preceding sample's result and carry
+            ``inferred`` and ``inferred_from`` fields.
+            有序的窗口结果，可直接用于WindowAnalyzer.merge_windows。未分析的窗口复制前一个采样点的结果，
+            并带有 ``inferred`` 和 ``inferred_from`` 字段。
+        """
+        n = len(windows)
+        if n == 0:
+            return []
+        stride = self.stride or default_stride(n)
+
+        results: Dict[int, Dict[str, Any]] = {}
+        samples = sorted(set(range(0, n, stride)) | {n - 1})
+        self._analyze_round(windows, samples, results)
+
+        # Gaps (left, right) between neighboring analyzed positions; a gap is split
+        # while its two ends disagree (相邻已分析位置之间的区间；两端结论不一致时继续拆分)
+        gaps = [(a, b) for a, b in zip(samples, samples[1:])]
+        while True:
+            open_gaps = [
+                (a, b) for a, b in gaps
+                if b - a > 1 and results[a]["final_state"] != results[b]["final_state"]
+            ]
+            if not open_gaps:
+                break
+            midpoints = [(a + b) // 2 for a, b in open_gaps]
+            self._analyze_round(windows, midpoints, results)
+            gaps = [g for (a, b), m in zip(open_gaps, midpoints) for g in ((a, m), (m, b))]
+
+        ordered = []
+        source = None
+        for position in range(n):
+            if position in results:
+                source = results[position]
+                ordered.append(source)
+                continue
+            inferred = dict(source)
+            inferred.update({
+                "window_idx": windows[position][0],
+                "inferred": True,
+                "inferred_from": source["window_idx"]
+            })
+            ordered.append(inferred)
+        return ordered
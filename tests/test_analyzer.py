@@ -1,7 +1,11 @@
 """Tests for analyzer module."""
 
+import random
+
 import pytest
 from src.analyzer import WindowAnalyzer, AudioSegment
+from src.chunker import LogChunker
+from src.provenance import EvidenceIndex, LineProvenance
 
 
 def test_audio_segment_creation():
@@ -302,3 +306,201 @@ def test_generate_markdown_report():
     assert "PLAYING" in markdown
     assert "Evidence 1" in markdown
     assert "0 to 2" in markdown
+    assert "## State Timeline" not in markdown
+
+
+def test_markdown_report_shows_transition_times():
+    """Test the markdown report lists line-level transitions with their timestamps."""
+    analyzer = WindowAnalyzer()
+    timeline = {
+        "entries": [
+            {"state": "PLAYING", "start_line": 0, "end_line": 11, "start_time": "01-06 10:15:00.000",
+             "end_time": "01-06 10:15:11.000", "confidence": 0.9, "agreement": 1.0,
+             "source_start_line": 3, "source_end_line": 40},
+            {"state": "MUTED", "start_line": 12, "end_line": 20, "start_time": "01-06 10:15:12.345",
+             "end_time": "01-06 10:15:20.000", "confidence": 0.8, "agreement": 0.75,
+             "source_start_line": 44, "source_end_line": 71}
+        ],
+        "transitions": [
+            {"line": 12, "source_line": 44, "time": "01-06 10:15:12.345", "from": "PLAYING", "to": "MUTED"}
+        ]
+    }
+    
+    markdown = analyzer.generate_markdown_report([], {"total_windows": 3}, timeline=timeline)
+    
+    # Source line numbers, as in the evidence prefixes (源行号，与证据前缀一致)
+    assert "## State Timeline" in markdown
+    assert "- `01-06 10:15:12.345` (line 44): PLAYING → MUTED" in markdown
+    assert "| MUTED | 44-71 | 01-06 10:15:12.345 | 01-06 10:15:20.000 | 0.80 | 0.75 |" in markdown
+    
+    # Without provenance the indices are labelled as filtered lines (没有来源信息时标注为过滤后行)
+    for entry in timeline["entries"]:
+        entry["source_start_line"] = entry["source_end_line"] = None
+    timeline["transitions"][0].update(source_line=None, time=None)
+    markdown = analyzer.generate_markdown_report([], {"total_windows": 3}, timeline=timeline)
+    assert "- Filtered line 12: PLAYING → MUTED" in markdown
+    assert "| State | Filtered Lines |" in markdown
+    assert "| MUTED | 12-20 |" in markdown
+
+
+def test_cross_check():
+    """Test window results are compared with engine states."""
+    analyzer = WindowAnalyzer()
+    window_results = [
+        {"window_idx": 0, "final_state": "PLAYING"},
+        {"window_idx": 1, "final_state": "MUTED"},
+        {"window_idx": 2, "final_state": "UNKNOWN"},
+        {"window_idx": 3, "final_state": "PLAYING"},
+    ]
+    
+    summary = analyzer.cross_check(window_results, {0: "PLAYING", 1: "PLAYING", 2: "MUTED"})
+    
+    assert summary == {"compared": 2, "agreements": 1, "disagreements": [1]}
+    assert [r["engine_state"] for r in window_results] == ["PLAYING", "PLAYING", "MUTED", "UNKNOWN"]
+
+
+def test_merge_windows_split_on_gaps():
+    """Test segments do not span unanalyzed windows when split_on_gaps is set."""
+    analyzer = WindowAnalyzer()
+    window_results = [
+        {"window_idx": 0, "final_state": "PLAYING", "confidence": 0.9, "reason": "R1", "evidence": []},
+        {"window_idx": 1, "final_state": "PLAYING", "confidence": 0.9, "reason": "R2", "evidence": []},
+        {"window_idx": 4, "final_state": "PLAYING", "confidence": 0.9, "reason": "R3", "evidence": []},
+    ]
+    
+    assert len(analyzer.merge_windows(window_results)) == 1
+    
+    segments = analyzer.merge_windows(window_results, split_on_gaps=True)
+    assert [(s.start_window, s.end_window) for s in segments] == [(0, 1), (4, 4)]
+
+
+def random_results(rng, count, gap_rate=0.0):
+    states = ["PLAYING", "MUTED", "UNKNOWN"]
+    results = []
+    state = rng.choice(states)
+    for idx in range(count):
+        if rng.random() < gap_rate:
+            continue
+        if rng.random() < 0.3:
+            state = rng.choice(states)
+        results.append({
+            "window_idx": idx,
+            "final_state": state,
+            "confidence": round(rng.random(), 2),
+            "reason": f"r{idx}",
+            "evidence": [f"e{rng.randrange(5)}", f"e{idx}"]
+        })
+    return results
+
+
+def test_online_merger_matches_merge_windows():
+    """Test the online merger gives merge_windows' segments for any arrival order."""
+    rng = random.Random(7)
+    analyzer = WindowAnalyzer()
+    for trial in range(200):
+        split = trial % 2 == 0
+        results = random_results(rng, rng.randrange(0, 40), gap_rate=0.15 if trial % 3 == 0 else 0.0)
+        expected = [s.to_dict() for s in analyzer.merge_windows(results, split_on_gaps=split)]
+        # Reasons are capped like evidence; these are all distinct (原因与证据一样有上限；这里的原因各不相同)
+        for segment in expected:
+            segment["reasons"] = segment["reasons"][:5]
+        
+        shuffled = list(results)
+        rng.shuffle(shuffled)
+        emitted = []
+        merger = analyzer.online_merger(on_segment=emitted.append, split_on_gaps=split)
+        for result in shuffled:
+            merger.add(result)
+        segments = merger.finish()
+        
+        assert [s.to_dict() for s in emitted] == expected
+        # Segments handed to on_segment are not kept; finish returns only its own
+        assert merger.segments == []
+        assert emitted[len(emitted) - len(segments):] == segments
+        # Evidence is capped at the five distinct lines to_dict reports
+        assert all(len(s.evidence) <= 5 for s in emitted)
+        
+        merger = analyzer.online_merger(split_on_gaps=split)
+        for result in shuffled:
+            merger.add(result)
+        assert [s.to_dict() for s in merger.finish()] == expected
+
+
+def test_online_merger_emits_on_confirmed_boundary():
+    """Test a segment is emitted once the next window ends it, buffering out-of-order results."""
+    analyzer = WindowAnalyzer()
+    merger = analyzer.online_merger()
+    
+    def result(idx, state):
+        return {"window_idx": idx, "final_state": state, "confidence": 0.9, "reason": "r"}
+    
+    assert merger.add(result(1, "PLAYING")) == []
+    assert merger.pending.keys() == {1}
+    assert merger.add(result(0, "PLAYING")) == []
+    emitted = merger.add(result(2, "MUTED"))
+    assert [(s.state, s.start_window, s.end_window) for s in emitted] == [("PLAYING", 0, 1)]
+    
+    # A skipped window releases the results behind it
+    assert merger.add(result(4, "PLAYING")) == []
+    emitted = merger.skip(3)
+    assert [(s.state, s.start_window, s.end_window) for s in emitted] == [("MUTED", 2, 2)]
+    assert merger.max_pending == 2
+    
+    with pytest.raises(ValueError):
+        merger.add(result(1, "MUTED"))
+    
+    segments = merger.finish()
+    assert [(s.state, s.start_window, s.end_window) for s in segments] == [
+        ("PLAYING", 0, 1), ("MUTED", 2, 2), ("PLAYING", 4, 4)
+    ]
+
+
+def test_online_merger_keeps_bounded_segment_state():
+    """Test a long segment keeps a running confidence average and capped reasons, not per-window lists."""
+    analyzer = WindowAnalyzer()
+    merger = analyzer.online_merger()
+    for idx in range(1000):
+        merger.add({"window_idx": idx, "final_state": "PLAYING", "confidence": 0.5 + (idx % 2) * 0.5,
+                    "reason": f"r{idx % 7}", "evidence": [f"e{idx}"]})
+    
+    current = merger._current
+    assert current["confidence_count"] == 1000
+    assert len(current["reasons"]) == 5
+    assert len(current["evidence"]) == 5
+    
+    segment, = merger.finish()
+    assert segment.confidence_avg == pytest.approx(0.75)
+    assert segment.reasons == ["r0", "r1", "r2", "r3", "r4"]
+
+
+def test_locate_segments():
+    """Test segments get time ranges, source lines and evidence positions."""
+    lines = [f"01-06 10:15:{i:02d}.500  1234  1235 I AudioFlinger: event {i}" for i in range(10)]
+    provenance = LineProvenance()
+    file_id = provenance.add_file("big.log")
+    for i, line in enumerate(lines):
+        provenance.append(file_id, i * 100, i * 3 + 1, line)
+    spans = LogChunker(chunk_size=4, overlap=1).window_spans(len(lines))
+    analyzer = WindowAnalyzer()
+    segments = analyzer.merge_windows([
+        {"window_idx": 0, "final_state": "PLAYING", "confidence": 0.9, "reason": "r", "evidence": [lines[2]]},
+        {"window_idx": 1, "final_state": "PLAYING", "confidence": 0.9, "reason": "r", "evidence": ["made up"]},
+        {"window_idx": 2, "final_state": "MUTED", "confidence": 0.8, "reason": "r", "evidence": []}
+    ])
+    
+    analyzer.locate_segments(segments, spans, provenance, EvidenceIndex(lines, provenance))
+    
+    data = segments[0].to_dict()
+    assert (data["start_time"], data["end_time"], data["duration_s"]) == (
+        "01-06 10:15:00.500", "01-06 10:15:06.500", 6.0
+    )
+    assert data["source"] == {"file": "big.log", "first_line": 1, "last_line": 19, "byte_offset": 0}
+    assert data["evidence_positions"] == [
+        {"file": "big.log", "byte_offset": 200, "line_number": 7, "timestamp": "01-06 10:15:02.500"}, None
+    ]
+    assert segments[1].start_time == "01-06 10:15:06.500"
+    
+    markdown = analyzer.generate_markdown_report(segments, {"total_windows": 3})
+    assert "- **Time:** 01-06 10:15:00.500 to 01-06 10:15:06.500 (6s)" in markdown
+    assert "- **Source Lines:** 1 to 19 of big.log" in markdown
+    assert f"7:{lines[2]}" in markdown
@@ -5,6 +5,7 @@ import json
 import os
 from unittest.mock import Mock, patch
 from src.bailian_client import BailianClient
+from src.pricing import estimate_cost
 
 
 def test_client_initialization_with_api_key():
@@ -219,3 +220,413 @@ def test_default_base_url():
     """Test default base URL."""
     client = BailianClient(api_key="test-key")
     assert "dashscope.aliyuncs.com" in client.base_url
+
+
+def make_packed_response(items):
+    """Create a mock response carrying a packed results array."""
+    mock_response = Mock()
+    mock_response.status_code = 200
+    mock_response.json.return_value = {
+        "choices": [{"message": {"content": json.dumps({"results": items})}}]
+    }
+    return mock_response
+
+
+def packed_item(window, state="PLAYING"):
+    return {
+        "window": window,
+        "final_state": state,
+        "confidence": 0.8,
+        "reason": "Reason",
+        "evidence": [],
+        "next_actions": []
+    }
+
+
+@patch('src.bailian_client.requests.post')
+def test_analyze_log_windows_packed_success(mock_post):
+    """Test that a packed response maps back to each window."""
+    mock_post.return_value = make_packed_response([packed_item(3), packed_item(4, "MUTED")])
+    
+    client = BailianClient(api_key="test-key")
+    results = client.analyze_log_windows_packed("System prompt", [(3, ["a"]), (4, ["b"])])
+    
+    assert results[3]["final_state"] == "PLAYING"
+    assert results[4]["final_state"] == "MUTED"
+    assert results[4]["window_idx"] == 4
+    assert "window" not in results[4]
+    
+    user_message = mock_post.call_args[1]['json']['messages'][1]['content']
+    assert "=== WINDOW 3 ===" in user_message
+    assert "=== WINDOW 4 ===" in user_message
+
+
+@patch('src.bailian_client.requests.post')
+def test_analyze_log_window_records_usage(mock_post):
+    """Test results carry the reported token usage, cost, latency and retries."""
+    mock_response = make_packed_response([])
+    mock_response.json.return_value = {
+        "choices": [{"message": {"content": json.dumps(packed_item(0))}}],
+        "usage": {"prompt_tokens": 1000, "completion_tokens": 100,
+                  "prompt_tokens_details": {"cached_tokens": 400}}
+    }
+    mock_post.return_value = mock_response
+    
+    client = BailianClient(api_key="test-key")
+    first = client.analyze_log_window("System prompt", "Log content")
+    second = client.analyze_log_window("System prompt", "Log content")
+    
+    assert first["usage"] == {"prompt_tokens": 1000, "completion_tokens": 100,
+                              "cached_tokens": 400, "estimated": False}
+    assert first["cost_cny"] == pytest.approx(estimate_cost("qwen-plus", 1000, 100))
+    assert first["model"] == "qwen-plus"
+    assert first["retries"] == 0
+    assert first["latency_s"] >= 0
+    assert second["call_id"] != first["call_id"]
+
+
+@patch('src.bailian_client.requests.post')
+def test_analyze_log_windows_packed_shares_usage(mock_post):
+    """Test a packed call's usage is split evenly over its windows under one call id."""
+    mock_response = make_packed_response([packed_item(3), packed_item(4)])
+    mock_response.json.return_value["usage"] = {"prompt_tokens": 600, "completion_tokens": 90}
+    mock_post.return_value = mock_response
+    
+    client = BailianClient(api_key="test-key")
+    results = client.analyze_log_windows_packed("System prompt", [(3, ["a"]), (4, ["b"])])
+    
+    assert results[3]["usage"]["prompt_tokens"] == 300
+    assert results[4]["usage"]["completion_tokens"] == 45
+    assert results[3]["call_id"] == results[4]["call_id"]
+    assert results[3]["shared_by"] == 2
+
+
+@patch('src.bailian_client.requests.post')
+def test_analyze_log_windows_packed_estimates_prompt_without_usage(mock_post):
+    """Test a packed call without a usage block is costed with its prompt estimate."""
+    mock_post.return_value = make_packed_response([packed_item(3), packed_item(4)])
+    
+    client = BailianClient(api_key="test-key")
+    results = client.analyze_log_windows_packed("System prompt", [(3, ["a"]), (4, ["b"])])
+    
+    assert results[3]["usage"]["estimated"] is True
+    assert results[3]["usage"]["prompt_tokens"] > 0
+
+
+@patch('src.bailian_client.requests.post')
+def test_analyze_log_windows_packed_drops_invalid_elements(mock_post):
+    """Test that elements failing schema validation are left out."""
+    bad = packed_item(4, "LOUD")
+    mock_response = make_packed_response([packed_item(3), bad])
+    mock_response.json.return_value["usage"] = {"prompt_tokens": 600, "completion_tokens": 90}
+    mock_post.return_value = mock_response
+    
+    client = BailianClient(api_key="test-key")
+    results = client.analyze_log_windows_packed("System prompt", [(3, ["a"]), (4, ["b"])])
+    
+    assert list(results) == [3]
+    # The answered window carries the whole call; the fallback window takes no share
+    assert results[3]["usage"]["prompt_tokens"] == 600
+    assert results[3]["shared_by"] == 1
+
+
+@patch('src.bailian_client.requests.post')
+def test_analyze_log_windows_packed_wrong_count(mock_post):
+    """Test that a result array of the wrong length is rejected."""
+    mock_post.return_value = make_packed_response([packed_item(3)])
+    
+    client = BailianClient(api_key="test-key")
+    
+    with pytest.raises(ValueError, match="1 results for 2 windows"):
+        client.analyze_log_windows_packed("System prompt", [(3, ["a"]), (4, ["b"])])
+
+
+def test_plan_packs_respects_limits():
+    """Test that packing respects window count and token budget."""
+    from src.bailian_client import plan_packs
+    
+    windows = [(i, ["short line"] * 5) for i in range(7)]
+    
+    packs = plan_packs(windows, "System prompt", max_windows=3, max_tokens=100000)
+    assert [len(p) for p in packs] == [3, 3, 1]
+    assert [w[0] for p in packs for w in p] == list(range(7))
+    
+    # A tight budget leaves every window in its own pack
+    # 预算紧张时每个窗口单独成组
+    packs = plan_packs(windows, "System prompt", max_windows=3, max_tokens=10)
+    assert [len(p) for p in packs] == [1] * 7
+
+
+def make_stream_response(content, chunk_chars=5):
+    """Create a mock SSE response streaming the given content."""
+    lines = []
+    for i in range(0, len(content), chunk_chars):
+        event = {"choices": [{"delta": {"content": content[i:i + chunk_chars]}}]}
+        lines.append(f"data: {json.dumps(event)}".encode())
+        lines.append(b"")
+    lines.append(b"data: [DONE]")
+    mock_response = Mock()
+    mock_response.status_code = 200
+    mock_response.iter_lines.return_value = iter(lines)
+    return mock_response
+
+
+STREAM_RESULT = {
+    "final_state": "MUTED",
+    "confidence": 0.8,
+    "reason": "Muted",
+    "evidence": ["Line 1"],
+    "next_actions": ["Check volume"]
+}
+
+
+@patch('src.bailian_client.requests.post')
+def test_analyze_log_window_stream(mock_post):
+    """Test streamed analysis reports fields incrementally."""
+    mock_post.return_value = make_stream_response(json.dumps(STREAM_RESULT))
+    fields = []
+    
+    client = BailianClient(api_key="test-key")
+    result = client.analyze_log_window_stream(
+        "System prompt", "Log content", on_field=lambda k, v: fields.append(k)
+    )
+    
+    assert {k: result[k] for k in STREAM_RESULT} == STREAM_RESULT
+    assert fields == list(STREAM_RESULT)
+    assert result["usage"]["estimated"] is True
+    assert result["usage"]["completion_tokens"] > 0
+    assert mock_post.call_args[1]['json']['stream'] is True
+    assert mock_post.call_args[1]['stream'] is True
+    mock_post.return_value.close.assert_called_once()
+
+
+@patch('src.bailian_client.requests.post')
+def test_analyze_log_window_stream_early_stop(mock_post):
+    """Test early stop ends the stream once merge fields are complete."""
+    mock_post.return_value = make_stream_response(json.dumps(STREAM_RESULT))
+    fields = []
+    
+    client = BailianClient(api_key="test-key")
+    result = client.analyze_log_window_stream(
+        "System prompt", "Log content", on_field=lambda k, v: fields.append(k), early_stop=True
+    )
+    
+    assert result["final_state"] == "MUTED"
+    assert result["evidence"] == []
+    assert result["early_stopped"] is True
+    assert "evidence" not in fields
+
+
+def test_analyze_log_window_stream_against_stub_server():
+    """Test streaming end-to-end through the local stub server."""
+    from src.stub_server import StubServer
+    
+    with StubServer(responder=lambda payload: STREAM_RESULT) as stub:
+        client = BailianClient(api_key="test-key", base_url=stub.base_url)
+        result = client.analyze_log_window_stream("System prompt", "Log content")
+    
+    assert {k: result[k] for k in STREAM_RESULT} == STREAM_RESULT
+    assert result["latency_s"] > 0
+
+
+@patch('src.bailian_client.requests.post')
+def test_analyze_log_window_compact(mock_post):
+    """Test compact mode numbers the window and expands evidence locally."""
+    mock_response = Mock()
+    mock_response.status_code = 200
+    mock_response.json.return_value = {
+        "choices": [{"message": {"content": json.dumps(
+            {"s": "P", "c": 0.9, "r": "Active", "e": [2], "n": []}
+        )}}]
+    }
+    mock_post.return_value = mock_response
+    
+    client = BailianClient(api_key="test-key", compact=True)
+    result = client.analyze_log_window("System prompt", "line one\nline two")
+    
+    assert result["final_state"] == "PLAYING"
+    assert result["evidence"] == ["line two"]
+    user_message = mock_post.call_args[1]['json']['messages'][1]['content']
+    assert "1| line one\n2| line two" in user_message
+
+
+@patch('src.bailian_client.requests.post')
+def test_analyze_log_window_stream_compact(mock_post):
+    """Test streamed compact responses report full field names."""
+    content = json.dumps({"s": "M", "c": 0.7, "r": "Muted", "e": [1], "n": []})
+    mock_post.return_value = make_stream_response(content)
+    fields = {}
+    
+    client = BailianClient(api_key="test-key", compact=True)
+    result = client.analyze_log_window_stream(
+        "System prompt", "muted line", on_field=lambda k, v: fields.setdefault(k, v)
+    )
+    
+    assert fields["final_state"] == "MUTED"
+    assert result["evidence"] == ["muted line"]
+
+
+@patch('src.bailian_client.requests.post')
+def test_analyze_log_window_serialized(mock_post):
+    """Test serialized windows are sent compactly and evidence maps back."""
+    lines = [
+        "01-06 10:15:23.456  1234  1235 D AudioFlinger: start track",
+        "01-06 10:15:23.506  1234  1235 D AudioFlinger: mixing active tracks",
+    ]
+    mock_response = Mock()
+    mock_response.status_code = 200
+    mock_response.json.return_value = {
+        "choices": [{"message": {"content": json.dumps({
+            "final_state": "PLAYING", "confidence": 0.9, "reason": "Mixing",
+            "evidence": ["+50 D AF: mixing active tracks"], "next_actions": []
+        })}}]
+    }
+    mock_post.return_value = mock_response
+    
+    client = BailianClient(api_key="test-key", serialize=True)
+    result = client.analyze_log_window("System prompt", "\n".join(lines))
+    
+    assert result["evidence"] == [lines[1]]
+    user_message = mock_post.call_args[1]['json']['messages'][1]['content']
+    assert "+0 [1234/1235] D AF: start track" in user_message
+    assert "10:15:23.506" not in user_message
+
+
+@patch('src.bailian_client.requests.post')
+def test_analyze_log_window_serialized_compact(mock_post):
+    """Test serialized compact windows number the body, not the legend."""
+    mock_response = Mock()
+    mock_response.status_code = 200
+    mock_response.json.return_value = {
+        "choices": [{"message": {"content": json.dumps(
+            {"s": "P", "c": 0.9, "r": "Active", "e": [2], "n": []}
+        )}}]
+    }
+    mock_post.return_value = mock_response
+    
+    client = BailianClient(api_key="test-key", compact=True, serialize=True)
+    result = client.analyze_log_window("System prompt", "line one\nline two")
+    
+    assert result["evidence"] == ["line two"]
+    user_message = mock_post.call_args[1]['json']['messages'][1]['content']
+    assert "1| ~ line one\n2| ~ line two" in user_message
+
+
+def test_client_records_request_spans():
+    """Test a traced request records HTTP, first-byte, parse and validation spans."""
+    from src.stub_server import StubServer
+    from src.tracing import Tracer
+    
+    tracer = Tracer()
+    with StubServer(responder=lambda payload: STREAM_RESULT) as stub:
+        client = BailianClient(api_key="test-key", base_url=stub.base_url, tracer=tracer)
+        client.analyze_log_window("System prompt", "Log content")
+    
+    names = [e["name"] for e in tracer.events()]
+    for name in ("request", "http", "ttfb", "download", "decode_body", "parse_json", "validate"):
+        assert name in names
+    request = next(e for e in tracer.events() if e["name"] == "request")
+    assert request["args"]["attempts"] == 1
+
+
+def make_http_error_response(status, retry_after=None):
+    """Create a mock response whose raise_for_status raises HTTPError."""
+    import requests
+    mock_response = Mock()
+    mock_response.status_code = status
+    mock_response.headers = {"Retry-After": retry_after} if retry_after else {}
+    mock_response.raise_for_status.side_effect = requests.HTTPError(response=mock_response)
+    return mock_response
+
+
+@patch('src.bailian_client.time.sleep')
+@patch('src.bailian_client.requests.post')
+def test_retry_on_rate_limit(mock_post, mock_sleep):
+    """Test that 429 responses are retried honoring Retry-After."""
+    success = Mock()
+    success.json.return_value = {"choices": [{"message": {"content": json.dumps(STREAM_RESULT)}}]}
+    mock_post.side_effect = [make_http_error_response(429, "2"), success]
+    
+    client = BailianClient(api_key="test-key", max_retries=2)
+    result = client.analyze_log_window("System prompt", "Log content")
+    
+    assert result["final_state"] == "MUTED"
+    assert mock_post.call_count == 2
+    mock_sleep.assert_called_once_with(2.0)
+
+
+@patch('src.bailian_client.time.sleep')
+@patch('src.bailian_client.requests.post')
+def test_no_retry_on_client_error(mock_post, mock_sleep):
+    """Test that non-429 4xx responses are not retried."""
+    import requests
+    mock_post.return_value = make_http_error_response(401)
+    
+    client = BailianClient(api_key="test-key", max_retries=3)
+    
+    with pytest.raises(requests.HTTPError):
+        client.analyze_log_window("System prompt", "Log content")
+    assert mock_post.call_count == 1
+
+
+@patch('src.bailian_client.time.sleep')
+@patch('src.bailian_client.requests.post')
+def test_stream_retries_and_closes_responses(mock_post, mock_sleep):
+    """Test streamed requests are retried like others and every response is closed."""
+    import requests
+    unavailable = make_http_error_response(503)
+    broken = make_stream_response(json.dumps(STREAM_RESULT))
+    broken.iter_lines.side_effect = requests.ConnectionError("stream reset")
+    success = make_stream_response(json.dumps(STREAM_RESULT))
+    mock_post.side_effect = [unavailable, broken, success]
+    
+    client = BailianClient(api_key="test-key", max_retries=2)
+    result = client.analyze_log_window_stream("System prompt", "Log content")
+    
+    assert result["final_state"] == "MUTED"
+    assert result["retries"] == 2
+    for response in (unavailable, broken, success):
+        response.close.assert_called_once()
+    
+    # A client error is not retried, and its response is still closed
+    rejected = make_http_error_response(400)
+    mock_post.side_effect = [rejected]
+    with pytest.raises(requests.HTTPError):
+        client.analyze_log_window_stream("System prompt", "Log content")
+    rejected.close.assert_called_once()
+
+
+def test_stream_records_request_spans():
+    """Test a traced stream records first-byte and download spans."""
+    from src.stub_server import StubServer
+    from src.tracing import Tracer
+    
+    tracer = Tracer()
+    with StubServer(responder=lambda payload: STREAM_RESULT) as stub:
+        client = BailianClient(api_key="test-key", base_url=stub.base_url, tracer=tracer)
+        client.analyze_log_window_stream("System prompt", "Log content")
+    
+    names = [e["name"] for e in tracer.events()]
+    for name in ("request", "http", "ttfb", "download", "validate"):
+        assert name in names
+    request = next(e for e in tracer.events() if e["name"] == "request")
+    assert request["args"]["stream"] is True
+
+
+@patch('src.bailian_client.requests.post')
+def test_complete_json(mock_post):
+    """Test free-form JSON requests skip window schema validation."""
+    mock_response = Mock()
+    mock_response.status_code = 200
+    mock_response.json.return_value = {"choices": [{"message": {"content": '{"summary": "ok"}'}}]}
+    mock_post.return_value = mock_response
+    
+    client = BailianClient(api_key="test-key")
+    
+    assert client.complete_json("System prompt", "Items") == {"summary": "ok"}
+    payload = mock_post.call_args[1]["json"]
+    assert payload["messages"][1]["content"] == "Items"
+    
+    mock_response.json.return_value = {"choices": [{"message": {"content": "[1, 2]"}}]}
+    with pytest.raises(ValueError, match="JSON object"):
+        client.complete_json("System prompt", "Items")
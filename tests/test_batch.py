@@ -0,0 +1,170 @@
+"""Tests for batch module."""
+
+import json
+from unittest.mock import Mock, patch
+
+import pytest
+import requests
+from src.bailian_client import BailianClient
+from src.batch import BatchRunner, BATCH_STATE_FILE, custom_id_for
+from src.stub_server import StubServer
+
+
+WINDOWS = [
+    (0, ["01-06 10:15:23.456  1234  1235 I AudioFlinger: Track started"]),
+    (1, ["01-06 10:15:30.100  1234  1236 D AudioFlinger: stream MUSIC muted"]),
+]
+
+
+def state_responder(payload):
+    """Answer PLAYING or MUTED depending on the window content."""
+    content = payload["messages"][1]["content"]
+    state = "MUTED" if "muted" in content else "PLAYING"
+    return {
+        "final_state": state,
+        "confidence": 0.9,
+        "reason": f"Stub {state}",
+        "evidence": [],
+        "next_actions": []
+    }
+
+
+@pytest.fixture
+def server():
+    with StubServer(responder=state_responder, batch_polls_until_complete=3) as stub:
+        yield stub
+
+
+def make_runner(server, tmp_path, **kwargs):
+    client = BailianClient(api_key="test-key", base_url=server.base_url)
+    return BatchRunner(client, tmp_path, poll_interval=0, **kwargs)
+
+
+def test_write_batch_file(tmp_path):
+    """Test that each window becomes one JSONL request line."""
+    client = BailianClient(api_key="test-key")
+    runner = BatchRunner(client, tmp_path)
+
+    path, fingerprint = runner.write_batch_file("System prompt", WINDOWS)
+    lines = [json.loads(line) for line in path.read_text().splitlines()]
+
+    assert len(lines) == 2
+    assert lines[0]["custom_id"] == custom_id_for(0)
+    assert lines[0]["url"] == "/v1/chat/completions"
+    assert lines[0]["body"]["messages"][0]["content"] == "System prompt"
+    assert len(fingerprint) == 64
+
+
+def test_run_batch_end_to_end(server, tmp_path):
+    """Test submitting, polling and mapping results back to windows."""
+    runner = make_runner(server, tmp_path)
+    statuses = []
+
+    results = runner.run("System prompt", WINDOWS, on_status=lambda b: statuses.append(b["status"]))
+
+    assert [r["window_idx"] for r in results] == [0, 1]
+    assert results[0]["final_state"] == "PLAYING"
+    assert results[1]["final_state"] == "MUTED"
+    assert statuses[-1] == "completed"
+    assert len(statuses) == 3
+
+
+def test_run_batch_resumes_saved_batch(server, tmp_path):
+    """Test that an interrupted run resumes polling the same batch."""
+    runner = make_runner(server, tmp_path, max_wait=0)
+
+    with pytest.raises(TimeoutError):
+        runner.run("System prompt", WINDOWS)
+
+    saved = json.loads((tmp_path / BATCH_STATE_FILE).read_text())
+    assert len(server.batches) == 1
+
+    results = make_runner(server, tmp_path).run("System prompt", WINDOWS)
+
+    # No second batch was submitted (没有提交第二个批处理)
+    assert len(server.batches) == 1
+    assert saved["batch_id"] in server.batches
+    assert results[1]["final_state"] == "MUTED"
+
+
+def test_run_batch_resubmits_on_changed_input(server, tmp_path):
+    """Test that changed windows invalidate the saved batch."""
+    make_runner(server, tmp_path).run("System prompt", WINDOWS)
+    make_runner(server, tmp_path).run("System prompt", WINDOWS[:1])
+
+    assert len(server.batches) == 2
+
+
+def test_collect_results_handles_failures(tmp_path):
+    """Test that missing, failed and invalid batch items become UNKNOWN."""
+    client = BailianClient(api_key="test-key")
+    runner = BatchRunner(client, tmp_path)
+    output = "\n".join([
+        json.dumps({"custom_id": "window-0", "response": {"status_code": 500, "body": {}}, "error": None}),
+        json.dumps({"custom_id": "window-1", "response": {"status_code": 200, "body": {
+            "choices": [{"message": {"content": "not json"}}]
+        }}, "error": None}),
+    ]).encode()
+
+    results = runner.collect_results(output, WINDOWS + [(2, ["line"])])
+
+    assert [r["final_state"] for r in results] == ["UNKNOWN"] * 3
+    assert "HTTP 500" in results[0]["reason"]
+    assert "not valid JSON" in results[1]["reason"]
+    assert "No result" in results[2]["reason"]
+
+
+def test_run_batch_resubmits_after_terminal_failure(server, tmp_path):
+    """Test a batch that ended failed is resubmitted instead of re-polled forever."""
+    with pytest.raises(TimeoutError):
+        make_runner(server, tmp_path, max_wait=0).run("System prompt", WINDOWS)
+    batch_id = next(iter(server.batches))
+    server.batches[batch_id]["status"] = "failed"
+
+    with pytest.raises(RuntimeError):
+        make_runner(server, tmp_path).run("System prompt", WINDOWS)
+    results = make_runner(server, tmp_path).run("System prompt", WINDOWS)
+
+    assert len(server.batches) == 2
+    assert [r["final_state"] for r in results] == ["PLAYING", "MUTED"]
+
+
+def test_run_batch_without_output_file(server, tmp_path):
+    """Test a completed batch with only an error file fails every window."""
+    with pytest.raises(TimeoutError):
+        make_runner(server, tmp_path, max_wait=0).run("System prompt", WINDOWS)
+    batch_id = next(iter(server.batches))
+    server.batches[batch_id].update({"status": "completed", "error_file_id": "file-errors"})
+
+    results = make_runner(server, tmp_path).run("System prompt", WINDOWS)
+
+    assert [r["final_state"] for r in results] == ["UNKNOWN", "UNKNOWN"]
+    assert "without an output file" in results[0]["error"]
+    # The next run submits a fresh batch (下次运行提交新的批处理)
+    make_runner(server, tmp_path).run("System prompt", WINDOWS)
+    assert len(server.batches) == 2
+
+
+@patch('src.batch.requests.get')
+def test_get_batch_retries_transient_errors(mock_get, tmp_path):
+    """Test status polls are retried with the client's retry settings."""
+    unavailable = Mock(status_code=503, headers={})
+    unavailable.raise_for_status.side_effect = requests.HTTPError(response=unavailable)
+    ok = Mock(status_code=200)
+    ok.json.return_value = {"id": "batch-1", "status": "in_progress"}
+    mock_get.side_effect = [requests.ConnectionError("reset"), unavailable, ok]
+    sleeps = []
+
+    client = BailianClient(api_key="test-key", max_retries=2, retry_backoff=0.01)
+    runner = BatchRunner(client, tmp_path, poll_interval=0, sleep=sleeps.append)
+
+    assert runner.get_batch("batch-1")["status"] == "in_progress"
+    assert len(sleeps) == 2
+
+    # A missing batch is not retried
+    missing = Mock(status_code=404, headers={})
+    missing.raise_for_status.side_effect = requests.HTTPError(response=missing)
+    mock_get.side_effect = [missing]
+    with pytest.raises(requests.HTTPError):
+        runner.get_batch("batch-1")
+    assert len(sleeps) == 2
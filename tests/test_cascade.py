@@ -0,0 +1,121 @@
+"""Tests for cascade module."""
+
+import pytest
+from src.bailian_client import BailianClient
+from src.cascade import CascadeRunner, TierStats, parse_tiers
+from src.metrics import summarize_usage
+from src.stub_server import StubServer
+
+
+def tiered_responder(payload):
+    """Cheap model is unsure about 'muted' windows; the strong model is always sure."""
+    content = payload["messages"][1]["content"]
+    state = "MUTED" if "muted" in content else "PLAYING"
+    confidence = 0.95
+    if payload["model"] == "cheap" and "muted" in content:
+        state, confidence = "UNKNOWN", 0.3
+    return {"final_state": state, "confidence": confidence, "reason": payload["model"],
+            "evidence": [], "next_actions": []}
+
+
+def make_runner(base_url, threshold=0.8):
+    stats = [TierStats("cheap"), TierStats("strong")]
+    clients = [BailianClient(api_key="k", base_url=base_url, model=s.model, recorder=s) for s in stats]
+    return CascadeRunner(clients, stats, threshold), stats
+
+
+def test_parse_tiers():
+    """Test tier specs with and without endpoints."""
+    assert parse_tiers("qwen-turbo, qwen-plus") == [("qwen-turbo", None), ("qwen-plus", None)]
+    assert parse_tiers("local@http://127.0.0.1:8000/v1,qwen-max") == [
+        ("local", "http://127.0.0.1:8000/v1"), ("qwen-max", None)
+    ]
+    with pytest.raises(ValueError):
+        parse_tiers(" , ")
+
+
+def test_cascade_escalates_low_confidence_and_neighbors():
+    """Test low-confidence windows and their disagreeing neighbors go to the strong tier."""
+    windows = [(0, ["playing"]), (1, ["playing"]), (2, ["playing"]), (3, ["muted"]), (4, ["muted"])]
+    
+    with StubServer(responder=tiered_responder) as stub:
+        runner, stats = make_runner(stub.base_url)
+        final = []
+        results = runner.run("SP", windows, on_final=final.append)
+    
+    assert [r["final_state"] for r in results] == ["PLAYING", "PLAYING", "PLAYING", "MUTED", "MUTED"]
+    assert [r["tier"] for r in results] == [0, 0, 1, 1, 1]
+    # Each window is reported once, when no higher tier will re-check it
+    assert [(r["window_idx"], r["tier"]) for r in final] == [(0, 0), (1, 0), (2, 1), (3, 1), (4, 1)]
+    # Escalated windows keep their tier-0 call, so every call is counted
+    assert [c["tier"] for c in results[3]["lower_tier_calls"]] == [0]
+    usage = summarize_usage(results)
+    assert usage["calls"] == 8
+    assert usage["by_model"]["cheap"]["calls"] == 5
+    assert results[3]["model"] == "strong"
+    assert stats[0].calls == 5
+    assert stats[1].calls == 3
+    
+    summary = stats[1].to_dict()
+    assert summary["latency_s"]["count"] == 3
+    assert summary["total_tokens"] > 0
+    assert summary["estimated_usage_calls"] == 3
+
+
+def test_cascade_stops_when_confident():
+    """Test no escalation happens when the cheap tier is confident and consistent."""
+    windows = [(0, ["playing"]), (1, ["playing"])]
+    
+    with StubServer(responder=tiered_responder) as stub:
+        runner, stats = make_runner(stub.base_url)
+        results = runner.run("SP", windows)
+    
+    assert [r["tier"] for r in results] == [0, 0]
+    assert stats[1].calls == 0
+
+
+def test_cascade_compares_analyzed_neighbors_across_gaps():
+    """Test neighbors are the previous and next analyzed windows, not adjacent indices."""
+    windows = [(0, ["playing"]), (5, ["playing"]), (9, ["muted"])]
+    
+    def sure(payload):
+        result = tiered_responder(dict(payload, model="strong"))
+        result["reason"] = payload["model"]
+        return result
+    
+    with StubServer(responder=sure) as stub:
+        runner, stats = make_runner(stub.base_url)
+        results = runner.run("SP", windows)
+    
+    # Windows 5 and 9 disagree although windows 6-8 lie between them
+    assert [r["tier"] for r in results] == [0, 1, 1]
+    assert stats[1].calls == 2
+
+
+def test_tier_stats_uses_usage_block_and_forwards():
+    """Test reported usage is preferred over the local estimate and calls are forwarded."""
+    forwarded = []
+    stats = TierStats("m", forward=lambda *args: forwarded.append(args))
+    
+    stats({"messages": []}, {"choices": [], "usage": {"prompt_tokens": 100, "completion_tokens": 20}}, 0.5)
+    
+    assert stats.to_dict()["total_tokens"] == 120
+    assert stats.estimated_calls == 0
+    assert len(forwarded) == 1
+
+
+def test_cascade_keeps_lower_tier_on_failure():
+    """Test a failed escalation keeps the lower tier's verdict."""
+    def responder(payload):
+        if payload["model"] == "strong":
+            raise RuntimeError("down")
+        return {"final_state": "PLAYING", "confidence": 0.5, "reason": "cheap", "evidence": [], "next_actions": []}
+    
+    with StubServer(responder=responder) as stub:
+        runner, stats = make_runner(stub.base_url)
+        results = runner.run("SP", [(0, ["x"])])
+    
+    assert results[0]["final_state"] == "PLAYING"
+    assert results[0]["tier"] == 0
+    assert "escalation_error" in results[0]
+    assert stats[1].failures == 1
@@ -0,0 +1,52 @@
+"""Tests for chaos module."""
+
+import random
+import pytest
+from src.chaos import FaultRule, run_scenario, synthetic_windows, SCENARIOS
+
+
+def test_fault_rule_burst_schedule():
+    """Test burst rules fire for the first `length` requests of each period."""
+    rule = FaultRule("rate_limit", period=10, length=3)
+    rng = random.Random(0)
+    
+    fired = [n for n in range(25) if rule.fires(n, rng)]
+    
+    assert fired == [0, 1, 2, 10, 11, 12, 20, 21, 22]
+
+
+def test_fault_rule_rejects_unknown_kind():
+    """Test that unknown fault kinds are rejected."""
+    with pytest.raises(ValueError, match="Unknown fault kind"):
+        FaultRule("meteor_strike")
+
+
+@pytest.mark.parametrize("kind,error", [
+    ("rate_limit", "HTTPError"),
+    ("server_error", "HTTPError"),
+    ("truncated", "ChunkedEncodingError"),
+    ("malformed", "JSONDecodeError"),
+])
+def test_faults_lose_windows_without_retries(kind, error, monkeypatch):
+    """Test each fault kind loses windows when the client does not retry."""
+    monkeypatch.setitem(SCENARIOS, "test", [FaultRule(kind, period=4, length=1, retry_after=0)])
+    
+    report = run_scenario("test", synthetic_windows(8, 2), concurrency=4, base_latency=0)
+    
+    assert report["lost_windows"] == 2
+    assert report["faults_injected"] == {kind: 2}
+    assert error in report["errors"]
+
+
+def test_retries_recover_from_faults(monkeypatch):
+    """Test that client retries absorb injected faults."""
+    monkeypatch.setitem(SCENARIOS, "test", [
+        FaultRule("rate_limit", period=6, length=1, retry_after=0),
+        FaultRule("server_error", period=6, length=2),
+        FaultRule("truncated", period=6, length=3),
+    ])
+    
+    report = run_scenario("test", synthetic_windows(12, 2), concurrency=4, max_retries=4, base_latency=0)
+    
+    assert report["lost_windows"] == 0
+    assert report["requests_served"] > 12
@@ -118,3 +118,37 @@ def test_chunk_large_overlap():
     assert windows[0][1] == ["L1", "L2", "L3", "L4", "L5"]
     assert windows[1][1] == ["L2", "L3", "L4", "L5", "L6"]
     assert windows[2][1] == ["L3", "L4", "L5", "L6", "L7"]
+
+
+def test_window_spans_match_chunk_lines():
+    """Test window_spans returns the line ranges of chunk_lines windows."""
+    lines = [f"L{i}" for i in range(23)]
+    for chunk_size, overlap in [(5, 2), (10, 0), (5, 4), (30, 10)]:
+        chunker = LogChunker(chunk_size=chunk_size, overlap=overlap)
+        windows = chunker.chunk_lines(lines)
+        spans = chunker.window_spans(len(lines))
+        
+        assert [(idx, lines[start:end]) for idx, start, end in spans] == windows
+    
+    assert LogChunker(5, 2).window_spans(0) == []
+
+
+def test_iter_windows_matches_chunk_lines():
+    """Test iter_windows yields the same windows as chunk_lines, lazily."""
+    for count in range(0, 30):
+        lines = [f"L{i}" for i in range(count)]
+        for chunk_size, overlap in [(5, 2), (10, 0), (5, 4), (1, 0), (30, 10)]:
+            chunker = LogChunker(chunk_size=chunk_size, overlap=overlap)
+            assert list(chunker.iter_windows(iter(lines))) == chunker.chunk_lines(lines)
+    
+    # The first window is available before the input is exhausted
+    consumed = []
+    
+    def source():
+        for i in range(100):
+            consumed.append(i)
+            yield f"L{i}"
+    
+    first = next(LogChunker(chunk_size=5, overlap=2).iter_windows(source()))
+    assert first == (0, ["L0", "L1", "L2", "L3", "L4"])
+    assert len(consumed) <= 6
@@ -7,6 +7,8 @@ import shutil
 from pathlib import Path
 from unittest.mock import patch, Mock
 from src.cli import analyze_command
+from src.debug_archive import ArchiveReader
+from src.journal import JOURNAL_NAME, ResultJournal
 
 
 def create_mock_response(state="PLAYING", confidence=0.9):
@@ -83,8 +85,29 @@ def test_cli_full_workflow(mock_post):
         assert "merged_segments" in report
         
         # Verify Markdown report
+        assert report["metadata"]["usage"]["calls"] == 1
+        assert report["metadata"]["execution_mode"] == "online"
+        assert report["window_results"][0]["usage"]["estimated"] is True
+        
         md_content = (out_dir / "report.md").read_text()
         assert "# Audio State Analysis Report" in md_content
+        assert "## Usage and Cost" in md_content
+        
+        # Line-level timeline with the times of its first and last lines
+        entries = report["line_timeline"]["entries"]
+        assert [(e["state"], e["start_line"], e["end_line"]) for e in entries] == [("PLAYING", 0, 2)]
+        assert entries[0]["start_time"] == "01-06 10:15:23.456"
+        assert entries[0]["end_time"] == "01-06 10:15:23.458"
+        assert "## State Timeline" in md_content
+        
+        # Segments report their real time range and source lines
+        segment = report["merged_segments"][0]
+        assert segment["start_time"] == "01-06 10:15:23.456"
+        assert segment["end_time"] == "01-06 10:15:23.458"
+        assert segment["duration_s"] == 0.002
+        assert segment["source"]["first_line"] == 1
+        assert segment["source"]["last_line"] == 3
+        assert segment["evidence_positions"] == [None, None]
         
     finally:
         # Cleanup
@@ -117,13 +140,13 @@ def test_cli_with_debug_mode(mock_post):
         
         assert result == 0
         
-        # Verify debug files exist
+        # Verify the debug archive holds the window's exchange
         debug_dir = out_dir / "debug"
-        assert debug_dir.exists()
-        
-        # Should have request and response files
-        debug_files = list(debug_dir.glob("*.json"))
-        assert len(debug_files) >= 2  # At least one request and one response
+        reader = ArchiveReader(debug_dir)
+        exchange = reader.exchanges(0)[0]
+        assert exchange["parsed_result"]["final_state"] == "PLAYING"
+        assert exchange["request"]["headers"]["Authorization"] == "[REDACTED]"
+        assert exchange["request"]["payload"]["messages"][0]["content"].startswith("#")
         
     finally:
         shutil.rmtree(temp_dir)
@@ -214,3 +237,776 @@ def test_cli_without_api_key():
         
     finally:
         shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_dry_run(mock_post):
+    """Test --dry-run projects the run without an API key or any request."""
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 V AudioFlinger: write() {i} bytes" for i in range(25)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 10
+            overlap = 0
+            model = "qwen-max"
+            debug = False
+            mask = False
+            dry_run = True
+        
+        with patch.dict('os.environ', {}, clear=True):
+            result = analyze_command(Args())
+        
+        assert result == 0
+        mock_post.assert_not_called()
+        assert not (out_dir / "report.json").exists()
+        
+        with open(out_dir / "dry_run.json") as f:
+            projection = json.load(f)
+        assert projection["model"] == "qwen-max"
+        assert projection["calls"] == 3
+        assert projection["total_lines"] == 25
+        assert projection["estimated_cost"] > 0
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_trace(mock_post):
+    """Test --trace writes stage and window spans as Chrome trace JSON."""
+    mock_post.return_value = create_mock_response()
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    trace_file = Path(temp_dir) / "trace.json"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 V AudioFlinger: write() {i} bytes" for i in range(15)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(Path(temp_dir) / "output")
+            chunk_size = 10
+            overlap = 0
+            model = "qwen-plus"
+            debug = False
+            mask = True
+            trace = str(trace_file)
+        
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            result = analyze_command(Args())
+        
+        assert result == 0
+        with open(trace_file) as f:
+            events = json.load(f)["traceEvents"]
+        names = [e["name"] for e in events]
+        for stage in ("analyze", "parse_file", "filter_audio_lines", "mask_lines", "chunk_lines",
+                      "analyze_windows", "merge_windows", "write_report_json", "write_report_md"):
+            assert stage in names
+        windows = [e for e in events if e["name"] == "window"]
+        assert [w["args"]["window"] for w in windows] == [0, 1]
+        assert names.count("queue_wait") == 2
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+def test_cli_batch_mode():
+    """Test CLI batch mode against the local stand-in server."""
+    from src.stub_server import StubServer
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 I AudioFlinger: Track started {i}" for i in range(25)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 10
+            overlap = 2
+            model = "qwen-plus"
+            debug = True
+            mask = False
+            batch = True
+            batch_poll_interval = 0
+        
+        with StubServer() as stub:
+            with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key', 'BAILIAN_BASE_URL': stub.base_url}):
+                result = analyze_command(Args())
+        
+        assert result == 0
+        assert (out_dir / "batch_state.json").exists()
+        
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        
+        assert report["metadata"]["execution_mode"] == "batch"
+        assert [r["window_idx"] for r in report["window_results"]] == [0, 1, 2]
+        _, journaled = ResultJournal(out_dir / JOURNAL_NAME).load()
+        assert sorted(journaled) == [0, 1, 2]
+        assert sorted(ArchiveReader(out_dir / "debug").windows) == [0, 1, 2]
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_packed_mode_falls_back(mock_post):
+    """Test packed mode falls back to single-window requests on an invalid pack."""
+    packed_invalid = Mock()
+    packed_invalid.status_code = 200
+    packed_invalid.json.return_value = {"choices": [{"message": {"content": json.dumps({"results": []})}}]}
+    mock_post.side_effect = [packed_invalid, create_mock_response(), create_mock_response("MUTED")]
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 I AudioFlinger: Track started {i}" for i in range(15)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 10
+            overlap = 2
+            model = "qwen-plus"
+            debug = False
+            mask = False
+            pack = 4
+            pack_max_tokens = 6000
+        
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            result = analyze_command(Args())
+        
+        assert result == 0
+        assert mock_post.call_count == 3
+        
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        
+        assert [r["final_state"] for r in report["window_results"]] == ["PLAYING", "MUTED"]
+        assert report["metadata"]["pack_size"] == 4
+        assert report["metadata"]["execution_mode"] == "pack"
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_prefilter_skips_obvious_windows(mock_post):
+    """Test the pre-classifier decides obvious windows and escalates the rest."""
+    mock_post.return_value = create_mock_response("UNKNOWN", 0.4)
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            [f"01-06 10:15:23.{i:03d}  1234  1235 I AudioFlinger: Track started {i}" for i in range(10)] +
+            [f"01-06 10:15:24.{i:03d}  1234  1235 D AudioSystem: getOutput() stream=MUSIC" for i in range(10)]
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 10
+            overlap = 0
+            model = "qwen-plus"
+            debug = False
+            mask = False
+            prefilter = True
+            prefilter_threshold = 0.85
+        
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            result = analyze_command(Args())
+        
+        assert result == 0
+        assert mock_post.call_count == 1
+        
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        
+        assert [r["window_idx"] for r in report["window_results"]] == [0, 1]
+        assert [r["decided_by"] for r in report["window_results"]] == ["heuristic", "llm"]
+        assert report["metadata"]["locally_decided_windows"] == [0]
+        assert report["summary"]["decided_locally"] == 1
+        assert "Decided Locally" in (out_dir / "report.md").read_text()
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_engine_cross_check(mock_post):
+    """Test --engine writes a timeline and cross-checks window results."""
+    mock_post.return_value = create_mock_response("MUTED")
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 I AudioFlinger: Track started {i}" for i in range(10)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 10
+            overlap = 0
+            model = "qwen-plus"
+            debug = False
+            mask = False
+            engine = True
+        
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            result = analyze_command(Args())
+        
+        assert result == 0
+        assert (out_dir / "timeline.json").exists()
+        
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        
+        assert report["window_results"][0]["engine_state"] == "PLAYING"
+        assert report["summary"]["engine_cross_check"] == {"compared": 1, "agreements": 0, "disagreements": [0]}
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+def test_cli_cascade_mode():
+    """Test CLI cascade mode reports per-tier statistics."""
+    from src.stub_server import StubServer
+    
+    def responder(payload):
+        confidence = 0.5 if payload["model"] == "qwen-turbo" else 0.95
+        return {"final_state": "PLAYING", "confidence": confidence, "reason": payload["model"],
+                "evidence": [], "next_actions": []}
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 I AudioFlinger: Track started {i}" for i in range(20)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 10
+            overlap = 0
+            model = "qwen-plus"
+            debug = True
+            mask = False
+            cascade = "qwen-turbo,qwen-plus"
+            cascade_threshold = 0.8
+        
+        with StubServer(responder=responder) as stub:
+            with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key', 'BAILIAN_BASE_URL': stub.base_url}):
+                result = analyze_command(Args())
+        
+        assert result == 0
+        
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        
+        assert [r["model"] for r in report["window_results"]] == ["qwen-plus", "qwen-plus"]
+        assert [t["calls"] for t in report["metadata"]["tier_stats"]] == [2, 2]
+        assert report["metadata"]["execution_mode"] == "cascade"
+        assert "## Model Tiers" in (out_dir / "report.md").read_text()
+        
+        # Only the final verdicts are journaled
+        _, journaled = ResultJournal(out_dir / JOURNAL_NAME).load()
+        assert [journaled[i]["model"] for i in sorted(journaled)] == ["qwen-plus", "qwen-plus"]
+        # Every tier's exchange is archived (每个层级的交互都被归档)
+        exchanges = ArchiveReader(out_dir / "debug").exchanges(0)
+        assert [e["request"]["payload"]["model"] for e in exchanges] == ["qwen-turbo", "qwen-plus"]
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_rejects_combined_execution_modes(mock_post, capsys):
+    """Test two execution modes are refused before anything is sent."""
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    
+    try:
+        log_file.write_text("01-06 10:15:23.000  1234  1235 I AudioFlinger: Track started")
+        
+        class Args:
+            log = str(log_file)
+            out = str(Path(temp_dir) / "output")
+            chunk_size = 10
+            overlap = 0
+            model = "qwen-plus"
+            debug = False
+            mask = False
+            search = True
+            pack = 4
+        
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            assert analyze_command(Args()) == 1
+        
+        assert "--search and --pack cannot be combined" in capsys.readouterr().err
+        
+        # --stream would be ignored by the other modes (其他模式会忽略--stream)
+        Args.search = False
+        Args.stream = True
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            assert analyze_command(Args()) == 1
+        assert "--stream cannot be combined with --pack" in capsys.readouterr().err
+        mock_post.assert_not_called()
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_dedup_reuses_results(mock_post):
+    """Test near-duplicate windows reuse earlier results instead of new calls."""
+    mock_post.return_value = create_mock_response()
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 V AudioFlinger: obtainBuffer() success, size {i}" for i in range(30)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 10
+            overlap = 0
+            model = "qwen-plus"
+            debug = False
+            mask = False
+            dedup = True
+            dedup_threshold = 0.9
+        
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            result = analyze_command(Args())
+        
+        assert result == 0
+        assert mock_post.call_count == 1
+        
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        
+        assert [r.get("inferred", False) for r in report["window_results"]] == [False, True, True]
+        assert report["metadata"]["dedup"]["calls_avoided"] == 2
+        assert report["summary"]["inferred_windows"] == 2
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_serialize(mock_post):
+    """Test --serialize sends serialized windows and records it in metadata."""
+    mock_post.return_value = create_mock_response()
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 V AudioFlinger: write() {i} bytes" for i in range(5)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 10
+            overlap = 0
+            model = "qwen-plus"
+            debug = False
+            mask = False
+            serialize = True
+        
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            result = analyze_command(Args())
+        
+        assert result == 0
+        user_message = mock_post.call_args[1]['json']['messages'][1]['content']
+        assert "# tags: AF=AudioFlinger" in user_message
+        assert "+4 V AF: write() 4 bytes" in user_message
+        
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        assert report["metadata"]["serialized_windows"] is True
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_transition_search(mock_post):
+    """Test --search analyzes only sampled windows and fills the rest."""
+    mock_post.return_value = create_mock_response()
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 I AudioFlinger: Track started {i}" for i in range(50)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 5
+            overlap = 0
+            model = "qwen-plus"
+            debug = True
+            mask = False
+            search = True
+            search_stride = 4
+        
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            result = analyze_command(Args())
+        
+        assert result == 0
+        assert mock_post.call_count == 4
+        
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        
+        assert len(report["window_results"]) == 10
+        assert report["metadata"]["transition_search"]["calls"] == 4
+        assert report["metadata"]["execution_mode"] == "search"
+        assert len(report["merged_segments"]) == 1
+        
+        # Analyzed windows are journaled, inferred ones are not
+        _, journaled = ResultJournal(out_dir / JOURNAL_NAME).load()
+        assert sorted(journaled) == [0, 4, 8, 9]
+        assert sorted(ArchiveReader(out_dir / "debug").windows) == [0, 4, 8, 9]
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_budget_reports_gaps(mock_post):
+    """Test --max-calls analyzes the most salient windows and reports the rest as gaps."""
+    mock_post.return_value = create_mock_response("MUTED")
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        quiet = [f"01-06 10:15:23.{i:03d}  1234  1235 V AudioFlinger: obtainBuffer() success" for i in range(20)]
+        mute = ["01-06 10:15:30.050  1234  1236 D AudioManager: setStreamMute() stream=MUSIC muted=true"] * 5
+        log_file.write_text("\n".join(quiet[:10] + mute + quiet[10:]))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 5
+            overlap = 0
+            model = "qwen-plus"
+            debug = False
+            mask = False
+            max_calls = 1
+        
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            result = analyze_command(Args())
+        
+        assert result == 0
+        assert mock_post.call_count == 1
+        
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        
+        assert [r["window_idx"] for r in report["window_results"]] == [2]
+        assert report["metadata"]["budget"]["unanalyzed_gaps"] == [
+            {"start_window": 0, "end_window": 1, "window_count": 2},
+            {"start_window": 3, "end_window": 4, "window_count": 2},
+        ]
+        assert "## Unanalyzed Gaps" in (out_dir / "report.md").read_text()
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_max_cost_enforces_actual_spend(mock_post):
+    """Test --max-cost stops sending once the actual cost reaches it, leaving gaps."""
+    expensive = create_mock_response()
+    # Far more tokens than the estimate that selected the windows (远多于选择窗口时的估算)
+    expensive.json.return_value["usage"] = {"prompt_tokens": 5_000_000, "completion_tokens": 100}
+    mock_post.return_value = expensive
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 I AudioFlinger: Track started {i}" for i in range(25)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 5
+            overlap = 0
+            model = "qwen-plus"
+            debug = False
+            mask = False
+            max_cost = 1.0
+        
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            result = analyze_command(Args())
+        
+        assert result == 0
+        assert mock_post.call_count == 1
+        
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        
+        budget = report["metadata"]["budget"]
+        assert budget["selected_windows"] == 5
+        assert budget["actual_cost"] >= 1.0
+        assert budget["refused_requests"] == 4
+        assert [r["window_idx"] for r in report["window_results"]] == [0]
+        assert budget["unanalyzed_gaps"] == [{"start_window": 1, "end_window": 4, "window_count": 4}]
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+def test_cli_summarize():
+    """Test --summarize adds a whole-log diagnosis to the reports."""
+    from src.stub_server import StubServer
+    
+    def responder(payload):
+        if "Summary Reduction" in payload["messages"][0]["content"]:
+            return {"final_state": "PLAYING", "confidence": 0.9, "summary": "Steady playback",
+                    "transitions": [], "issues": ["None observed"]}
+        return {"final_state": "PLAYING", "confidence": 0.9, "reason": "Playing", "evidence": [], "next_actions": []}
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 I AudioFlinger: Track started {i}" for i in range(30)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 5
+            overlap = 0
+            model = "qwen-plus"
+            debug = False
+            mask = False
+            summarize = True
+            summary_fan_in = 4
+            summary_concurrency = 4
+        
+        with StubServer(responder=responder) as stub:
+            with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key', 'BAILIAN_BASE_URL': stub.base_url}):
+                result = analyze_command(Args())
+        
+        assert result == 0
+        assert (out_dir / "summary_tree.json").exists()
+        
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        
+        assert report["diagnosis"]["summary"] == "Steady playback"
+        assert report["diagnosis"]["last_window"] == 5
+        assert report["metadata"]["summary_levels"] == 2
+        # Six window calls plus three reduction calls (六次窗口调用加三次归约调用)
+        assert report["metadata"]["usage"]["calls"] == 9
+        assert "## Whole-Log Diagnosis" in (out_dir / "report.md").read_text()
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_resume_skips_journaled_windows(mock_post):
+    """Test --resume only analyzes windows missing from the journal and rebuilds the report."""
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 I AudioFlinger: Track {i} started" for i in range(6)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 2
+            overlap = 0
+            model = "qwen-plus"
+            debug = False
+            mask = False
+        
+        # The first run loses the connection after one window (首次运行在一个窗口后断开连接)
+        mock_post.side_effect = [create_mock_response(), ConnectionError("VPN dropped"),
+                                 ConnectionError("VPN dropped")]
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            assert analyze_command(Args()) == 0
+        assert (out_dir / "journal.jsonl").exists()
+        
+        mock_post.reset_mock()
+        mock_post.side_effect = None
+        mock_post.return_value = create_mock_response("MUTED")
+        Args.resume = True
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            assert analyze_command(Args()) == 0
+        
+        assert mock_post.call_count == 2
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        assert [r["final_state"] for r in report["window_results"]] == ["PLAYING", "MUTED", "MUTED"]
+        assert report["metadata"]["resumed_windows"] == 1
+        
+        # A journal for another model or prompt format is refused (拒绝不同模型或提示格式的日志)
+        Args.model = "qwen-max"
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            assert analyze_command(Args()) == 1
+        Args.model = "qwen-plus"
+        Args.compact = True
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            assert analyze_command(Args()) == 1
+        Args.compact = False
+        
+        # A journal for other chunk settings is refused (拒绝不同分块设置的日志)
+        Args.chunk_size = 3
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            assert analyze_command(Args()) == 1
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_jsonl_report(mock_post):
+    """Test --report-format jsonl writes a compressed JSONL report instead of report.json."""
+    from src.report_stream import ReportReader
+    mock_post.return_value = create_mock_response()
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 I AudioFlinger: Track {i} started" for i in range(4)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 2
+            overlap = 0
+            model = "qwen-plus"
+            debug = False
+            mask = False
+            report_format = "jsonl"
+            report_compression = "gzip"
+        
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            result = analyze_command(Args())
+        
+        assert result == 0
+        assert not (out_dir / "report.json").exists()
+        reader = ReportReader(out_dir / "report.jsonl.gz")
+        assert [r["window_idx"] for r in reader.windows()] == [0, 1]
+        assert reader.summary()["total_windows"] == 2
+        assert reader.metadata()["usage"]["calls"] == 2
+        assert reader.complete
+        assert (out_dir / "report.md").exists()
+        
+    finally:
+        shutil.rmtree(temp_dir)
+
+
+@patch('src.bailian_client.requests.post')
+def test_cli_pipeline(mock_post):
+    """Test --pipeline analyzes every window concurrently and writes the usual report."""
+    mock_post.return_value = create_mock_response()
+    
+    temp_dir = tempfile.mkdtemp()
+    log_file = Path(temp_dir) / "test.log"
+    out_dir = Path(temp_dir) / "output"
+    
+    try:
+        log_file.write_text("\n".join(
+            f"01-06 10:15:23.{i:03d}  1234  1235 I AudioFlinger: Track {i} started" for i in range(9)
+        ))
+        
+        class Args:
+            log = str(log_file)
+            out = str(out_dir)
+            chunk_size = 2
+            overlap = 0
+            model = "qwen-plus"
+            debug = False
+            mask = True
+            pipeline = True
+            workers = 3
+            queue_size = 2
+        
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            assert analyze_command(Args()) == 0
+        
+        assert mock_post.call_count == 5
+        with open(out_dir / "report.json") as f:
+            report = json.load(f)
+        assert [r["window_idx"] for r in report["window_results"]] == [0, 1, 2, 3, 4]
+        metadata = report["metadata"]
+        assert metadata["execution_mode"] == "pipeline"
+        assert metadata["total_lines"] == 9
+        assert metadata["pipeline"]["workers"] == 3
+        assert 1 <= metadata["pipeline"]["max_reorder_buffer"] <= 5
+        assert [seg["state"] for seg in report["merged_segments"]] == ["PLAYING"]
+        assert all(depth <= 2 for depth in metadata["pipeline"]["max_queue_depth"].values())
+        assert (out_dir / "journal.jsonl").exists()
+        
+        # Options that need every window up front are refused (拒绝需要预先获得全部窗口的选项)
+        Args.batch = True
+        with patch.dict('os.environ', {'BAILIAN_API_KEY': 'test-key'}):
+            assert analyze_command(Args()) == 1
+        
+    finally:
+        shutil.rmtree(temp_dir)
@@ -0,0 +1,59 @@
+"""Tests for compact module."""
+
+import json
+from src.compact import expand_compact_result, number_lines
+from src.tokens import estimate_tokens
+
+
+WINDOW = [
+    "01-06 10:15:30.050  1234  1236 D AudioManager: setStreamMute() stream=MUSIC muted=true",
+    "01-06 10:15:30.100  1234  1236 D AudioFlinger: stream MUSIC muted",
+    "01-06 10:15:30.200  1234  1236 D audio_hw: set_stream_mute(): mute=1",
+]
+
+
+def test_number_lines():
+    """Test that lines are numbered from 1."""
+    assert number_lines(["a", "b"]) == "1| a\n2| b"
+
+
+def test_expand_compact_result():
+    """Test short keys, state codes and evidence line numbers are expanded."""
+    result = expand_compact_result(
+        {"s": "M", "c": 0.9, "r": "Muted", "e": [2, "3"], "n": []},
+        WINDOW
+    )
+    
+    assert result["final_state"] == "MUTED"
+    assert result["confidence"] == 0.9
+    assert result["reason"] == "Muted"
+    assert result["evidence"] == [WINDOW[1], WINDOW[2]]
+    assert result["evidence_line_numbers"] == [2, 3]
+    assert result["next_actions"] == []
+
+
+def test_expand_compact_result_tolerates_full_schema():
+    """Test full keys, out-of-range numbers and text evidence."""
+    result = expand_compact_result(
+        {"final_state": "playing", "confidence": 0.5, "reason": "R",
+         "evidence": [0, 99, "free text"], "next_actions": []},
+        WINDOW
+    )
+    
+    assert result["final_state"] == "PLAYING"
+    assert result["evidence"] == ["free text"]
+    assert result["evidence_line_numbers"] == []
+
+
+def test_compact_output_is_several_times_smaller():
+    """Test that compact output costs several-fold fewer tokens than the full schema."""
+    full = {
+        "final_state": "MUTED",
+        "confidence": 0.9,
+        "reason": "Stream muted via setStreamMute",
+        "evidence": WINDOW * 2,
+        "next_actions": ["Check volume settings", "Verify audio routing"]
+    }
+    compact = {"s": "M", "c": 0.9, "r": "Stream muted via setStreamMute", "e": [1, 2, 3], "n": ["Check volume"]}
+    
+    assert estimate_tokens(json.dumps(full)) > 3 * estimate_tokens(json.dumps(compact))
@@ -0,0 +1,118 @@
+"""Tests for debug_archive module."""
+
+import gzip
+import json
+import threading
+
+import pytest
+from src import debug_archive
+from src.debug_archive import ARCHIVE_NAME, INDEX_NAME, ArchiveReader, DebugArchive, main
+
+
+URL = "https://example.com/v1/chat/completions"
+HEADERS = {"Authorization": "Bearer secret", "Content-Type": "application/json"}
+PROMPT = "You are an audio log analyst. " * 200
+
+
+def payload(log_content, prompt=PROMPT):
+    return {"model": "qwen-plus", "messages": [
+        {"role": "system", "content": prompt},
+        {"role": "user", "content": log_content}
+    ]}
+
+
+def result(state="PLAYING"):
+    return {"final_state": state, "confidence": 0.9, "reason": "Active", "evidence": [], "next_actions": []}
+
+
+def test_prompt_stored_once_and_restored(tmp_path):
+    """Test repeated system prompts are stored once and restored on extraction."""
+    archive = DebugArchive(tmp_path)
+    for window_idx in range(20):
+        archive.record([window_idx], URL, HEADERS, payload(f"line {window_idx}"), result(), 1)
+    archive.close()
+    
+    reader = ArchiveReader(tmp_path)
+    exchange = reader.exchanges(7)[0]
+    
+    assert len(reader.prompts) == 1
+    assert archive.records == 21
+    assert exchange["request"]["payload"]["messages"][0]["content"] == PROMPT
+    assert exchange["request"]["payload"]["messages"][1]["content"] == "line 7"
+    assert exchange["request"]["headers"]["Authorization"] == "[REDACTED]"
+    # Far smaller than twenty copies of the prompt (远小于提示词的二十份副本)
+    assert (tmp_path / ARCHIVE_NAME).stat().st_size < 20 * len(PROMPT) / 10
+
+
+def test_archive_is_one_gzip_stream(tmp_path):
+    """Test the archive decompresses as a whole into JSON Lines."""
+    archive = DebugArchive(tmp_path)
+    archive.record([0], URL, HEADERS, payload("a"), result(), 1)
+    archive.record([1], URL, HEADERS, payload("b", prompt="Other prompt"), result("MUTED"), 1)
+    archive.close()
+    
+    records = [json.loads(line) for line in gzip.open(tmp_path / ARCHIVE_NAME, 'rt', encoding='utf-8')]
+    
+    assert [r["type"] for r in records] == ["prompt", "exchange", "prompt", "exchange"]
+
+
+def test_packed_exchange_indexed_per_window(tmp_path):
+    """Test a packed request is written once and found from each of its windows."""
+    archive = DebugArchive(tmp_path)
+    archive.record([3, 4], URL, HEADERS, payload("packed"), {3: result(), 4: result("MUTED")})
+    archive.close()
+    
+    reader = ArchiveReader(tmp_path)
+    
+    assert archive.records == 2
+    assert reader.exchanges(3) == reader.exchanges(4)
+    assert reader.exchanges(4)[0]["parsed_result"]["4"]["final_state"] == "MUTED"
+    assert reader.exchanges(5) == []
+
+
+def test_result_mutated_after_record_is_archived_as_recorded(tmp_path):
+    """Test later changes to a result by the caller do not reach the archive."""
+    archive = DebugArchive(tmp_path)
+    window_result = result()
+    archive.record([0], URL, HEADERS, payload("a"), window_result, 1)
+    window_result["engine_state"] = "MUTED"
+    archive.close()
+    
+    assert "engine_state" not in ArchiveReader(tmp_path).exchanges(0)[0]["parsed_result"]
+
+
+def test_extract_cli(tmp_path, capsys):
+    """Test the extractor lists windows and prints one exchange."""
+    archive = DebugArchive(tmp_path)
+    archive.record([2], URL, HEADERS, payload("window two"), result(), 1)
+    archive.close()
+    
+    assert main([str(tmp_path), "--list"]) == 0
+    assert "1 windows" in capsys.readouterr().out
+    assert main([str(tmp_path), "--window", "2"]) == 0
+    assert json.loads(capsys.readouterr().out)["request"]["payload"]["messages"][1]["content"] == "window two"
+    assert main([str(tmp_path), "--window", "9"]) == 1
+    assert (tmp_path / INDEX_NAME).exists()
+
+
+def test_failed_writer_does_not_block_records(tmp_path, monkeypatch):
+    """Test a writer that died (e.g. disk full) drops records and close() raises its error."""
+    def disk_full(self, line, windows, prompt=None):
+        raise OSError(28, "No space left on device")
+    
+    monkeypatch.setattr(debug_archive.DebugArchive, "_append", disk_full)
+    archive = DebugArchive(tmp_path)
+    
+    def record_many():
+        for window_idx in range(debug_archive.QUEUE_SIZE * 3):
+            archive.record([window_idx], URL, HEADERS, payload("line"), result(), 1)
+    
+    thread = threading.Thread(target=record_many)
+    thread.start()
+    thread.join(timeout=10)
+    assert not thread.is_alive()
+    
+    with pytest.raises(OSError):
+        archive.close()
+    # Everything after the record that failed was dropped (失败记录之后的所有记录都被丢弃)
+    assert archive.dropped == debug_archive.QUEUE_SIZE * 3 - 1
@@ -0,0 +1,107 @@
+"""Tests for dedup module."""
+
+from src.dedup import DuplicateIndex, apply_reuse, jaccard, normalize_line, plan_reuse, shingles
+
+
+def playing_window(offset):
+    return [
+        f"01-06 10:15:{23 + offset:02d}.{i:03d}  1234  {1236 + offset} V AudioFlinger: "
+        f"obtainBuffer() success, buffer size: {4096 + i}, track 0x{0xb400 + offset:x}"
+        for i in range(50)
+    ] + [f"01-06 10:15:{23 + offset:02d}.999  1234  1236 D AudioFlinger: write() to track, {offset} bytes written"]
+
+
+MUTED_WINDOW = [
+    "01-06 10:15:30.050  1234  1236 D AudioManager: setStreamMute() stream=MUSIC muted=true",
+    "01-06 10:15:30.100  1234  1236 D AudioFlinger: stream MUSIC muted",
+]
+
+
+def test_normalize_line():
+    """Test prefix, hex and numbers are normalized."""
+    assert normalize_line(
+        "01-06 10:15:23.550  1234  1236 V AudioFlinger: thread 0xb4000071f3f18800 size: 4096, gain 0.5"
+    ) == "V AudioFlinger: thread <HEX> size: <N>, gain <N>"
+
+
+def test_normalize_keeps_state_values():
+    """Test values of state-bearing keys survive normalization."""
+    assert normalize_line(
+        "01-06 10:15:23.550  1234  1236 D AudioManager: setStreamMute() stream=3 mute=1 Volume: 0.0 size=4096"
+    ) == "D AudioManager: setStreamMute() stream=<N> mute=1 volume=0.0 size=<N>"
+
+
+def test_opposite_states_and_order_are_not_duplicates():
+    """Test windows differing only in mute/volume values or event order are not reused."""
+    common = [
+        f"01-06 10:15:23.{i:03d}  1234  1236 V AudioFlinger: obtainBuffer() success, buffer size: 4096"
+        for i in range(10)
+    ]
+    muted = common + [
+        "01-06 10:15:24.000  1234  1236 D AudioManager: setStreamMute() stream=MUSIC mute=1",
+        "01-06 10:15:24.100  1234  1236 D AudioManager: setStreamVolume() stream=MUSIC volume=0",
+    ]
+    unmuted = common + [
+        "01-06 10:15:24.000  1234  1236 D AudioManager: setStreamMute() stream=MUSIC mute=0",
+        "01-06 10:15:24.100  1234  1236 D AudioManager: setStreamVolume() stream=MUSIC volume=1.0",
+    ]
+    events = [
+        "01-06 10:15:24.000  1234  1236 I AudioFlinger: Track stopped",
+        "01-06 10:15:24.100  1234  1236 I AudioFlinger: Track started",
+    ]
+    
+    assert jaccard(shingles(muted), shingles(unmuted)) < 0.9
+    _, duplicates = plan_reuse([(0, muted), (1, unmuted), (2, common + events), (3, common + events[::-1])])
+    assert duplicates == {}
+
+
+def test_jaccard():
+    """Test Jaccard similarity of shingle sets."""
+    assert jaccard(frozenset("ab"), frozenset("bc")) == 1 / 3
+    assert jaccard(frozenset(), frozenset()) == 1.0
+
+
+def test_index_finds_near_duplicates_only():
+    """Test windows differing only in numbers match and different content does not."""
+    index = DuplicateIndex(threshold=0.9)
+    index.add(0, playing_window(0))
+    
+    assert index.find(playing_window(5)) == (0, 1.0)
+    assert index.find(MUTED_WINDOW) is None
+    assert index.find(playing_window(5) + MUTED_WINDOW) is None
+
+
+def test_threshold_controls_reuse():
+    """Test the similarity threshold decides whether a near-duplicate is reused."""
+    window = [f"AudioFlinger: event kind {chr(97 + i)}" for i in range(20)]
+    extended = window + ["AudioFlinger: one new event"]
+    
+    loose = DuplicateIndex(threshold=0.95)
+    loose.add(0, window)
+    strict = DuplicateIndex(threshold=0.96)
+    strict.add(0, window)
+    
+    assert loose.find(extended) == (0, 19 / 20)
+    assert strict.find(extended) is None
+
+
+def test_plan_and_apply_reuse():
+    """Test representatives are analyzed and duplicates inherit marked results."""
+    windows = [(0, playing_window(0)), (1, playing_window(1)), (2, MUTED_WINDOW), (3, playing_window(2))]
+    
+    representatives, duplicates = plan_reuse(windows)
+    
+    assert [idx for idx, _ in representatives] == [0, 2]
+    assert duplicates == {1: (0, 1.0), 3: (0, 1.0)}
+    
+    results = [
+        {"window_idx": 0, "final_state": "PLAYING", "confidence": 0.9},
+        {"window_idx": 2, "final_state": "MUTED", "confidence": 0.8},
+    ]
+    merged = apply_reuse(results, duplicates)
+    
+    assert [r["window_idx"] for r in merged] == [0, 1, 2, 3]
+    assert [r["final_state"] for r in merged] == ["PLAYING", "PLAYING", "MUTED", "PLAYING"]
+    assert merged[1]["inferred"] is True
+    assert merged[1]["reused_from"] == 0
+    assert "inferred" not in merged[0]
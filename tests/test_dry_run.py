@@ -0,0 +1,111 @@
+"""Tests for dry_run module."""
+
+import pytest
+from src.bailian_client import BailianClient
+from src.dry_run import format_duration, format_projection, payload_tokens, plan_requests, project
+from src.pricing import EXPECTED_COMPACT_OUTPUT_TOKENS, EXPECTED_OUTPUT_TOKENS, estimate_cost
+from src.tokens import MESSAGE_OVERHEAD_TOKENS, estimate_tokens
+
+
+WINDOWS = [
+    (i, [f"01-06 10:15:23.{i:03d}  1234  1235 D AudioFlinger: write() {i} bytes"] * 5)
+    for i in range(4)
+]
+
+
+def make_client(**kwargs):
+    """Client with a placeholder key; nothing is ever sent."""
+    return BailianClient(api_key="dry-run", **kwargs)
+
+
+def test_payload_tokens():
+    """Test every message counts its content plus the per-message overhead."""
+    payload = {"messages": [{"role": "system", "content": "abcd" * 10}, {"role": "user", "content": "ab"}]}
+    
+    assert payload_tokens(payload) == 10 + 1 + 2 * MESSAGE_OVERHEAD_TOKENS
+
+
+def test_plan_requests_single_windows():
+    """Test one request per window, built like the client builds it."""
+    client = make_client()
+    
+    requests = list(plan_requests(client, "System prompt", WINDOWS))
+    
+    assert [count for _, count in requests] == [1, 1, 1, 1]
+    assert requests[0][0] == client.build_payload("System prompt", "\n".join(WINDOWS[0][1]))
+
+
+def test_plan_requests_packed():
+    """Test packed requests cover several windows each."""
+    requests = list(plan_requests(make_client(), "System prompt", WINDOWS, pack=3))
+    
+    assert [count for _, count in requests] == [3, 1]
+
+
+def test_plan_requests_per_window_prompt():
+    """Test a per-window prompt function is used for each request."""
+    requests = plan_requests(
+        make_client(), "System prompt", WINDOWS[:1], prompt_fn=lambda lines: f"Prompt for {len(lines)} lines"
+    )
+    
+    assert next(requests)[0]["messages"][0]["content"] == "Prompt for 5 lines"
+
+
+def test_plan_requests_uses_serialized_windows():
+    """Test serialized windows make smaller requests."""
+    plain = sum(payload_tokens(p) for p, _ in plan_requests(make_client(), "S", WINDOWS))
+    serialized = sum(payload_tokens(p) for p, _ in plan_requests(make_client(serialize=True), "S", WINDOWS))
+    
+    assert serialized < plain
+
+
+def test_project_totals():
+    """Test calls, tokens and cost add up over the requests."""
+    requests = list(plan_requests(make_client(), "System prompt", WINDOWS))
+    
+    projection = project(requests, "qwen-plus")
+    
+    input_tokens = sum(payload_tokens(p) for p, _ in requests)
+    assert projection["calls"] == 4
+    assert projection["windows"] == 4
+    assert projection["input_tokens"] == input_tokens
+    assert projection["output_tokens"] == 4 * EXPECTED_OUTPUT_TOKENS
+    assert projection["estimated_cost"] == pytest.approx(
+        estimate_cost("qwen-plus", input_tokens, 4 * EXPECTED_OUTPUT_TOKENS), abs=1e-4
+    )
+
+
+def test_project_compact_and_rate_limit():
+    """Test compact responses are cheaper and the RPM override sets the time floor."""
+    requests = list(plan_requests(make_client(compact=True), "System prompt", WINDOWS))
+    
+    projection = project(requests, "qwen-plus", compact=True, rpm=2)
+    
+    assert projection["output_tokens"] == 4 * EXPECTED_COMPACT_OUTPUT_TOKENS
+    assert projection["rpm"] == 2
+    assert projection["rate_limit_floor_s"] == pytest.approx(120.0)
+
+
+def test_project_empty():
+    """Test no requests project to zero."""
+    projection = project([], "qwen-plus")
+    
+    assert projection["calls"] == 0
+    assert projection["estimated_cost"] == 0
+    assert projection["mean_prompt_tokens"] == 0
+
+
+def test_format_duration():
+    """Test durations are shown in the largest useful units."""
+    assert format_duration(42) == "42s"
+    assert format_duration(125) == "2m 05s"
+    assert format_duration(3723) == "1h 02m 03s"
+
+
+def test_format_projection():
+    """Test the printable projection names the model and cost."""
+    text = format_projection(project(plan_requests(make_client(), "S", WINDOWS), "qwen-max"))
+    
+    assert "qwen-max" in text
+    assert "¥" in text
+    assert "4 windows" in text
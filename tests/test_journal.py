@@ -0,0 +1,101 @@
+"""Tests for journal module."""
+
+import pytest
+from src.journal import JournalMismatch, ResultJournal, file_fingerprint, quick_fingerprint
+
+
+HEADER = {"fingerprint": "abc", "chunk_size": 200, "overlap": 50, "masking_enabled": False}
+
+
+def result(window_idx, state="PLAYING", **extra):
+    return {"window_idx": window_idx, "final_state": state, "confidence": 0.9, **extra}
+
+
+def test_resume_returns_completed_results(tmp_path):
+    """Test results written before an interruption are carried over on resume."""
+    path = tmp_path / "journal.jsonl"
+    journal = ResultJournal(path)
+    assert journal.start(HEADER) == {}
+    journal.append(result(0))
+    journal.append(result(1, "UNKNOWN", error="timeout"))
+    journal.close()
+    # A write cut short by a crash leaves a partial line (崩溃中断的写入留下不完整行)
+    with open(path, 'a', encoding='utf-8') as f:
+        f.write('{"type": "result", "result": {"window_idx": 2, "fin')
+    
+    resumed = ResultJournal(path)
+    completed = resumed.start(dict(HEADER), resume=True)
+    resumed.append(result(1, "MUTED"))
+    resumed.close()
+    
+    # Failed windows are retried, not carried over (失败的窗口会重试而不是沿用)
+    assert list(completed) == [0]
+    _, reloaded = ResultJournal(path).load()
+    assert reloaded[1]["final_state"] == "MUTED"
+
+
+def test_resume_rejects_changed_settings(tmp_path):
+    """Test a journal is not resumed for another input or chunking."""
+    path = tmp_path / "journal.jsonl"
+    journal = ResultJournal(path)
+    journal.start(HEADER)
+    journal.close()
+    
+    with pytest.raises(JournalMismatch, match="chunk_size"):
+        ResultJournal(path).start(dict(HEADER, chunk_size=100), resume=True)
+
+
+def test_resume_names_fingerprint_scheme_change(tmp_path):
+    """Test resuming with another fingerprint scheme says which schemes differ."""
+    path = tmp_path / "journal.jsonl"
+    journal = ResultJournal(path)
+    journal.start(dict(HEADER, fingerprint="quick:abc", fingerprint_scheme="quick"))
+    journal.close()
+    
+    with pytest.raises(JournalMismatch, match="quick scheme.*sha256 scheme.*with --pipeline"):
+        ResultJournal(path).start(dict(HEADER, fingerprint_scheme="sha256"), resume=True)
+    # Older headers without the field are told apart by the prefix
+    with pytest.raises(JournalMismatch, match="quick scheme"):
+        ResultJournal(path).start(dict(HEADER), resume=True)
+
+
+def test_start_without_resume_discards_old_journal(tmp_path):
+    """Test a fresh run starts a new journal."""
+    path = tmp_path / "journal.jsonl"
+    journal = ResultJournal(path)
+    journal.start(HEADER)
+    journal.append(result(0))
+    journal.close()
+    
+    journal = ResultJournal(path)
+    assert journal.start(dict(HEADER, fingerprint="other")) == {}
+    journal.close()
+    
+    header, completed = journal.load()
+    assert header["fingerprint"] == "other"
+    assert completed == {}
+
+
+def test_file_fingerprint(tmp_path):
+    """Test the fingerprint follows the file contents."""
+    path = tmp_path / "a.log"
+    path.write_text("one")
+    first = file_fingerprint(str(path), block_size=2)
+    path.write_text("two")
+    
+    assert first != file_fingerprint(str(path))
+    assert len(first) == 64
+
+
+def test_quick_fingerprint(tmp_path):
+    """Test the quick fingerprint tracks size and ends of the file."""
+    path = tmp_path / "a.log"
+    path.write_bytes(b"x" * 5000)
+    first = quick_fingerprint(str(path), sample=1024)
+    
+    assert first.startswith("quick:")
+    assert quick_fingerprint(str(path), sample=1024) == first
+    path.write_bytes(b"x" * 4999 + b"y")
+    assert quick_fingerprint(str(path), sample=1024) != first
+    path.write_bytes(b"x" * 5001)
+    assert quick_fingerprint(str(path), sample=1024) != first
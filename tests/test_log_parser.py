@@ -127,3 +127,52 @@ def test_word_boundary_matching():
     # Only the first line should match (word boundary)
     assert len(filtered) == 1
     assert filtered[0] == lines[0]
+
+
+def test_iter_audio_lines_matches_parse_and_filter():
+    """Test iter_audio_lines streams the lines parse_and_filter returns."""
+    with tempfile.NamedTemporaryFile(mode='w', delete=False, suffix='.log') as f:
+        for i in range(50):
+            tag = "AudioFlinger" if i % 3 else "SystemUI"
+            f.write(f"01-06 10:15:{i:02d}.000  1234  1235 D {tag}: event {i}\n")
+        f.write("01-06 10:16:00.000  1234  1235 D AudioTrack: no trailing newline")
+        temp_path = f.name
+    
+    try:
+        parser = LogParser(audio_tags=["AudioFlinger", "AudioTrack"])
+        assert list(parser.iter_audio_lines(temp_path)) == parser.parse_and_filter(temp_path)
+    finally:
+        os.unlink(temp_path)
+
+
+def test_parse_file_with_provenance():
+    """Test provenance rows point at each retained line's bytes and original line number."""
+    data = ("01-06 10:15:23.456  1234  1235 I AudioFlinger: Track started\r\n"
+            "\n"
+            "01-06 10:15:23.500  1234  1235 D SystemUI: 音量 panel\n"
+            "   \n"
+            "01-06 10:15:24.000  1234  1235 I AudioTrack: stop").encode("utf-8")
+    with tempfile.NamedTemporaryFile(mode='wb', delete=False, suffix='.log') as f:
+        f.write(data)
+        temp_path = f.name
+    
+    try:
+        parser = LogParser(audio_tags=["AudioFlinger", "AudioTrack"])
+        lines, provenance = parser.parse_file_with_provenance(temp_path)
+        assert lines == parser.parse_file(temp_path)
+        assert list(provenance.line_numbers) == [1, 3, 5]
+        for i, line in enumerate(lines):
+            offset = provenance.offsets[i]
+            assert data[offset:].decode("utf-8").startswith(line)
+        
+        lines, provenance = parser.filter_with_provenance(lines, provenance)
+        assert lines == parser.parse_and_filter(temp_path)
+        assert list(provenance.line_numbers) == [1, 5]
+        assert provenance.position(1) == {
+            "file": temp_path,
+            "byte_offset": data.index(b"01-06 10:15:24.000"),
+            "line_number": 5,
+            "timestamp": "01-06 10:15:24.000"
+        }
+    finally:
+        os.unlink(temp_path)
@@ -0,0 +1,72 @@
+"""Tests for metrics module."""
+
+import pytest
+from src.metrics import percentile, summarize_latencies, summarize_usage
+from src.pricing import estimate_cost
+
+
+def test_percentile_interpolates():
+    """Test linear interpolation between ranks."""
+    values = [1, 2, 3, 4]
+    
+    assert percentile(values, 0) == 1
+    assert percentile(values, 100) == 4
+    assert percentile(values, 50) == 2.5
+    assert percentile([], 50) == 0.0
+
+
+def test_summarize_latencies():
+    """Test latency summary fields."""
+    summary = summarize_latencies([0.1, 0.2, 0.3, 0.4, 10.0])
+    
+    assert summary["count"] == 5
+    assert summary["p50"] == 0.3
+    assert summary["max"] == 10.0
+    assert summary["p99"] > summary["p95"] > summary["p50"]
+
+
+def usage_result(call_id, prompt, completion, model="qwen-plus", latency=1.0, **extra):
+    result = {
+        "model": model,
+        "usage": {"prompt_tokens": prompt, "completion_tokens": completion, "cached_tokens": 0, "estimated": False},
+        "latency_s": latency,
+        "retries": 0,
+        "call_id": call_id
+    }
+    result.update(extra)
+    return result
+
+
+def test_summarize_usage():
+    """Test usage totals count shared calls once and skip inferred windows."""
+    results = [
+        usage_result(1, 500, 50, latency=1.0),
+        usage_result(2, 300, 40, latency=2.0, shared_by=2),
+        usage_result(2, 300, 40, latency=2.0, shared_by=2),
+        usage_result(1, 2000, 100, model="qwen-max", latency=4.0, retries=2),
+        usage_result(1, 500, 50, inferred=True),
+        {"final_state": "UNKNOWN", "error": "timeout"},
+    ]
+    
+    usage = summarize_usage(results)
+    
+    assert usage["calls"] == 3
+    assert usage["prompt_tokens"] == 500 + 600 + 2000
+    assert usage["completion_tokens"] == 50 + 80 + 100
+    assert usage["retries"] == 2
+    assert usage["latency_s"]["count"] == 3
+    assert usage["latency_s"]["p50"] == 2.0
+    assert usage["by_model"]["qwen-plus"]["calls"] == 2
+    assert usage["by_model"]["qwen-max"]["cost_cny"] == pytest.approx(estimate_cost("qwen-max", 2000, 100))
+    assert usage["cost_cny"] == pytest.approx(
+        estimate_cost("qwen-plus", 1100, 130) + estimate_cost("qwen-max", 2000, 100), abs=1e-6
+    )
+
+
+def test_summarize_usage_empty():
+    """Test a run without calls reports zeros."""
+    usage = summarize_usage([])
+    
+    assert usage["calls"] == 0
+    assert usage["cost_cny"] == 0
+    assert usage["by_model"] == {}
@@ -0,0 +1,216 @@
+"""Tests for pipeline module."""
+
+import threading
+import time
+
+import pytest
+from src.analyzer import WindowAnalyzer
+from src.chunker import LogChunker
+from src.log_parser import LogParser
+from src.masker import DataMasker
+from src.pipeline import Pipeline
+from src.tracing import Tracer
+
+
+def write_log(tmp_path, count, extra=""):
+    path = tmp_path / "audio.log"
+    with open(path, 'w', encoding='utf-8') as f:
+        for i in range(count):
+            f.write(f"01-06 10:15:{i % 60:02d}.000  1234  1235 D AudioFlinger: event {i}{extra}\n")
+            f.write(f"01-06 10:15:{i % 60:02d}.001  1234  1235 D SystemUI: noise {i}\n")
+    return path
+
+
+def echo(window_idx, window_lines):
+    return {"window_idx": window_idx, "final_state": "PLAYING", "lines": list(window_lines)}
+
+
+def test_results_match_sequential_windows(tmp_path):
+    """Test the pipeline analyzes exactly the windows of the sequential path, in order."""
+    path = write_log(tmp_path, 95)
+    chunker = LogChunker(chunk_size=10, overlap=3)
+    expected = chunker.chunk_lines(LogParser().parse_and_filter(str(path)))
+    
+    pipeline = Pipeline(echo, chunker, workers=3, queue_size=2)
+    results = pipeline.run(str(path))
+    
+    assert [(r["window_idx"], r["lines"]) for r in results] == expected
+    
+    # With a callback the results are handed over, not collected
+    seen = []
+    assert Pipeline(echo, chunker, workers=3, queue_size=2).run(
+        str(path), on_result=lambda r: seen.append(r["window_idx"])
+    ) == []
+    assert sorted(seen) == [idx for idx, _ in expected]
+    stats = pipeline.stats()
+    assert stats["lines"] == 95
+    assert stats["windows"] == len(expected)
+    assert stats["first_request_s"] is not None
+
+
+def test_masking_stage(tmp_path):
+    """Test windows are masked before they reach the analyze callable."""
+    path = write_log(tmp_path, 20, extra=" from 192.168.1.100")
+    chunker = LogChunker(chunk_size=5, overlap=1)
+    
+    pipeline = Pipeline(echo, chunker, masker=DataMasker(), workers=2, mask_workers=3, queue_size=4)
+    results = pipeline.run(str(path))
+    
+    assert len(results) == len(chunker.chunk_lines([""] * 20))
+    for result in results:
+        assert all("192.168.1.100" not in line for line in result["lines"])
+    assert set(pipeline.stats()["max_queue_depth"]) == {"raw", "masked", "results"}
+
+
+def test_backpressure_bounds_queues(tmp_path):
+    """Test a slow analyzer stops the reader instead of letting queues grow."""
+    path = write_log(tmp_path, 400)
+    gate = threading.Event()
+    
+    def slow(window_idx, window_lines):
+        gate.wait()
+        return echo(window_idx, window_lines)
+    
+    pipeline = Pipeline(slow, LogChunker(chunk_size=4, overlap=0), workers=2, queue_size=3)
+    thread = threading.Thread(target=pipeline.run, args=(str(path),))
+    thread.start()
+    time.sleep(0.2)
+    
+    # Two windows in flight, three queued; the reader is blocked on the fourth
+    assert pipeline.windows <= 2 + 3 + 1
+    gate.set()
+    thread.join(timeout=10)
+    
+    stats = pipeline.stats()
+    assert stats["windows"] == 100
+    assert all(depth <= 3 for depth in stats["max_queue_depth"].values())
+
+
+def test_reorder_limit_holds_reader_behind_slow_window(tmp_path):
+    """Test one slow window stops the reader at the reorder limit, bounding an in-order merger."""
+    path = write_log(tmp_path, 400)
+    gate = threading.Event()
+    
+    def slow_first(window_idx, window_lines):
+        if window_idx == 0:
+            gate.wait()
+        return echo(window_idx, window_lines)
+    
+    analyzer = WindowAnalyzer()
+    merger = analyzer.online_merger()
+    pipeline = Pipeline(slow_first, LogChunker(chunk_size=4, overlap=0), workers=4, queue_size=8,
+                        reorder_limit=6)
+    thread = threading.Thread(target=pipeline.run, args=(str(path),), kwargs={
+        "on_result": lambda r: merger.add(dict(r, confidence=0.9, reason="r"))
+    })
+    thread.start()
+    time.sleep(0.2)
+    
+    # Windows 1-5 completed behind window 0; the reader waits for it
+    assert pipeline.windows == 6
+    gate.set()
+    thread.join(timeout=10)
+    
+    assert pipeline.stats()["windows"] == 100
+    assert pipeline.stats()["reorder_limit"] == 6
+    # Window 0 joins the five results buffered behind it (窗口0加入其后缓冲的五个结果)
+    assert merger.max_pending == 6
+    assert [(s.start_window, s.end_window) for s in merger.finish()] == [(0, 99)]
+
+
+def test_queue_depth_counters(tmp_path):
+    """Test queue depths are recorded as trace counters."""
+    path = write_log(tmp_path, 30)
+    tracer = Tracer()
+    
+    Pipeline(echo, LogChunker(chunk_size=5, overlap=0), tracer=tracer).run(str(path))
+    
+    events = tracer.events()
+    counters = [e for e in events if e["ph"] == "C" and e["name"] == "queue_depth"]
+    assert counters and set(counters[0]["args"]) == {"raw", "results"}
+    assert any(e["name"] == "read_and_chunk" for e in events)
+
+
+def test_reader_error_is_raised(tmp_path):
+    """Test a failure in the reader thread surfaces from run()."""
+    pipeline = Pipeline(echo, LogChunker(chunk_size=5, overlap=0), workers=2)
+    
+    with pytest.raises(FileNotFoundError):
+        pipeline.run(str(tmp_path / "missing.log"))
+
+
+def test_mask_error_is_raised(tmp_path):
+    """Test a failing masker surfaces from run() instead of hanging the pipeline."""
+    path = write_log(tmp_path, 200)
+    
+    class BrokenMasker:
+        def mask_lines(self, lines):
+            raise RuntimeError("masking failed")
+    
+    pipeline = Pipeline(echo, LogChunker(chunk_size=4, overlap=0), masker=BrokenMasker(),
+                        workers=2, mask_workers=2, queue_size=2)
+    thread_result = {}
+    
+    def run():
+        try:
+            pipeline.run(str(path))
+        except RuntimeError as e:
+            thread_result["error"] = str(e)
+    
+    thread = threading.Thread(target=run)
+    thread.start()
+    thread.join(timeout=10)
+    
+    assert not thread.is_alive()
+    assert thread_result["error"] == "masking failed"
+
+
+def test_failure_stops_sending_requests(tmp_path):
+    """Test a failed request stops the reader and the other workers instead of sending every window."""
+    path = write_log(tmp_path, 400)
+    calls = []
+    
+    def failing(window_idx, window_lines):
+        calls.append(window_idx)
+        if window_idx == 3:
+            raise RuntimeError("analyze failed")
+        return echo(window_idx, window_lines)
+    
+    pipeline = Pipeline(failing, LogChunker(chunk_size=4, overlap=0), workers=2, queue_size=2)
+    with pytest.raises(RuntimeError, match="analyze failed"):
+        pipeline.run(str(path))
+    
+    assert len(calls) < 10
+    assert pipeline.windows < 100
+
+
+def test_on_result_error_shuts_down(tmp_path):
+    """Test an exception in on_result stops the stages and is raised instead of hanging."""
+    path = write_log(tmp_path, 400)
+    calls = []
+    
+    def counting(window_idx, window_lines):
+        calls.append(window_idx)
+        return echo(window_idx, window_lines)
+    
+    def on_result(result):
+        raise ValueError("callback failed")
+    
+    pipeline = Pipeline(counting, LogChunker(chunk_size=4, overlap=0), workers=2, queue_size=2)
+    thread_result = {}
+    
+    def run():
+        try:
+            pipeline.run(str(path), on_result=on_result)
+        except ValueError as e:
+            thread_result["error"] = str(e)
+    
+    thread = threading.Thread(target=run)
+    thread.start()
+    thread.join(timeout=10)
+    
+    assert not thread.is_alive()
+    assert thread_result["error"] == "callback failed"
+    assert len(calls) < 20
+    # No stage is left blocked on a full queue
+    assert not [t for t in threading.enumerate() if t.name.startswith("pipeline-")]
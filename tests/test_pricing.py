@@ -0,0 +1,38 @@
+"""Tests for pricing module."""
+
+import pytest
+from src.pricing import (
+    MODEL_LATENCY,
+    MODEL_PRICES,
+    MODEL_RATE_LIMITS,
+    estimate_cost,
+    estimate_latency,
+    model_prices,
+    model_rate_limits,
+)
+
+
+def test_estimate_cost():
+    """Test cost uses input and output prices per 1K tokens."""
+    input_price, output_price = MODEL_PRICES["qwen-plus"]
+    
+    assert estimate_cost("qwen-plus", 1000, 500) == pytest.approx(input_price + output_price / 2)
+
+
+def test_unknown_model_uses_default_prices():
+    """Test models missing from the table fall back to the default model's prices."""
+    assert model_prices("my-local-model") == MODEL_PRICES["qwen-plus"]
+    assert model_prices(None) == MODEL_PRICES["qwen-plus"]
+
+
+def test_estimate_latency():
+    """Test latency is the first-token delay plus output at the decode rate."""
+    first_token, tokens_per_second = MODEL_LATENCY["qwen-plus"]
+    
+    assert estimate_latency("qwen-plus", 300) == pytest.approx(first_token + 300 / tokens_per_second)
+    assert estimate_latency("my-local-model", 0) == pytest.approx(first_token)
+
+
+def test_rate_limits_fall_back_to_default_model():
+    """Test models missing from the rate limit table use the default model's limits."""
+    assert model_rate_limits("my-local-model") == MODEL_RATE_LIMITS["qwen-plus"]
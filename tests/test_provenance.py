@@ -0,0 +1,55 @@
+"""Tests for provenance module."""
+
+from src.provenance import NO_TIME, EvidenceIndex, LineProvenance, format_timestamp, parse_timestamp
+
+
+def test_timestamp_round_trip():
+    """Test logcat timestamps survive storage as milliseconds."""
+    for stamp in ["01-01 00:00:00.000", "01-06 10:15:23.456", "02-29 23:59:59.999", "12-31 12:00:00.001"]:
+        assert format_timestamp(parse_timestamp(stamp + "  1234  1235 I AudioFlinger: x")) == stamp
+    
+    assert parse_timestamp("01-06 10:15:24.000") - parse_timestamp("01-06 10:15:23.456") == 544
+    assert parse_timestamp("--------- beginning of main") == NO_TIME
+    assert parse_timestamp("13-01 00:00:00.000") == NO_TIME
+    assert format_timestamp(NO_TIME) is None
+
+
+def build(lines):
+    provenance = LineProvenance()
+    file_id = provenance.add_file("a.log")
+    offset = 0
+    for number, line in enumerate(lines, 1):
+        provenance.append(file_id, offset, number * 2, line)
+        offset += len(line) + 1
+    return provenance
+
+
+def test_columns_and_select():
+    """Test rows are kept in compact parallel columns and can be selected."""
+    lines = [f"01-06 10:15:{i:02d}.000  1234  1235 I AudioFlinger: event {i}" for i in range(5)]
+    provenance = build(lines)
+    
+    assert len(provenance) == 5
+    assert provenance.offsets.itemsize == 8 and provenance.file_ids.itemsize == 2
+    assert provenance.elapsed_s(1, 4) == 3.0
+    assert provenance.elapsed_s(4, 1) is None
+    
+    selected = provenance.select([1, 3])
+    assert list(selected.line_numbers) == [4, 8]
+    assert selected.position(1) == {
+        "file": "a.log",
+        "byte_offset": provenance.offsets[3],
+        "line_number": 8,
+        "timestamp": "01-06 10:15:03.000"
+    }
+
+
+def test_evidence_index():
+    """Test evidence resolves to the first retained line with the same text."""
+    lines = ["01-06 10:15:00.000 A AudioFlinger: start", "01-06 10:15:01.000 A AudioFlinger: stop",
+             "01-06 10:15:01.000 A AudioFlinger: stop"]
+    index = EvidenceIndex(lines, build(lines))
+    
+    assert index.line_index("  01-06 10:15:01.000 A AudioFlinger: stop ") == 1
+    assert index.resolve(lines[0])["line_number"] == 2
+    assert index.resolve("not a log line") is None
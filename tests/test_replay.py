@@ -0,0 +1,93 @@
+"""Tests for replay and bench modules."""
+
+import json
+import pytest
+from src.bailian_client import BailianClient
+from src.bench import run_windows
+from src.replay import ExchangeRecorder, LatencyModel, ReplayResponder, exchange_key, load_recordings
+from src.stub_server import StubServer
+
+
+def state_responder(payload):
+    content = payload["messages"][1]["content"]
+    state = "MUTED" if "muted" in content else "PLAYING"
+    return {"final_state": state, "confidence": 0.9, "reason": state, "evidence": [], "next_actions": []}
+
+
+def test_record_then_replay_strict(tmp_path):
+    """Test that recorded exchanges replay identically with no live server."""
+    path = tmp_path / "rec.jsonl"
+    
+    with StubServer(responder=state_responder) as live:
+        client = BailianClient(api_key="k", base_url=live.base_url, recorder=ExchangeRecorder(path))
+        originals = [client.analyze_log_window("SP", text) for text in ["playing", "muted"]]
+    
+    records = load_recordings(path)
+    assert len(records) == 2
+    assert records[0]["key"] == exchange_key(records[0]["request"])
+    
+    responder = ReplayResponder(records, strict=True)
+    with StubServer(responder=responder) as replay:
+        client = BailianClient(api_key="k", base_url=replay.base_url)
+        replayed = [client.analyze_log_window("SP", text) for text in ["playing", "muted"]]
+        
+        # Unrecorded requests fail in strict mode (严格模式下未录制的请求失败)
+        with pytest.raises(Exception):
+            client.analyze_log_window("SP", "never recorded")
+    
+    # Wall-clock latency and the random call id may differ (实际延迟和随机调用ID可以不同)
+    for result in originals + replayed:
+        result.pop("latency_s")
+        result.pop("call_id")
+    assert replayed == originals
+    assert responder.hits == 2
+
+
+def test_replay_cycles_unmatched_requests():
+    """Test that unmatched requests reuse recordings in order."""
+    records = [{"key": "a", "response": {"choices": [{"message": {"content": "x"}}]}, "latency": 0.0}]
+    responder = ReplayResponder(records)
+    
+    assert responder({"messages": []}) == records[0]["response"]
+    assert responder.misses == 1
+
+
+def test_latency_model_is_reproducible():
+    """Test seeded distributions produce the same samples."""
+    first = LatencyModel("lognormal:0.5,0.3", seed=7)
+    second = LatencyModel("lognormal:0.5,0.3", seed=7)
+    
+    assert [first.sample() for _ in range(5)] == [second.sample() for _ in range(5)]
+    assert LatencyModel("fixed:0.25").sample() == 0.25
+    assert LatencyModel("recorded").sample(recorded=1.5) == 1.5
+    
+    with pytest.raises(ValueError):
+        LatencyModel("gamma:1")
+    with pytest.raises(ValueError):
+        LatencyModel("uniform:1")
+
+
+def test_replay_applies_latency():
+    """Test that the latency model delays each answer."""
+    slept = []
+    responder = ReplayResponder([], latency=LatencyModel("fixed:0.3"), sleep=slept.append)
+    
+    responder({"messages": []})
+    
+    assert slept == [0.3]
+
+
+def test_run_windows_reports_throughput():
+    """Test the benchmark driver reports counts and latency percentiles."""
+    windows = [(i, [f"line {i}"]) for i in range(6)]
+    
+    with StubServer(responder=state_responder) as stub:
+        client = BailianClient(api_key="k", base_url=stub.base_url)
+        results = run_windows(client, "SP", windows, concurrency=3)
+    
+    assert results["windows"] == 6
+    assert results["succeeded"] == 6
+    assert results["lost_windows"] == 0
+    assert results["windows_per_s"] > 0
+    assert results["latency_s"]["count"] == 6
+    assert results["latency_s"]["p50"] <= results["latency_s"]["p99"]
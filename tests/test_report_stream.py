@@ -0,0 +1,94 @@
+"""Tests for report_stream module."""
+
+import json
+import pytest
+from src import report_stream
+from src.report_stream import ReportReader, ReportWriter, check_compression, dumps, report_path
+
+
+def results(count):
+    return [{"window_idx": i, "final_state": "PLAYING", "confidence": 0.9, "reason": "Track 音轨"}
+            for i in range(count)]
+
+
+def write_report(path, compression=None, windows=3):
+    with ReportWriter(path, compression) as writer:
+        for result in results(windows):
+            writer.window(result)
+        writer.finish(
+            [{"state": "PLAYING", "start_window": 0, "end_window": windows - 1, "confidence_avg": 0.9}],
+            {"total_windows": windows, "total_segments": 1},
+            {"model": "qwen-plus"},
+            {"final_state": "PLAYING", "summary": "Playing throughout"},
+            timeline={"entries": [{"state": "PLAYING", "start_line": 0, "end_line": 9}], "transitions": []}
+        )
+
+
+@pytest.mark.parametrize("compression", [None, "gzip"])
+def test_round_trip(tmp_path, compression):
+    """Test every record reads back, with and without compression."""
+    path = report_path(tmp_path, compression)
+    write_report(path, compression)
+    
+    reader = ReportReader(path)
+    
+    assert list(reader.windows()) == results(3)
+    assert reader.segments()[0]["end_window"] == 2
+    assert reader.summary()["total_windows"] == 3
+    assert reader.metadata() == {"model": "qwen-plus"}
+    assert reader.diagnosis()["final_state"] == "PLAYING"
+    assert reader.timeline()["entries"][0]["end_line"] == 9
+    assert reader.complete
+    assert [r["type"] for r in reader.records()][-4:] == ["metadata", "diagnosis", "timeline", "end"]
+
+
+def test_report_is_one_record_per_line(tmp_path):
+    """Test the uncompressed file is plain JSON Lines readable by any tool."""
+    path = report_path(tmp_path)
+    write_report(path)
+    
+    lines = path.read_text(encoding="utf-8").splitlines()
+    
+    assert len(lines) == 3 + 1 + 5
+    assert json.loads(lines[0])["reason"] == "Track 音轨"
+
+
+def test_unfinished_report_is_incomplete(tmp_path):
+    """Test a report closed before finish() has its windows but no end record."""
+    path = report_path(tmp_path)
+    with ReportWriter(path) as writer:
+        writer.window(results(1)[0])
+    
+    reader = ReportReader(path)
+    
+    assert len(list(reader.windows())) == 1
+    assert not reader.complete
+
+
+def test_dumps_without_orjson(monkeypatch):
+    """Test the standard library fallback encodes the same record."""
+    record = {"type": "window", "window_idx": 1, "reason": "音轨", "states": {0: "PLAYING"}}
+    fast = dumps(record)
+    monkeypatch.setattr(report_stream, "orjson", None)
+    
+    assert json.loads(dumps(record)) == json.loads(fast)
+    assert dumps(record).startswith(b'{"type":"window"')
+
+
+def test_check_compression(monkeypatch):
+    """Test unknown compressions and a missing zstandard package are reported."""
+    with pytest.raises(ValueError, match="Unknown compression"):
+        check_compression("lz4")
+    monkeypatch.setattr(report_stream, "zstandard", None)
+    with pytest.raises(ValueError, match="zstandard"):
+        check_compression("zstd")
+
+
+def test_zstd_round_trip(tmp_path):
+    """Test zstd-compressed reports when the zstandard package is installed."""
+    pytest.importorskip("zstandard")
+    path = report_path(tmp_path, "zstd")
+    write_report(path, "zstd", windows=100)
+    
+    assert path.name == "report.jsonl.zst"
+    assert len(list(ReportReader(path).windows())) == 100
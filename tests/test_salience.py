@@ -0,0 +1,70 @@
+"""Tests for salience module."""
+
+import pytest
+from src.salience import BudgetExhausted, SpendMeter, find_gaps, plan_budget, refused_by_budget, salience_score
+
+
+QUIET = ["01-06 10:15:23.550  1234  1236 V AudioFlinger: obtainBuffer() success, buffer size: 4096"] * 10
+ERRORS = QUIET[:5] + [
+    "01-06 10:15:24.000  1234  1236 E AudioFlinger: obtainBuffer timed out (is the CPU pegged?)",
+    "01-06 10:15:24.100  1234  1236 W AudioTrack: underrun, framesReady=0",
+]
+MUTE = QUIET[:5] + ["01-06 10:15:30.050  1234  1236 D AudioManager: setStreamMute() stream=MUSIC muted=true"]
+
+
+def test_salience_score_ranks_informative_windows():
+    """Test errors, underruns and mute commands raise the score."""
+    assert salience_score(QUIET) == 0
+    assert salience_score(ERRORS) > salience_score(MUTE) > salience_score(QUIET)
+
+
+def test_salience_feature_cap():
+    """Test one repeated message cannot dominate the score."""
+    assert salience_score(MUTE[-1:] * 100) == salience_score(MUTE[-1:] * 5)
+
+
+def test_plan_budget_max_calls():
+    """Test the most salient windows are selected up to max_calls, returned in window order."""
+    windows = [(0, QUIET), (1, MUTE), (2, QUIET), (3, ERRORS)]
+    
+    selected, summary = plan_budget(windows, max_calls=2)
+    
+    assert [idx for idx, _ in selected] == [1, 3]
+    assert summary["selected_windows"] == 2
+
+
+def test_plan_budget_max_cost():
+    """Test selection stops before the estimated cost exceeds max_cost."""
+    windows = [(i, QUIET) for i in range(10)]
+    
+    selected, summary = plan_budget(windows, max_cost=0.35, cost_fn=lambda lines: 0.1)
+    
+    assert [idx for idx, _ in selected] == [0, 1, 2]
+    assert summary["estimated_cost"] == pytest.approx(0.3)
+    
+    with pytest.raises(ValueError):
+        plan_budget(windows, max_cost=1.0)
+
+
+def test_spend_meter_refuses_once_spent():
+    """Test the meter allows requests until the actual spend reaches the cap."""
+    meter = SpendMeter(0.25)
+    meter.check()
+    meter.charge(0.2)
+    meter.check()
+    meter.charge(0.1)
+    
+    with pytest.raises(BudgetExhausted) as excinfo:
+        meter.check()
+    assert refused_by_budget({"error": str(excinfo.value)})
+    assert not refused_by_budget({"error": "timeout"})
+    assert meter.to_dict() == {"actual_cost": 0.3, "charged_calls": 2, "refused_requests": 1}
+
+
+def test_find_gaps():
+    """Test unanalyzed stretches are reported as contiguous gaps."""
+    assert find_gaps(list(range(8)), [0, 3, 4]) == [
+        {"start_window": 1, "end_window": 2, "window_count": 2},
+        {"start_window": 5, "end_window": 7, "window_count": 3},
+    ]
+    assert find_gaps([0, 1], [0, 1]) == []
@@ -0,0 +1,95 @@
+"""Tests for serializer module."""
+
+from src.log_parser import LogParser
+from src.serializer import deserialize, measure, serialize_window, tag_alias
+
+
+WINDOW = [
+    "01-06 10:15:23.456  1234  1235 I AudioFlinger: AudioFlinger's thread #1 ready to run",
+    "01-06 10:15:23.457  1234  1235 D AudioTrack: set() track 0xb4000071f3f18800 format: 0x1",
+    "01-06 10:15:23.507  1234  1236 D AudioFlinger: start track 0xb4000071f3f18800",
+    "01-06 10:15:23.557  1234  1236 V AudioTrack: obtainBuffer() frames: 1024",
+]
+
+
+def test_tag_alias():
+    """Test aliases are built from word initials."""
+    assert tag_alias("AudioFlinger") == "AF"
+    assert tag_alias("audio_hw") == "AH"
+    assert tag_alias("AudioPolicyService") == "APS"
+
+
+def test_serialize_window_format():
+    """Test relative times, pid/tid on change, tag and hex aliases."""
+    serialized = serialize_window(WINDOW)
+    
+    assert serialized.header[0].startswith("# fmt: +ms since 01-06 10:15:23.456;")
+    assert "AF=AudioFlinger" in serialized.header[1]
+    assert serialized.header[2] == "# hex: #h1=0xb4000071f3f18800"
+    assert serialized.body == [
+        "+0 [1234/1235] I AF: AudioFlinger's thread #1 ready to run",
+        "+1 D AT: set() track #h1 format: 0x1",
+        "+51 [1234/1236] D AF: start track #h1",
+        "+101 V AT: obtainBuffer() frames: 1024",
+    ]
+
+
+def test_deserialize_round_trip():
+    """Test the serialized text decodes back to the exact lines."""
+    assert deserialize(serialize_window(WINDOW).text) == WINDOW
+
+
+def test_deserialize_round_trip_demo_log():
+    """Test the sample log survives serialization unchanged."""
+    lines = LogParser().parse_and_filter("samples/demo.log")
+    assert deserialize(serialize_window(lines).text) == lines
+
+
+def test_unparseable_and_ambiguous_lines_are_verbatim():
+    """Test alias collisions are avoided and lines that would not decode exactly are sent as-is."""
+    lines = [
+        "--------- beginning of main",
+        "01-06 10:15:23.456  1234  1235 I AudioFlinger:   padded message",
+        "01-06 10:15:23.456  1234  1235 I AF: a real tag named like an alias",
+        "01-06 10:15:23.456  1234  1235 I AudioFlinger: literal #h1 with 0xb4000071f3f18800",
+        "01-06 10:15:23.456  1234  1235 I AudioFlinger: again 0xb4000071f3f18800",
+        "01-07 00:00:00.001 99999 12345 W AudioFlinger: next day",
+    ]
+    serialized = serialize_window(lines)
+    
+    assert serialized.body[0] == "~ --------- beginning of main"
+    assert "AF2=AudioFlinger" in serialized.header[1]
+    assert serialized.body[3].startswith("~ ")
+    assert serialized.body[5].startswith("+49476545 ") and "[99999/12345]" in serialized.body[5]
+    assert deserialize(serialized.text) == lines
+
+
+def test_resolve_evidence():
+    """Test evidence copied from the serialized body maps to original lines."""
+    serialized = serialize_window(WINDOW)
+    
+    resolved = serialized.resolve([
+        "+51 [1234/1236] D AF: start track #h1",
+        "obtainBuffer() frames",
+        "track",
+        "not in the window",
+    ])
+    
+    assert resolved == [WINDOW[2], WINDOW[3], "track", "not in the window"]
+
+
+def test_numbered_text():
+    """Test body lines are numbered after the legend."""
+    text = serialize_window(WINDOW).numbered_text()
+    
+    assert "\n1| +0 [1234/1235] I AF:" in text
+    assert text.split("\n")[-1].startswith("4| ")
+
+
+def test_measure_reports_savings():
+    """Test serialization saves tokens on the sample log."""
+    lines = LogParser().parse_and_filter("samples/demo.log")
+    result = measure([(0, lines)])
+    
+    assert result["serialized_tokens"] < result["original_tokens"]
+    assert result["saving"] > 0.2
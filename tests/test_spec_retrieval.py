@@ -0,0 +1,109 @@
+"""Tests for spec_retrieval module."""
+
+from src.chunker import LogChunker
+from src.log_parser import LogParser
+from src.spec_retrieval import SPEC_HEADING, SpecIndex, measure, split_sections, terms, window_query
+from src.tokens import estimate_tokens
+
+
+SPEC = """# Spec
+
+Intro text.
+
+## AudioFlinger
+
+createTrack() creates a track; sessionId links it to the client.
+
+## audio_hw
+
+adev_standby() closes the output stream; set_stream_mute() applies a hardware mute.
+
+## Bluetooth
+
+A2dpStateMachine reports connection changes.
+"""
+
+WINDOW = [
+    "01-06 10:15:23.456  1234  1235 D AudioFlinger: createTrack() sessionId: 12345 type: 1",
+    "01-06 10:15:23.500  1234  1235 D audio_hw: set_stream_mute(): mute=1",
+]
+
+
+def test_terms_split_identifiers():
+    """Test identifiers are kept whole and split at camelCase and underscores."""
+    result = terms("setStreamMute() on audio_hw")
+    
+    assert "setstreammute" in result
+    assert {"set", "stream", "mute", "audio_hw", "audio"} <= set(result)
+
+
+def test_window_query_uses_tags_and_messages():
+    """Test the query holds distinct terms from tags and messages, not timestamps."""
+    query = window_query(WINDOW)
+    
+    assert "audioflinger" in query and "createtrack" in query and "audio_hw" in query
+    assert len(query) == len(set(query))
+
+
+def test_split_sections_at_headings():
+    """Test sections start at markdown headings."""
+    sections = split_sections(SPEC)
+    
+    assert [s.split("\n")[0] for s in sections] == ["# Spec", "## AudioFlinger", "## audio_hw", "## Bluetooth"]
+
+
+def test_split_sections_splits_long_sections_at_paragraphs():
+    """Test long sections are split and each part repeats the heading."""
+    text = "## Long\n\n" + "\n\n".join("paragraph " * 30 for _ in range(6))
+    sections = split_sections(text, max_section_tokens=100)
+    
+    assert len(sections) > 1
+    assert all(s.startswith("## Long\n") for s in sections)
+    assert all(estimate_tokens(s) <= 100 for s in sections)
+
+
+def test_select_returns_matching_sections_in_order():
+    """Test only matching sections are selected, in document order."""
+    index = SpecIndex(SPEC)
+    
+    chosen = [index.sections[i].split("\n")[0] for i in index.select(WINDOW)]
+    
+    assert chosen == ["## AudioFlinger", "## audio_hw"]
+
+
+def test_select_respects_token_cap():
+    """Test the selected sections never exceed the cap."""
+    index = SpecIndex(SPEC, max_tokens=index_size(SPEC, "## audio_hw"))
+    
+    chosen = index.select(WINDOW)
+    
+    assert sum(index.section_tokens[i] for i in chosen) <= index.max_tokens
+    assert len(chosen) == 1
+
+
+def index_size(text, heading):
+    """Token count of the section starting with heading."""
+    return next(estimate_tokens(s) for s in split_sections(text) if s.startswith(heading))
+
+
+def test_prompt_for():
+    """Test the prompt carries the heading and relevant sections only."""
+    index = SpecIndex(SPEC)
+    
+    prompt = index.prompt_for("System prompt", WINDOW)
+    
+    assert prompt.startswith("System prompt\n\n" + SPEC_HEADING)
+    assert "createTrack()" in prompt and "A2dpStateMachine" not in prompt
+    assert index.prompt_for("System prompt", ["unrelated words only"]) == "System prompt"
+
+
+def test_measure_on_sample_spec():
+    """Test retrieval sends fewer spec tokens than the full document."""
+    with open("samples/audio_spec.md", encoding="utf-8") as f:
+        index = SpecIndex(f.read(), max_tokens=600)
+    windows = LogChunker(20, 5).chunk_lines(LogParser().parse_and_filter("samples/demo.log"))
+    
+    result = measure(index, windows)
+    
+    assert result["max_request_tokens"] <= 600
+    assert result["reduction"] > 0.5
@@ -0,0 +1,94 @@
+"""Tests for state_machine module."""
+
+from pathlib import Path
+
+from src.log_parser import LogParser
+from src.state_machine import AudioStateMachine
+
+
+DEMO_LOG = Path(__file__).parent.parent / "samples" / "demo.log"
+
+
+def line(message, tag="AudioFlinger"):
+    return f"01-06 10:15:23.456  1234  1235 D {tag}: {message}"
+
+
+def test_unknown_before_evidence():
+    """Test the state stays UNKNOWN until an event is seen."""
+    engine = AudioStateMachine()
+    
+    assert engine.feed(line("createTrack() sessionId: 12345 type: 1")) == "UNKNOWN"
+    assert engine.timeline == []
+    assert engine.state_at(0) == "UNKNOWN"
+    
+    # Route and volume changes say nothing about silence (路由和音量变化不能说明无声)
+    assert engine.feed(line("Output device: SPEAKER", tag="AudioPolicyService")) == "UNKNOWN"
+    assert engine.feed(line("setStreamVolume() stream=MUSIC level=7", tag="AudioManager")) == "UNKNOWN"
+    assert engine.timeline == []
+    assert engine.feed(line("stream MUSIC muted")) == "MUTED"
+
+
+def test_start_mute_unmute_stop():
+    """Test track start, mute, unmute and stop transitions."""
+    engine = AudioStateMachine()
+    timeline = engine.run([
+        line("Track started on output 13, session 12345"),
+        line("obtainBuffer() success, buffer size: 4096"),
+        line("stream MUSIC muted"),
+        line("stream MUSIC unmuted, volume=1.0"),
+        line("Track stopped, session 12345"),
+    ])
+    
+    assert [(e["state"], e["start_line"], e["end_line"]) for e in timeline] == [
+        ("PLAYING", 0, 1), ("MUTED", 2, 2), ("PLAYING", 3, 3), ("MUTED", 4, 4)
+    ]
+    assert timeline[0]["start_time"] == "01-06 10:15:23.456"
+    assert engine.sessions == {"12345": "STOPPED"}
+    assert engine.snapshot()["outputs"][0]["output_id"] == "13"
+
+
+def test_volume_zero_mutes():
+    """Test volume 0 on an active output counts as MUTED."""
+    engine = AudioStateMachine()
+    
+    assert engine.feed(line("Track started")) == "PLAYING"
+    assert engine.feed(line("setStreamVolume() stream=MUSIC level=0", tag="AudioManager")) == "MUTED"
+    assert engine.feed(line("setStreamVolume() stream=MUSIC level=7", tag="AudioManager")) == "PLAYING"
+
+
+def test_per_output_state():
+    """Test a stop on one output leaves another output playing."""
+    engine = AudioStateMachine()
+    engine.run([
+        line("Track started on output 13, session 1"),
+        line("Track started on output 29, session 2"),
+        line("Track stopped, session 1"),
+    ])
+    
+    assert engine.state == "PLAYING"
+    assert engine.sessions == {"1": "STOPPED", "2": "STARTED"}
+    
+    engine.feed(line("Track paused, session 2"))
+    assert engine.state == "MUTED"
+    assert engine.sessions["2"] == "PAUSED"
+
+
+def test_standby_stops_all_sessions():
+    """Test standby ends every session on the output."""
+    engine = AudioStateMachine()
+    engine.run([line("Track started, session 1"), line("mixer thread: track started"), line("PlaybackThread: standby mode")])
+    
+    assert engine.state == "MUTED"
+
+
+def test_demo_log_timeline_and_window_states():
+    """Test the demo log yields its four state segments."""
+    lines = LogParser().parse_and_filter(str(DEMO_LOG))
+    engine = AudioStateMachine()
+    timeline = engine.run(lines)
+    
+    assert [e["state"] for e in timeline] == ["PLAYING", "MUTED", "PLAYING", "MUTED"]
+    assert timeline[-1]["end_line"] == len(lines) - 1
+    assert engine.window_states([(0, 0, 20), (1, 20, 30), (2, 30, len(lines))]) == {
+        0: "PLAYING", 1: "MUTED", 2: "MUTED"
+    }
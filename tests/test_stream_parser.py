@@ -0,0 +1,49 @@
+"""Tests for stream_parser module."""
+
+import json
+from src.stream_parser import IncrementalJSONParser
+
+
+RESULT = {
+    "final_state": "PLAYING",
+    "confidence": 0.9,
+    "reason": "Track \"A\" active, {not nested}",
+    "evidence": ["Line 1", "Line [2]"],
+    "next_actions": [{"step": "Monitor"}]
+}
+
+
+def test_parser_emits_fields_in_order_char_by_char():
+    """Test that fields are emitted as soon as each value completes."""
+    parser = IncrementalJSONParser()
+    text = json.dumps(RESULT)
+    emitted = []
+    
+    for i, c in enumerate(text):
+        for key, value in parser.feed(c):
+            emitted.append((key, value, i))
+    
+    assert [e[0] for e in emitted] == list(RESULT)
+    assert parser.fields == RESULT
+    assert parser.complete
+    
+    # final_state is known well before the evidence array ends
+    # final_state远早于证据数组结束即可获知
+    assert emitted[0][2] < text.index("evidence")
+
+
+def test_parser_scalar_needs_terminator():
+    """Test that a number is only emitted once its terminator arrives."""
+    parser = IncrementalJSONParser()
+    
+    assert parser.feed('{"confidence": 0.8') == []
+    assert parser.feed('5, "x": true}') == [("confidence", 0.85), ("x", True)]
+
+
+def test_parser_ignores_nested_keys():
+    """Test that keys inside nested objects are not reported as top-level."""
+    parser = IncrementalJSONParser()
+    
+    parser.feed('{"a": {"final_state": "MUTED"}, "b": null}')
+    
+    assert parser.fields == {"a": {"final_state": "MUTED"}, "b": None}
@@ -0,0 +1,121 @@
+"""Tests for summarize module."""
+
+import json
+import time
+
+import pytest
+from src.bailian_client import BailianClient
+from src.summarize import HierarchicalSummarizer, load_reduce_prompt, local_reduce, window_item
+from src.stub_server import StubServer
+
+
+def make_results(states):
+    return [{"window_idx": i, "final_state": s, "confidence": 0.9, "reason": f"Window {i} {s}",
+             "evidence": [], "next_actions": []} for i, s in enumerate(states)]
+
+
+def reduce_responder(payload):
+    """Summarize by counting items; report the last item's state."""
+    items = json.loads(payload["messages"][1]["content"])
+    return {"first_window": -1, "last_window": -1, "final_state": items[-1]["final_state"],
+            "confidence": 0.8, "summary": f"{len(items)} items", "transitions": [], "issues": []}
+
+
+def test_window_item_is_compact():
+    """Test window items drop evidence and truncate long reasons."""
+    result = make_results(["MUTED"])[0]
+    result["reason"] = "x" * 500
+    result["evidence"] = ["line"] * 5
+    
+    item = window_item(result)
+    
+    assert item == {"first_window": 0, "last_window": 0, "final_state": "MUTED",
+                    "confidence": 0.9, "summary": "x" * 200}
+
+
+def test_local_reduce_keeps_transitions():
+    """Test the fallback reduction derives transitions from item states."""
+    items = [window_item(r) for r in make_results(["PLAYING", "PLAYING", "MUTED"])]
+    
+    reduced = local_reduce(items, "timeout")
+    
+    assert reduced["transitions"] == [{"window": 2, "from": "PLAYING", "to": "MUTED"}]
+    assert reduced["final_state"] == "MUTED"
+    assert reduced["issues"] == ["Reduction failed: timeout"]
+
+
+def test_tree_levels_and_ranges():
+    """Test 40 windows with fan-in 4 reduce in three levels to one diagnosis."""
+    with StubServer(responder=reduce_responder) as stub:
+        client = BailianClient(api_key="k", base_url=stub.base_url)
+        summarizer = HierarchicalSummarizer(client, "SP", fan_in=4, concurrency=4)
+        tree = summarizer.run(make_results(["PLAYING"] * 39 + ["MUTED"]))
+    
+    assert [len(level) for level in tree["levels"]] == [10, 3, 1]
+    assert tree["calls"] == 14
+    assert tree["diagnosis"]["first_window"] == 0
+    assert tree["diagnosis"]["last_window"] == 39
+    assert tree["diagnosis"]["final_state"] == "MUTED"
+    assert tree["levels"][0][1]["first_window"] == 4
+    # Every reduction call is accounted like a window request
+    assert len(tree["usage"]) == 14
+    assert len({u["call_id"] for u in tree["usage"]}) == 14
+    assert all(u["usage"]["prompt_tokens"] > 0 for u in tree["usage"])
+
+
+def test_levels_run_concurrently():
+    """Test wall time grows with the number of levels, not the number of groups."""
+    def slow(payload):
+        time.sleep(0.1)
+        return reduce_responder(payload)
+    
+    with StubServer(responder=slow) as stub:
+        client = BailianClient(api_key="k", base_url=stub.base_url)
+        summarizer = HierarchicalSummarizer(client, "SP", fan_in=4, concurrency=16)
+        started = time.monotonic()
+        tree = summarizer.run(make_results(["PLAYING"] * 64))
+        elapsed = time.monotonic() - started
+    
+    assert tree["calls"] == 21
+    assert len(tree["levels"]) == 3
+    assert elapsed < 1.5
+
+
+def test_failed_reduction_falls_back():
+    """Test a failed reduction call is replaced by a local reduction."""
+    def broken(payload):
+        raise RuntimeError("down")
+    
+    with StubServer(responder=broken) as stub:
+        client = BailianClient(api_key="k", base_url=stub.base_url)
+        tree = HierarchicalSummarizer(client, "SP", fan_in=2).run(make_results(["PLAYING", "MUTED"]))
+    
+    assert tree["failures"] == 1
+    assert tree["diagnosis"]["transitions"] == [{"window": 1, "from": "PLAYING", "to": "MUTED"}]
+
+
+def test_empty_and_invalid_fan_in():
+    """Test empty input and fan-in validation."""
+    assert HierarchicalSummarizer(None, "SP").run([])["diagnosis"] is None
+    with pytest.raises(ValueError):
+        HierarchicalSummarizer(None, "SP", fan_in=1)
+
+
+def test_load_reduce_prompt():
+    """Test the reduction prompt ships with the docs."""
+    assert "final_state" in load_reduce_prompt()
+
+
+def test_null_lists_from_model_are_tolerated():
+    """Test null or non-list transitions/issues do not abort the reduction."""
+    def responder(payload):
+        return {"final_state": "PLAYING", "confidence": 0.7, "summary": "ok",
+                "transitions": None, "issues": "none"}
+    
+    with StubServer(responder=responder) as stub:
+        client = BailianClient(api_key="k", base_url=stub.base_url)
+        tree = HierarchicalSummarizer(client, "SP", fan_in=2).run(make_results(["PLAYING"] * 4))
+    
+    assert tree["failures"] == 0
+    assert tree["diagnosis"]["transitions"] == []
+    assert tree["diagnosis"]["issues"] == []
@@ -0,0 +1,119 @@
+"""Tests for timeline module."""
+
+import random
+
+from src.chunker import LogChunker
+from src.timeline import STATES, line_timeline
+
+
+def result(idx, state, confidence):
+    return {"window_idx": idx, "final_state": state, "confidence": confidence}
+
+
+def states_per_line(timeline, count):
+    states = [None] * count
+    for entry in timeline["entries"]:
+        for line in range(entry["start_line"], entry["end_line"] + 1):
+            states[line] = entry["state"]
+    return states
+
+
+def test_overlap_follows_more_confident_window():
+    """Test overlap lines take the state of the more confident window."""
+    spans = LogChunker(chunk_size=10, overlap=3).window_spans(17)
+    assert spans == [(0, 0, 10), (1, 7, 17)]
+    
+    timeline = line_timeline([result(0, "PLAYING", 0.9), result(1, "MUTED", 0.6)], spans)
+    assert [(e["state"], e["start_line"], e["end_line"]) for e in timeline["entries"]] == [
+        ("PLAYING", 0, 9), ("MUTED", 10, 16)
+    ]
+    assert timeline["transitions"] == [
+        {"line": 10, "source_line": None, "time": None, "from": "PLAYING", "to": "MUTED"}
+    ]
+    assert timeline["entries"][0]["contested_lines"] == 3
+    assert timeline["entries"][0]["agreement"] < 1.0
+    
+    timeline = line_timeline([result(0, "PLAYING", 0.5), result(1, "MUTED", 0.95)], spans)
+    assert timeline["transitions"][0]["line"] == 7
+
+
+def test_failed_windows_and_gaps():
+    """Test failed windows only decide lines nobody else covers, and gaps split the timeline."""
+    spans = LogChunker(chunk_size=4, overlap=1).window_spans(13)
+    assert [s[1:] for s in spans] == [(0, 4), (3, 7), (6, 10), (9, 13)]
+    results = [
+        result(0, "PLAYING", 0.8),
+        {**result(1, "UNKNOWN", 0.0), "error": "timeout"},
+        # Window 2 was never analyzed (窗口2未分析)
+        result(3, "PLAYING", 0.7)
+    ]
+    
+    timeline = line_timeline(results, spans)
+    
+    assert [(e["state"], e["start_line"], e["end_line"], e["windows"]) for e in timeline["entries"]] == [
+        ("PLAYING", 0, 3, [0, 1]), ("UNKNOWN", 4, 6, [1, 1]), ("PLAYING", 9, 12, [3, 3])
+    ]
+    # No transition is claimed across unanalyzed lines 7-8
+    assert [(t["line"], t["from"], t["to"]) for t in timeline["transitions"]] == [(4, "PLAYING", "UNKNOWN")]
+
+
+def test_transition_timestamps():
+    """Test entries and transitions carry the timestamps of their lines."""
+    lines = [f"01-06 10:15:{i:02d}.000  1234  1235 D AudioFlinger: event {i}" for i in range(8)]
+    spans = LogChunker(chunk_size=4, overlap=0).window_spans(len(lines))
+    
+    timeline = line_timeline(
+        [result(0, "MUTED", 0.9), result(1, "PLAYING", 0.9)], spans,
+        timestamp_of=lambda n: lines[n][:18]
+    )
+    
+    assert timeline["entries"][1]["start_time"] == "01-06 10:15:04.000"
+    assert timeline["entries"][1]["end_time"] == "01-06 10:15:07.000"
+    assert timeline["transitions"][0]["time"] == "01-06 10:15:04.000"
+    assert timeline["entries"][0]["confidence"] == 0.9
+
+
+def test_source_line_numbers():
+    """Test filtered-line indices are mapped to log file line numbers."""
+    spans = LogChunker(chunk_size=4, overlap=0).window_spans(8)
+    # Every other source line was filtered out (每隔一行源行被过滤掉)
+    source_lines = [2 * n + 1 for n in range(8)]
+    
+    timeline = line_timeline(
+        [result(0, "MUTED", 0.9), result(1, "PLAYING", 0.9)], spans,
+        source_line_of=source_lines.__getitem__
+    )
+    
+    entry = timeline["entries"][1]
+    assert (entry["start_line"], entry["end_line"]) == (4, 7)
+    assert (entry["source_start_line"], entry["source_end_line"]) == (9, 15)
+    assert timeline["transitions"][0]["source_line"] == 9
+
+
+def test_matches_per_line_vote():
+    """Test the sweep gives every line the state a naive per-line weighted vote gives."""
+    rng = random.Random(3)
+    for _ in range(200):
+        chunk_size = rng.randrange(2, 12)
+        chunker = LogChunker(chunk_size=chunk_size, overlap=rng.randrange(0, chunk_size))
+        count = rng.randrange(0, 60)
+        spans = chunker.window_spans(count)
+        results = [
+            result(idx, rng.choice(STATES), rng.choice([0.0, 0.3, 0.5, 0.8, 0.95]))
+            for idx, _, _ in spans if rng.random() > 0.1
+        ]
+        rng.shuffle(results)
+        
+        timeline = line_timeline(results, spans)
+        
+        bounds = {idx: (start, end) for idx, start, end in spans}
+        for line, state in enumerate(states_per_line(timeline, count)):
+            voters = [r for r in results if bounds[r["window_idx"]][0] <= line < bounds[r["window_idx"]][1]]
+            if not voters:
+                assert state is None
+                continue
+            weights = {s: sum(r["confidence"] for r in voters if r["final_state"] == s) for s in STATES}
+            best = max(weights.values())
+            assert abs(weights[state] - best) < 1e-9
+            # Among equal weights a state someone voted for wins
+            assert any(r["final_state"] == state for r in voters)
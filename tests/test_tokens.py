@@ -0,0 +1,22 @@
+"""Tests for tokens module."""
+
+from src.tokens import estimate_tokens, estimate_lines_tokens
+
+
+def test_estimate_tokens_ascii():
+    """Test ASCII text estimates about four characters per token."""
+    assert estimate_tokens("") == 0
+    assert estimate_tokens("abcd") == 1
+    assert estimate_tokens("abcde") == 2
+
+
+def test_estimate_tokens_cjk():
+    """Test CJK characters count as one token each."""
+    assert estimate_tokens("音频状态") == 4
+    assert estimate_tokens("音频 abc") == 3
+
+
+def test_estimate_lines_tokens():
+    """Test newline tokens are added between lines."""
+    assert estimate_lines_tokens(["abcd", "abcd", "abcd"]) == 5
+    assert estimate_lines_tokens([]) == 0
@@ -0,0 +1,118 @@
+"""Tests for tracing module."""
+
+import json
+import threading
+from src.tracing import NULL_TRACER, Tracer
+
+
+def test_span_records_complete_event():
+    """Test a span becomes an X event with its args."""
+    tracer = Tracer()
+    
+    with tracer.span("parse_file", lines=10) as span_args:
+        span_args["kept"] = 4
+    
+    events = tracer.events()
+    assert len(events) == 1
+    assert events[0]["name"] == "parse_file"
+    assert events[0]["ph"] == "X"
+    assert events[0]["cat"] == "stage"
+    assert events[0]["dur"] >= 0
+    assert events[0]["args"] == {"lines": 10, "kept": 4}
+
+
+def test_span_recorded_when_block_raises():
+    """Test failing blocks still produce their span."""
+    tracer = Tracer()
+    
+    try:
+        with tracer.span("request", cat="request"):
+            raise ValueError("boom")
+    except ValueError:
+        pass
+    
+    assert [e["name"] for e in tracer.events()] == ["request"]
+
+
+def test_nested_spans_are_contained():
+    """Test inner spans lie within the outer span on the same thread."""
+    tracer = Tracer()
+    
+    with tracer.span("outer"):
+        with tracer.span("inner"):
+            pass
+    
+    outer, inner = tracer.events()
+    assert outer["tid"] == inner["tid"]
+    assert outer["ts"] <= inner["ts"]
+    assert inner["ts"] + inner["dur"] <= outer["ts"] + outer["dur"] + 0.2
+
+
+def test_threads_get_own_tracks():
+    """Test spans from different threads use different tids with names."""
+    tracer = Tracer()
+    
+    def work():
+        with tracer.span("window", cat="window"):
+            pass
+    
+    thread = threading.Thread(target=work, name="worker-1")
+    thread.start()
+    thread.join()
+    with tracer.span("main"):
+        pass
+    
+    assert len({e["tid"] for e in tracer.events()}) == 2
+    names = {e["args"]["name"] for e in tracer.to_chrome()["traceEvents"] if e["name"] == "thread_name"}
+    assert "worker-1" in names
+
+
+def test_add_span_and_counter():
+    """Test spans measured by the caller and counter events."""
+    tracer = Tracer()
+    start = tracer.now()
+    
+    tracer.add_span("ttfb", start, start + 0.5, "request")
+    tracer.counter("queues", mask=3, dispatch=1)
+    
+    span, counter = sorted(tracer.events(), key=lambda e: e["ph"])[::-1]
+    assert span["dur"] == 500000.0
+    assert counter["ph"] == "C"
+    assert counter["args"] == {"mask": 3, "dispatch": 1}
+
+
+def test_stage_totals():
+    """Test stage totals sum stage spans only."""
+    tracer = Tracer()
+    start = tracer.now()
+    tracer.add_span("mask_lines", start, start + 1.0)
+    tracer.add_span("mask_lines", start + 1.0, start + 1.5)
+    tracer.add_span("request", start, start + 2.0, "request")
+    
+    assert tracer.stage_totals() == {"mask_lines": 1.5}
+
+
+def test_disabled_tracer_records_nothing():
+    """Test the shared disabled tracer ignores everything."""
+    with NULL_TRACER.span("anything") as span_args:
+        span_args["x"] = 1
+    NULL_TRACER.add_span("ttfb", 0.0, 1.0)
+    NULL_TRACER.counter("queues", mask=1)
+    
+    assert NULL_TRACER.events() == []
+
+
+def test_write_chrome_trace(tmp_path):
+    """Test the written file is a Chrome trace object."""
+    tracer = Tracer()
+    with tracer.span("analyze"):
+        pass
+    
+    path = tmp_path / "nested" / "trace.json"
+    tracer.write(str(path))
+    
+    with open(path) as f:
+        trace = json.load(f)
+    assert trace["displayTimeUnit"] == "ms"
+    assert trace["traceEvents"][0]["name"] == "process_name"
+    assert any(e["name"] == "analyze" for e in trace["traceEvents"])
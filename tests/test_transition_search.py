@@ -0,0 +1,70 @@
+"""Tests for transition_search module."""
+
+from src.analyzer import WindowAnalyzer
+from src.transition_search import TransitionSearch, default_stride
+
+
+def make_analyze(transitions, calls):
+    def analyze(window_idx, window_lines):
+        calls.append(window_idx)
+        flips = sum(1 for t in transitions if window_idx >= t)
+        state = "PLAYING" if flips % 2 == 0 else "MUTED"
+        return {"window_idx": window_idx, "final_state": state, "confidence": 0.9,
+                "reason": state, "evidence": [f"line {window_idx}"], "next_actions": []}
+    return analyze
+
+
+def test_default_stride():
+    """Test the default stride is about the square root of the window count."""
+    assert default_stride(1) == 1
+    assert default_stride(2000) == 44
+
+
+def test_finds_exact_transitions_with_few_calls():
+    """Test a stable 2,000-window log with a handful of transitions needs O(k log n) calls."""
+    transitions = [300, 900, 1500, 1777]
+    calls = []
+    windows = [(i, [f"line {i}"]) for i in range(2000)]
+    
+    search = TransitionSearch(make_analyze(transitions, calls))
+    results = search.run(windows)
+    
+    assert len(calls) == search.calls
+    assert search.calls < 100
+    assert len(set(calls)) == len(calls)
+    
+    segments = WindowAnalyzer().merge_windows(results)
+    assert [(s.start_window, s.end_window) for s in segments] == [
+        (0, 299), (300, 899), (900, 1499), (1500, 1776), (1777, 1999)
+    ]
+    assert [s.state for s in segments] == ["PLAYING", "MUTED", "PLAYING", "MUTED", "PLAYING"]
+
+
+def test_inferred_windows_are_marked():
+    """Test unanalyzed windows copy the preceding sample and are marked inferred."""
+    calls = []
+    windows = [(i, []) for i in range(10)]
+    
+    results = TransitionSearch(make_analyze([], calls), stride=5).run(windows)
+    
+    assert calls == [0, 5, 9]
+    assert [r["window_idx"] for r in results] == list(range(10))
+    assert results[3]["inferred"] is True
+    assert results[3]["inferred_from"] == 0
+    assert results[7]["inferred_from"] == 5
+    assert "inferred" not in results[5]
+
+
+def test_concurrent_rounds_match_sequential():
+    """Test concurrent analysis within rounds gives the same results."""
+    windows = [(i, []) for i in range(200)]
+    sequential = TransitionSearch(make_analyze([37, 120], []), stride=16).run(windows)
+    concurrent = TransitionSearch(make_analyze([37, 120], []), stride=16, concurrency=4).run(windows)
+    
+    assert sequential == concurrent
+
+
+def test_empty_and_single_window():
+    """Test degenerate inputs."""
+    assert TransitionSearch(make_analyze([], [])).run([]) == []
+    assert len(TransitionSearch(make_analyze([], [])).run([(0, [])])) == 1